@@ -0,0 +1,620 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file arrow_interop.hpp
+ *
+ * Helpers to move Apache Arrow record batches into and out of Hyper. Requires the Arrow C++ library.
+ *
+ * An `Inserter` takes the values of a row one after the other, while Arrow stores the values of a column contiguously.
+ * `insertRecordBatch()` resolves the type of each column once per batch and then walks the batch row by row, reading
+ * the values straight from the Arrow buffers, so there is no type check and no intermediate value object per cell.
+ *
+ * In the other direction, `readArrowBatches()` turns each chunk of a query result into one record batch, appending
+ * the values of each column to an Arrow builder of the matching type.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_ARROW_INTEROP_HPP
+#define TABLEAU_HYPER_SAMPLES_ARROW_INTEROP_HPP
+
+#include "columnar_result.hpp"
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <hyperapi/hyperapi.hpp>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** Throws if `status` is an error. */
+inline void checkArrow(const arrow::Status& status) {
+   if (!status.ok()) {
+      throw std::runtime_error(status.ToString());
+   }
+}
+
+/** Returns the value of `result`, throws if it is an error. */
+template <class T>
+T getArrowValue(arrow::Result<T> result) {
+   checkArrow(result.status());
+   return std::move(result).ValueUnsafe();
+}
+
+/** Returns the SQL type values of the Arrow type `type` are inserted as. */
+inline hyperapi::SqlType getSqlType(const arrow::DataType& type) {
+   switch (type.id()) {
+      case arrow::Type::BOOL:
+         return hyperapi::SqlType::boolean();
+      case arrow::Type::INT8:
+      case arrow::Type::INT16:
+      case arrow::Type::UINT8:
+         return hyperapi::SqlType::smallInt();
+      case arrow::Type::INT32:
+      case arrow::Type::UINT16:
+         return hyperapi::SqlType::integer();
+      case arrow::Type::INT64:
+      case arrow::Type::UINT32:
+         return hyperapi::SqlType::bigInt();
+      case arrow::Type::UINT64:
+         return hyperapi::SqlType::numeric(20, 0);
+      case arrow::Type::HALF_FLOAT:
+      case arrow::Type::FLOAT:
+      case arrow::Type::DOUBLE:
+         return hyperapi::SqlType::doublePrecision();
+      case arrow::Type::DECIMAL128: {
+         const arrow::Decimal128Type& decimal = static_cast<const arrow::Decimal128Type&>(type);
+         return hyperapi::SqlType::numeric(static_cast<uint16_t>(decimal.precision()), static_cast<uint16_t>(decimal.scale()));
+      }
+      case arrow::Type::STRING:
+      case arrow::Type::LARGE_STRING:
+         return hyperapi::SqlType::text();
+      case arrow::Type::BINARY:
+      case arrow::Type::LARGE_BINARY:
+      case arrow::Type::FIXED_SIZE_BINARY:
+         return hyperapi::SqlType::bytes();
+      case arrow::Type::DATE32:
+      case arrow::Type::DATE64:
+         return hyperapi::SqlType::date();
+      case arrow::Type::TIME32:
+      case arrow::Type::TIME64:
+         return hyperapi::SqlType::time();
+      case arrow::Type::TIMESTAMP:
+         // Arrow timestamps with a time zone are instants, without one they are wall clock times.
+         return static_cast<const arrow::TimestampType&>(type).timezone().empty() ? hyperapi::SqlType::timestamp() : hyperapi::SqlType::timestampTZ();
+      case arrow::Type::DICTIONARY:
+         return getSqlType(*static_cast<const arrow::DictionaryType&>(type).value_type());
+      default:
+         throw std::runtime_error("The Arrow type " + type.ToString() + " has no corresponding SQL type");
+   }
+}
+
+/** Returns the definition of a table named `tableName` with one column per field of `schema`. */
+inline hyperapi::TableDefinition getTableDefinition(const arrow::Schema& schema, const hyperapi::TableName& tableName) {
+   hyperapi::TableDefinition table(tableName);
+   for (const std::shared_ptr<arrow::Field>& field : schema.fields()) {
+      table.addColumn(hyperapi::TableDefinition::Column{
+         field->name(), getSqlType(*field->type()), field->nullable() ? hyperapi::Nullability::Nullable : hyperapi::Nullability::NotNullable});
+   }
+   return table;
+}
+
+/**
+ * Returns the columns of an inserter that inserts Arrow data into `table`. Numerics need their precision and scale at
+ * compile time to be added to an inserter, so they are added as text and cast by the mappings of `getInserterMappings()`.
+ */
+inline std::vector<hyperapi::TableDefinition::Column> getInserterColumns(const hyperapi::TableDefinition& table) {
+   std::vector<hyperapi::TableDefinition::Column> columns;
+   for (const hyperapi::TableDefinition::Column& column : table.getColumns()) {
+      if (column.getType().getTag() == hyperapi::TypeTag::Numeric) {
+         columns.push_back(hyperapi::TableDefinition::Column{column.getName(), hyperapi::SqlType::text(), column.getNullability()});
+      } else {
+         columns.push_back(column);
+      }
+   }
+   return columns;
+}
+
+/** Returns the column mappings that go with `getInserterColumns()`. */
+inline std::vector<hyperapi::Inserter::ColumnMapping> getInserterMappings(const hyperapi::TableDefinition& table) {
+   std::vector<hyperapi::Inserter::ColumnMapping> mappings;
+   for (const hyperapi::TableDefinition::Column& column : table.getColumns()) {
+      if (column.getType().getTag() == hyperapi::TypeTag::Numeric) {
+         const std::string cast = "CAST(" + column.getName().toString() + " AS " + column.getType().toString() + ")";
+         mappings.push_back(hyperapi::Inserter::ColumnMapping{column.getName(), cast});
+      } else {
+         mappings.push_back(hyperapi::Inserter::ColumnMapping{column.getName()});
+      }
+   }
+   return mappings;
+}
+
+/** Returns the Arrow type values of the SQL type `type` are exported as. */
+inline std::shared_ptr<arrow::DataType> getArrowType(const hyperapi::SqlType& type) {
+   switch (type.getTag()) {
+      case hyperapi::TypeTag::Bool:
+         return arrow::boolean();
+      case hyperapi::TypeTag::SmallInt:
+         return arrow::int16();
+      case hyperapi::TypeTag::Int:
+         return arrow::int32();
+      case hyperapi::TypeTag::BigInt:
+         return arrow::int64();
+      case hyperapi::TypeTag::Oid:
+         return arrow::uint32();
+      case hyperapi::TypeTag::Double:
+         return arrow::float64();
+      case hyperapi::TypeTag::Text:
+      case hyperapi::TypeTag::Varchar:
+      case hyperapi::TypeTag::Char:
+      case hyperapi::TypeTag::Json:
+         return arrow::utf8();
+      case hyperapi::TypeTag::Bytes:
+         return arrow::binary();
+      case hyperapi::TypeTag::Date:
+         return arrow::date32();
+      case hyperapi::TypeTag::Time:
+         return arrow::time64(arrow::TimeUnit::MICRO);
+      case hyperapi::TypeTag::Timestamp:
+         return arrow::timestamp(arrow::TimeUnit::MICRO);
+      case hyperapi::TypeTag::TimestampTZ:
+         return arrow::timestamp(arrow::TimeUnit::MICRO, "UTC");
+      default:
+         // Numerics need their precision at compile time to be read, so they are best cast to double precision in the query.
+         throw std::runtime_error("The SQL type " + type.toString() + " cannot be exported to Arrow");
+   }
+}
+
+/** Returns the Arrow schema of a query result with `schema`. Result columns do not know whether they can be NULL. */
+inline std::shared_ptr<arrow::Schema> getArrowSchema(const hyperapi::ResultSchema& schema) {
+   arrow::FieldVector fields;
+   for (size_t i = 0; i < schema.getColumnCount(); ++i) {
+      fields.push_back(arrow::field(schema.getColumn(i).getName().getUnescaped(), getArrowType(schema.getColumn(i).getType())));
+   }
+   return arrow::schema(fields);
+}
+
+namespace detail {
+/** Helper function returning the date `days` days after 1970-01-01 */
+inline hyperapi::Date getDateFromUnixDays(int64_t days) {
+   // Converts the days to a civil date in the proleptic Gregorian calendar, counting in eras of 400 years.
+   days += 719468;
+   const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+   const int64_t dayOfEra = days - era * 146097;
+   const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+   const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+   const int64_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+   const int64_t day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+   const int64_t month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+   const int64_t year = yearOfEra + era * 400 + (month <= 2);
+   return hyperapi::Date{static_cast<int32_t>(year), static_cast<int16_t>(month), static_cast<int16_t>(day)};
+}
+
+/** Helper function returning the time of day `microseconds` after midnight */
+inline hyperapi::Time getTimeFromMicroseconds(int64_t microseconds) {
+   return hyperapi::Time{
+      static_cast<int8_t>(microseconds / 3600000000), static_cast<int8_t>(microseconds / 60000000 % 60), static_cast<int8_t>(microseconds / 1000000 % 60),
+      static_cast<int32_t>(microseconds % 1000000)};
+}
+
+/** Helper function returning the timestamp `microseconds` after 1970-01-01 00:00 */
+inline hyperapi::Timestamp getTimestampFromUnixMicroseconds(int64_t microseconds) {
+   const int64_t microsecondsPerDay = 86400000000;
+   int64_t days = microseconds / microsecondsPerDay;
+   int64_t timeOfDay = microseconds % microsecondsPerDay;
+   if (timeOfDay < 0) {
+      --days;
+      timeOfDay += microsecondsPerDay;
+   }
+   return hyperapi::Timestamp(getDateFromUnixDays(days), getTimeFromMicroseconds(timeOfDay));
+}
+
+/** Helper function returning the number of microseconds in one `unit` */
+inline int64_t getMicrosecondsPerUnit(arrow::TimeUnit::type unit) {
+   switch (unit) {
+      case arrow::TimeUnit::SECOND:
+         return 1000000;
+      case arrow::TimeUnit::MILLI:
+         return 1000;
+      default:
+         return 1;
+   }
+}
+
+/** Helper function converting a value of `unit` to microseconds. Nanoseconds are truncated, as Hyper stores microseconds. */
+inline int64_t toMicroseconds(int64_t value, arrow::TimeUnit::type unit) {
+   return (unit == arrow::TimeUnit::NANO) ? value / 1000 : value * getMicrosecondsPerUnit(unit);
+}
+
+/** Helper function returning the value of the IEEE half precision float `bits` */
+inline double getDoubleFromHalfFloat(uint16_t bits) {
+   const int exponent = (bits >> 10) & 0x1F;
+   const int mantissa = bits & 0x3FF;
+   double magnitude;
+   if (exponent == 0) {
+      magnitude = std::ldexp(mantissa, -24);
+   } else if (exponent == 0x1F) {
+      magnitude = mantissa ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+   } else {
+      magnitude = std::ldexp(mantissa + 1024, exponent - 25);
+   }
+   return (bits & 0x8000) ? -magnitude : magnitude;
+}
+
+/** Adds the values of one column of a record batch to an inserter. */
+class ArrowColumnAdder {
+   public:
+   virtual ~ArrowColumnAdder() = default;
+   virtual void add(hyperapi::Inserter& inserter, int64_t row) const = 0;
+};
+
+/** Adds the values of an array of type `ArrayType`, converted with `Convert`. */
+template <class ArrayType, class Convert>
+class TypedArrowColumnAdder : public ArrowColumnAdder {
+   public:
+   TypedArrowColumnAdder(const arrow::Array& array, Convert convert) : array(static_cast<const ArrayType&>(array)), convert(convert) {}
+
+   void add(hyperapi::Inserter& inserter, int64_t row) const override {
+      if (array.IsNull(row)) {
+         inserter.add(hyperapi::null);
+      } else {
+         inserter.add(convert(array, row));
+      }
+   }
+
+   private:
+   const ArrayType& array;
+   Convert convert;
+};
+
+template <class ArrayType, class Convert>
+std::unique_ptr<ArrowColumnAdder> makeAdder(const arrow::Array& array, Convert convert) {
+   return std::unique_ptr<ArrowColumnAdder>(new TypedArrowColumnAdder<ArrayType, Convert>(array, convert));
+}
+
+/** Integers are converted to the integer type of the target column, so a narrower Arrow type can be inserted as well. */
+template <class ArrayType>
+std::unique_ptr<ArrowColumnAdder> makeIntegerAdder(const arrow::Array& array, hyperapi::TypeTag target) {
+   switch (target) {
+      case hyperapi::TypeTag::SmallInt:
+         return makeAdder<ArrayType>(array, [](const ArrayType& values, int64_t row) { return static_cast<int16_t>(values.Value(row)); });
+      case hyperapi::TypeTag::Int:
+         return makeAdder<ArrayType>(array, [](const ArrayType& values, int64_t row) { return static_cast<int32_t>(values.Value(row)); });
+      case hyperapi::TypeTag::Double:
+         return makeAdder<ArrayType>(array, [](const ArrayType& values, int64_t row) { return static_cast<double>(values.Value(row)); });
+      default:
+         return makeAdder<ArrayType>(array, [](const ArrayType& values, int64_t row) { return static_cast<int64_t>(values.Value(row)); });
+   }
+}
+
+/** Text is passed as views into the Arrow buffers, binary data as byte spans. */
+template <class ArrayType>
+std::unique_ptr<ArrowColumnAdder> makeBinaryAdder(const arrow::Array& array, hyperapi::TypeTag target) {
+   if (target == hyperapi::TypeTag::Bytes) {
+      return makeAdder<ArrayType>(array, [](const ArrayType& values, int64_t row) {
+         auto view = values.GetView(row);
+         return hyperapi::ByteSpan{reinterpret_cast<const uint8_t*>(view.data()), view.size()};
+      });
+   }
+   return makeAdder<ArrayType>(array, [](const ArrayType& values, int64_t row) {
+      auto view = values.GetView(row);
+      return hyperapi::string_view(view.data(), view.size());
+   });
+}
+
+/** Adds the values of a dictionary encoded array by looking up each index in the dictionary. */
+class DictionaryArrowColumnAdder : public ArrowColumnAdder {
+   public:
+   DictionaryArrowColumnAdder(const arrow::DictionaryArray& array, std::unique_ptr<ArrowColumnAdder> dictionaryAdder)
+       : array(array), dictionaryAdder(std::move(dictionaryAdder)) {}
+
+   void add(hyperapi::Inserter& inserter, int64_t row) const override {
+      if (array.IsNull(row)) {
+         inserter.add(hyperapi::null);
+      } else {
+         dictionaryAdder->add(inserter, array.GetValueIndex(row));
+      }
+   }
+
+   private:
+   const arrow::DictionaryArray& array;
+   std::unique_ptr<ArrowColumnAdder> dictionaryAdder;
+};
+
+/** Returns the adder for `array`, which is inserted into `column`. */
+inline std::unique_ptr<ArrowColumnAdder> makeColumnAdder(const arrow::Array& array, const hyperapi::TableDefinition::Column& column) {
+   const hyperapi::TypeTag target = column.getType().getTag();
+   switch (array.type_id()) {
+      case arrow::Type::DICTIONARY: {
+         const arrow::DictionaryArray& dictionaryArray = static_cast<const arrow::DictionaryArray&>(array);
+         return std::unique_ptr<ArrowColumnAdder>(new DictionaryArrowColumnAdder(dictionaryArray, makeColumnAdder(*dictionaryArray.dictionary(), column)));
+      }
+      case arrow::Type::BOOL:
+         return makeAdder<arrow::BooleanArray>(array, [](const arrow::BooleanArray& values, int64_t row) { return values.Value(row); });
+      case arrow::Type::INT8:
+         return makeIntegerAdder<arrow::Int8Array>(array, target);
+      case arrow::Type::INT16:
+         return makeIntegerAdder<arrow::Int16Array>(array, target);
+      case arrow::Type::INT32:
+         return makeIntegerAdder<arrow::Int32Array>(array, target);
+      case arrow::Type::INT64:
+         return makeIntegerAdder<arrow::Int64Array>(array, target);
+      case arrow::Type::UINT8:
+         return makeIntegerAdder<arrow::UInt8Array>(array, target);
+      case arrow::Type::UINT16:
+         return makeIntegerAdder<arrow::UInt16Array>(array, target);
+      case arrow::Type::UINT32:
+         return makeIntegerAdder<arrow::UInt32Array>(array, target);
+      case arrow::Type::UINT64:
+         if (target == hyperapi::TypeTag::Text) {
+            // The values may exceed BIGINT, so they are added as text for a NUMERIC(20, 0) column, see `getInserterColumns()`.
+            return makeAdder<arrow::UInt64Array>(
+               array, [](const arrow::UInt64Array& values, int64_t row) { return std::to_string(values.Value(row)); });
+         }
+         return makeIntegerAdder<arrow::UInt64Array>(array, target);
+      case arrow::Type::DECIMAL128:
+         if (target == hyperapi::TypeTag::Double) {
+            return makeAdder<arrow::Decimal128Array>(
+               array, [](const arrow::Decimal128Array& values, int64_t row) { return std::stod(values.FormatValue(row)); });
+         }
+         // Added as text for a NUMERIC column, see `getInserterColumns()`. The text has as many decimal places as the scale.
+         return makeAdder<arrow::Decimal128Array>(array, [](const arrow::Decimal128Array& values, int64_t row) { return values.FormatValue(row); });
+      case arrow::Type::HALF_FLOAT:
+         return makeAdder<arrow::HalfFloatArray>(
+            array, [](const arrow::HalfFloatArray& values, int64_t row) { return getDoubleFromHalfFloat(values.Value(row)); });
+      case arrow::Type::FLOAT:
+         return makeAdder<arrow::FloatArray>(array, [](const arrow::FloatArray& values, int64_t row) { return static_cast<double>(values.Value(row)); });
+      case arrow::Type::DOUBLE:
+         return makeAdder<arrow::DoubleArray>(array, [](const arrow::DoubleArray& values, int64_t row) { return values.Value(row); });
+      case arrow::Type::STRING:
+         return makeBinaryAdder<arrow::StringArray>(array, target);
+      case arrow::Type::LARGE_STRING:
+         return makeBinaryAdder<arrow::LargeStringArray>(array, target);
+      case arrow::Type::BINARY:
+         return makeBinaryAdder<arrow::BinaryArray>(array, target);
+      case arrow::Type::LARGE_BINARY:
+         return makeBinaryAdder<arrow::LargeBinaryArray>(array, target);
+      case arrow::Type::FIXED_SIZE_BINARY:
+         return makeBinaryAdder<arrow::FixedSizeBinaryArray>(array, target);
+      case arrow::Type::DATE32:
+         return makeAdder<arrow::Date32Array>(array, [](const arrow::Date32Array& values, int64_t row) { return getDateFromUnixDays(values.Value(row)); });
+      case arrow::Type::DATE64:
+         return makeAdder<arrow::Date64Array>(
+            array, [](const arrow::Date64Array& values, int64_t row) { return getDateFromUnixDays(values.Value(row) / 86400000); });
+      case arrow::Type::TIME32: {
+         const int64_t factor = getMicrosecondsPerUnit(static_cast<const arrow::Time32Type&>(*array.type()).unit());
+         return makeAdder<arrow::Time32Array>(
+            array, [factor](const arrow::Time32Array& values, int64_t row) { return getTimeFromMicroseconds(values.Value(row) * factor); });
+      }
+      case arrow::Type::TIME64: {
+         const arrow::TimeUnit::type unit = static_cast<const arrow::Time64Type&>(*array.type()).unit();
+         return makeAdder<arrow::Time64Array>(
+            array, [unit](const arrow::Time64Array& values, int64_t row) { return getTimeFromMicroseconds(toMicroseconds(values.Value(row), unit)); });
+      }
+      case arrow::Type::TIMESTAMP: {
+         const arrow::TimeUnit::type unit = static_cast<const arrow::TimestampType&>(*array.type()).unit();
+         if (target == hyperapi::TypeTag::TimestampTZ) {
+            // Arrow stores timestamps with a time zone in UTC.
+            return makeAdder<arrow::TimestampArray>(array, [unit](const arrow::TimestampArray& values, int64_t row) {
+               hyperapi::Timestamp timestamp = getTimestampFromUnixMicroseconds(toMicroseconds(values.Value(row), unit));
+               return hyperapi::OffsetTimestamp(timestamp.getDate(), timestamp.getTime(), std::chrono::minutes(0));
+            });
+         }
+         return makeAdder<arrow::TimestampArray>(array, [unit](const arrow::TimestampArray& values, int64_t row) {
+            return getTimestampFromUnixMicroseconds(toMicroseconds(values.Value(row), unit));
+         });
+      }
+      default:
+         throw std::runtime_error(
+            "The column " + column.getName().toString() + " has the Arrow type " + array.type()->ToString() + ", which cannot be inserted");
+   }
+}
+}
+
+/**
+ * Inserts the rows of `batch` with `inserter`, whose columns are `columns`. The batch must have one column per
+ * inserter column, in the same order.
+ */
+inline int64_t insertRecordBatch(hyperapi::Inserter& inserter, const arrow::RecordBatch& batch, const std::vector<hyperapi::TableDefinition::Column>& columns) {
+   if (static_cast<size_t>(batch.num_columns()) != columns.size()) {
+      throw std::runtime_error(
+         "The record batch has " + std::to_string(batch.num_columns()) + " columns, but the inserter expects " + std::to_string(columns.size()));
+   }
+   // The adders refer to the arrays, so they are kept alive for the whole batch.
+   std::vector<std::shared_ptr<arrow::Array>> arrays;
+   std::vector<std::unique_ptr<detail::ArrowColumnAdder>> adders;
+   for (int i = 0; i < batch.num_columns(); ++i) {
+      arrays.push_back(batch.column(i));
+      adders.push_back(detail::makeColumnAdder(*arrays.back(), columns[static_cast<size_t>(i)]));
+   }
+   for (int64_t row = 0; row < batch.num_rows(); ++row) {
+      for (const std::unique_ptr<detail::ArrowColumnAdder>& adder : adders) {
+         adder->add(inserter, row);
+      }
+      inserter.endRow();
+   }
+   return batch.num_rows();
+}
+
+/**
+ * Inserts the record batches of `reader` with `inserter`, one after the other.
+ */
+inline int64_t insertRecordBatches(
+   hyperapi::Inserter& inserter, arrow::RecordBatchReader& reader, const std::vector<hyperapi::TableDefinition::Column>& columns) {
+   int64_t rowCount = 0;
+   std::shared_ptr<arrow::RecordBatch> batch;
+   while (true) {
+      checkArrow(reader.ReadNext(&batch));
+      if (!batch) {
+         return rowCount;
+      }
+      rowCount += insertRecordBatch(inserter, *batch, columns);
+   }
+}
+
+/**
+ * Inserts the record batches of the Arrow IPC file `reader` with `inserter`. Unlike a stream, a file knows where its
+ * batches are, so each one is read only when it is inserted.
+ */
+inline int64_t insertRecordBatches(
+   hyperapi::Inserter& inserter, arrow::ipc::RecordBatchFileReader& reader, const std::vector<hyperapi::TableDefinition::Column>& columns) {
+   int64_t rowCount = 0;
+   for (int i = 0; i < reader.num_record_batches(); ++i) {
+      rowCount += insertRecordBatch(inserter, *getArrowValue(reader.ReadRecordBatch(i)), columns);
+   }
+   return rowCount;
+}
+
+/**
+ * Inserts the rows of `table` with `inserter`, one record batch after the other.
+ */
+inline int64_t insertArrowTable(hyperapi::Inserter& inserter, const arrow::Table& table, const std::vector<hyperapi::TableDefinition::Column>& columns) {
+   arrow::TableBatchReader reader(table);
+   return insertRecordBatches(inserter, reader, columns);
+}
+
+/** Opens the Arrow IPC file, also known as Feather version 2, at `path`. */
+inline std::shared_ptr<arrow::ipc::RecordBatchFileReader> openArrowIpcFile(const std::string& path) {
+   return getArrowValue(arrow::ipc::RecordBatchFileReader::Open(getArrowValue(arrow::io::ReadableFile::Open(path))));
+}
+
+/** Opens the Arrow IPC stream at `path`. */
+inline std::shared_ptr<arrow::ipc::RecordBatchStreamReader> openArrowIpcStream(const std::string& path) {
+   return getArrowValue(arrow::ipc::RecordBatchStreamReader::Open(getArrowValue(arrow::io::ReadableFile::Open(path))));
+}
+
+namespace detail {
+/** Appends the values of one column of a query result to an Arrow builder. */
+class ArrowColumnAppender {
+   public:
+   virtual ~ArrowColumnAppender() = default;
+   virtual void append(const hyperapi::Row& row, size_t column) = 0;
+   virtual std::shared_ptr<arrow::Array> finish() = 0;
+};
+
+/** Appends values read as `T` to a builder of type `BuilderType`, with `Append`. */
+template <class T, class BuilderType, class Append>
+class TypedArrowColumnAppender : public ArrowColumnAppender {
+   public:
+   TypedArrowColumnAppender(const std::shared_ptr<arrow::DataType>& type, Append appendValue)
+       : builder(type, arrow::default_memory_pool()), appendValue(appendValue) {}
+
+   void append(const hyperapi::Row& row, size_t column) override {
+      hyperapi::optional<T> value = row.get<hyperapi::optional<T>>(column);
+      if (value) {
+         checkArrow(appendValue(builder, *value));
+      } else {
+         checkArrow(builder.AppendNull());
+      }
+   }
+
+   std::shared_ptr<arrow::Array> finish() override { return getArrowValue(builder.Finish()); }
+
+   private:
+   BuilderType builder;
+   Append appendValue;
+};
+
+template <class T, class BuilderType, class Append>
+std::unique_ptr<ArrowColumnAppender> makeAppender(const std::shared_ptr<arrow::DataType>& type, Append appendValue) {
+   return std::unique_ptr<ArrowColumnAppender>(new TypedArrowColumnAppender<T, BuilderType, Append>(type, appendValue));
+}
+
+/** Returns the appender for a result column of `type`, whose values are exported as `arrowType`. */
+inline std::unique_ptr<ArrowColumnAppender> makeColumnAppender(const hyperapi::SqlType& type, const std::shared_ptr<arrow::DataType>& arrowType) {
+   switch (type.getTag()) {
+      case hyperapi::TypeTag::Bool:
+         return makeAppender<bool, arrow::BooleanBuilder>(arrowType, [](arrow::BooleanBuilder& builder, bool value) { return builder.Append(value); });
+      case hyperapi::TypeTag::SmallInt:
+         return makeAppender<int16_t, arrow::Int16Builder>(arrowType, [](arrow::Int16Builder& builder, int16_t value) { return builder.Append(value); });
+      case hyperapi::TypeTag::Int:
+         return makeAppender<int32_t, arrow::Int32Builder>(arrowType, [](arrow::Int32Builder& builder, int32_t value) { return builder.Append(value); });
+      case hyperapi::TypeTag::BigInt:
+         return makeAppender<int64_t, arrow::Int64Builder>(arrowType, [](arrow::Int64Builder& builder, int64_t value) { return builder.Append(value); });
+      case hyperapi::TypeTag::Oid:
+         return makeAppender<uint32_t, arrow::UInt32Builder>(
+            arrowType, [](arrow::UInt32Builder& builder, uint32_t value) { return builder.Append(value); });
+      case hyperapi::TypeTag::Double:
+         return makeAppender<double, arrow::DoubleBuilder>(arrowType, [](arrow::DoubleBuilder& builder, double value) { return builder.Append(value); });
+      case hyperapi::TypeTag::Text:
+      case hyperapi::TypeTag::Varchar:
+      case hyperapi::TypeTag::Char:
+      case hyperapi::TypeTag::Json:
+         // The views point into the result chunk, the builder copies them.
+         return makeAppender<hyperapi::string_view, arrow::StringBuilder>(arrowType, [](arrow::StringBuilder& builder, hyperapi::string_view value) {
+            return builder.Append(value.data(), static_cast<int32_t>(value.size()));
+         });
+      case hyperapi::TypeTag::Bytes:
+         return makeAppender<hyperapi::ByteSpan, arrow::BinaryBuilder>(arrowType, [](arrow::BinaryBuilder& builder, hyperapi::ByteSpan value) {
+            return builder.Append(value.data, static_cast<int32_t>(value.size));
+         });
+      case hyperapi::TypeTag::Date:
+         return makeAppender<hyperapi::Date, arrow::Date32Builder>(
+            arrowType, [](arrow::Date32Builder& builder, const hyperapi::Date& value) { return builder.Append(getUnixDays(value)); });
+      case hyperapi::TypeTag::Time:
+         return makeAppender<hyperapi::Time, arrow::Time64Builder>(
+            arrowType, [](arrow::Time64Builder& builder, const hyperapi::Time& value) { return builder.Append(getMicroseconds(value)); });
+      case hyperapi::TypeTag::Timestamp:
+         return makeAppender<hyperapi::Timestamp, arrow::TimestampBuilder>(arrowType, [](arrow::TimestampBuilder& builder, const hyperapi::Timestamp& value) {
+            return builder.Append(getUnixMicroseconds(value.getDate(), value.getTime()));
+         });
+      case hyperapi::TypeTag::TimestampTZ:
+         return makeAppender<hyperapi::OffsetTimestamp, arrow::TimestampBuilder>(
+            arrowType, [](arrow::TimestampBuilder& builder, const hyperapi::OffsetTimestamp& value) {
+               // Arrow stores the instant in UTC.
+               return builder.Append(getUnixMicroseconds(value));
+            });
+      default:
+         throw std::runtime_error("The SQL type " + type.toString() + " cannot be exported to Arrow");
+   }
+}
+}
+
+/**
+ * Reads `result` chunk by chunk and calls `processBatch(batch)` with each chunk as an Arrow record batch. The batches
+ * own their values, so they can be kept after the result has moved on. Returns the number of rows read.
+ */
+template <class Function>
+int64_t readArrowBatches(hyperapi::Result& result, Function&& processBatch) {
+   const hyperapi::ResultSchema& resultSchema = result.getSchema();
+   const std::shared_ptr<arrow::Schema> schema = getArrowSchema(resultSchema);
+   int64_t rowCount = 0;
+   for (const hyperapi::Chunk& chunk : hyperapi::Chunks(result)) {
+      // Builders cannot be reused after `Finish()`, so each chunk gets new ones.
+      std::vector<std::unique_ptr<detail::ArrowColumnAppender>> appenders;
+      for (size_t i = 0; i < resultSchema.getColumnCount(); ++i) {
+         appenders.push_back(detail::makeColumnAppender(resultSchema.getColumn(i).getType(), schema->field(static_cast<int>(i))->type()));
+      }
+      for (const hyperapi::Row& row : chunk) {
+         for (size_t i = 0; i < appenders.size(); ++i) {
+            appenders[i]->append(row, i);
+         }
+      }
+      arrow::ArrayVector columns;
+      for (const std::unique_ptr<detail::ArrowColumnAppender>& appender : appenders) {
+         columns.push_back(appender->finish());
+      }
+      processBatch(arrow::RecordBatch::Make(schema, static_cast<int64_t>(chunk.getRowCount()), columns));
+      rowCount += static_cast<int64_t>(chunk.getRowCount());
+   }
+   return rowCount;
+}
+}
+
+#endif
@@ -0,0 +1,180 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example benchmark_clustered_range_queries.cpp
+ *
+ * An example of how to insert rows clustered by a date column, so range filters on that column read fewer blocks.
+ * The same orders are inserted once in the order of the file and once sorted by "Order Date" with an external merge
+ * sort, which spills to temporary files as the orders exceed its memory budget. Then range queries on the order date
+ * are timed on both tables.
+ */
+
+#include "external_sort.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Helper function formatting the date in `field` shifted by `years` as `YYYY-MM-DD`
+ */
+static std::string shiftDate(const std::string& field, int years) {
+   if (field.empty()) {
+      return field;
+   }
+   hyperapi::Date date = samples::parseCsvDate(field);
+   char shifted[16];
+   std::snprintf(shifted, sizeof(shifted), "%04d-%02d-%02d", date.getYear() + years, static_cast<int>(date.getMonth()), static_cast<int>(date.getDay()));
+   return shifted;
+}
+
+/**
+ * Writes the orders `repetitions` times to `destinationPath`, in the order in which they might arrive from a source
+ * system: every repetition covers all years, shifted by a multiple of four years so leap days stay valid.
+ */
+static void writeOrdersInArrivalOrder(const std::string& sourcePath, const std::string& destinationPath, int repetitions) {
+   std::ofstream destination(destinationPath, std::ios::binary);
+   if (!destination) {
+      throw std::runtime_error("Could not create " + destinationPath);
+   }
+   destination << "Address ID,Customer ID,Order Date,Order ID,Ship Date,Ship Mode\n";
+   std::vector<std::string> fields;
+   for (int repetition = 0; repetition < repetitions; ++repetition) {
+      samples::CsvReader source(sourcePath);
+      source.skipLine();
+      const int years = (repetition % 10) * 4;
+      while (source.readRecord(fields)) {
+         destination << fields[0] << ',' << fields[1] << ',' << shiftDate(fields[2], years) << ',' << fields[3] << '-' << repetition << ','
+                     << shiftDate(fields[4], years) << ',' << fields[5] << '\n';
+      }
+   }
+}
+
+/**
+ * Inserts the CSV file at `path` into a new table named `tableName` and prints how long it took.
+ */
+static void loadOrders(hyperapi::Connection& connection, const std::string& path, const std::string& tableName, const samples::CsvInsertOptions& options) {
+   hyperapi::TableDefinition table = samples::ordersTable;
+   table.setTableName(hyperapi::TableName(tableName));
+   samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(table); });
+   auto start = std::chrono::steady_clock::now();
+   samples::ExternalSortStatistics statistics = samples::insertCsv(connection, table, path, options);
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   std::cout << "Inserted " << statistics.recordCount << " rows into " << table.getTableName() << " in " << seconds << " s ("
+             << static_cast<int64_t>(statistics.recordCount / seconds) << " rows/s)";
+   if (!options.clusteringColumn.empty()) {
+      std::cout << ", sorted in " << statistics.runCount << " runs with " << statistics.spilledBytes / (1024 * 1024) << " MB spilled: "
+                << statistics.runSeconds << " s to sort the runs, " << statistics.mergeSeconds << " s to merge and insert";
+   }
+   std::cout << "." << std::endl;
+}
+
+/**
+ * Runs `query` `runCount` times and returns the fastest time in milliseconds and the result.
+ */
+static double measureQuery(hyperapi::Connection& connection, const std::string& query, int runCount, int64_t& result) {
+   double bestMilliseconds = 0;
+   for (int run = 0; run < runCount; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      result = connection.executeScalarQuery<int64_t>(query);
+      double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      bestMilliseconds = (run == 0) ? milliseconds : std::min(bestMilliseconds, milliseconds);
+   }
+   return bestMilliseconds;
+}
+
+static void runBenchmarkClusteredRangeQueries(int repetitions, size_t memoryBudget) {
+   std::cout << "EXAMPLE - Insert rows clustered by a date and compare range queries" << std::endl;
+   const std::string pathToDatabase = "data/clustered_range_queries.hyper";
+   const std::string pathToOrders = "data/orders_arrival_order.csv";
+   const int runCount = 5;
+
+   writeOrdersInArrivalOrder("data/orders.csv", pathToOrders, repetitions);
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "clustered_range_queries.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+
+         samples::CsvInsertOptions arrivalOrder;
+         loadOrders(connection, pathToOrders, "Orders Arrival Order", arrivalOrder);
+         samples::CsvInsertOptions clustered;
+         clustered.clusteringColumn = "Order Date";
+         clustered.sort.memoryBudget = memoryBudget;
+         loadOrders(connection, pathToOrders, "Orders Clustered", clustered);
+
+         // Ranges of a day, a month, and a year. The orders span 40 years.
+         const std::vector<std::pair<std::string, std::string>> ranges = {
+            {"2013-03-18", "2013-03-18"}, {"2021-06-01", "2021-06-30"}, {"2038-01-01", "2038-12-31"}};
+         std::cout << "Fastest of " << runCount << " runs:" << std::endl;
+         samples::PhaseTimer queryTimer(samples::Phase::Query);
+         for (const std::pair<std::string, std::string>& range : ranges) {
+            const std::string filter = " WHERE " + hyperapi::escapeName("Order Date") + " BETWEEN DATE " + hyperapi::escapeStringLiteral(range.first) +
+                                       " AND DATE " + hyperapi::escapeStringLiteral(range.second);
+            int64_t arrivalOrderRows = 0, clusteredRows = 0;
+            double arrivalOrderMilliseconds = measureQuery(
+               connection, "SELECT COUNT(*) FROM " + hyperapi::escapeName("Orders Arrival Order") + filter, runCount, arrivalOrderRows);
+            double clusteredMilliseconds =
+               measureQuery(connection, "SELECT COUNT(*) FROM " + hyperapi::escapeName("Orders Clustered") + filter, runCount, clusteredRows);
+            if (arrivalOrderRows != clusteredRows) {
+               throw std::runtime_error("The tables returned different rows for " + range.first + " to " + range.second);
+            }
+            std::cout << "  " << range.first << " to " << range.second << " (" << clusteredRows << " rows): " << arrivalOrderMilliseconds
+                      << " ms in arrival order, " << clusteredMilliseconds << " ms clustered" << std::endl;
+         }
+         queryTimer.stop();
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+   std::remove(pathToOrders.c_str());
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of times the orders are repeated and the memory budget of the sort in MB can be passed on
+   // the command line. The default budget is small enough for the sort to spill.
+   int repetitions = (arguments.size() > 0) ? std::atoi(arguments[0].c_str()) : 100;
+   size_t memoryBudget = static_cast<size_t>((arguments.size() > 1) ? std::atoi(arguments[1].c_str()) : 8) << 20;
+   try {
+      runBenchmarkClusteredRangeQueries(repetitions, memoryBudget);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,266 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example benchmark_columnar_result_reads.cpp
+ *
+ * An example of how to read a query result into column buffers for analytics code, compared with iterating over the
+ * rows and their `Value`s. Both variants compute the same digest of every column, the columnar variant in one tight
+ * loop per column and chunk.
+ */
+
+#include "columnar_result.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A digest of the values of one column, used to check that both variants saw the same values.
+ *
+ * The query has no ORDER BY and Hyper may scan the table in parallel, so the rows can arrive in a different order in
+ * every run. The digest therefore adds up a hash of every value, which does not depend on the order of the values.
+ */
+class ColumnDigest {
+   public:
+   void addNull() { ++nullCount; }
+   void add(int64_t value) { addHash(static_cast<uint64_t>(value)); }
+   void add(double value) {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      addHash(bits);
+   }
+   void add(hyperapi::string_view value) {
+      uint64_t hash = 14695981039346656037ull;
+      for (size_t i = 0; i < value.size(); ++i) {
+         hash = (hash ^ static_cast<unsigned char>(value.data()[i])) * 1099511628211ull;
+      }
+      addHash(hash);
+   }
+
+   bool operator==(const ColumnDigest& other) const { return (nullCount == other.nullCount) && (hashSum == other.hashSum); }
+   bool operator!=(const ColumnDigest& other) const { return !(*this == other); }
+
+   private:
+   /** Mixes the bits of `value` (the finalizer of SplitMix64), so the sum of similar values does not collide easily. */
+   void addHash(uint64_t value) {
+      value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+      value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+      hashSum += value ^ (value >> 31);
+   }
+
+   int64_t nullCount = 0;
+   /// Unsigned, so the sum wraps around instead of overflowing.
+   uint64_t hashSum = 0;
+};
+
+/**
+ * Reads `query` row by row and each row value by value, dispatching on the type of every value.
+ */
+static std::vector<ColumnDigest> readValues(hyperapi::Connection& connection, const std::string& query, int64_t& rowCount) {
+   hyperapi::Result result = connection.executeQuery(query);
+   const hyperapi::ResultSchema& schema = result.getSchema();
+   std::vector<ColumnDigest> digests(schema.getColumnCount());
+   rowCount = 0;
+   for (const hyperapi::Row& row : result) {
+      size_t column = 0;
+      for (const hyperapi::Value& value : row) {
+         ColumnDigest& digest = digests[column];
+         if (value.isNull()) {
+            digest.addNull();
+         } else {
+            switch (schema.getColumn(column).getType().getTag()) {
+               case hyperapi::TypeTag::SmallInt:
+                  digest.add(static_cast<int64_t>(value.get<int16_t>()));
+                  break;
+               case hyperapi::TypeTag::Int:
+                  digest.add(static_cast<int64_t>(value.get<int32_t>()));
+                  break;
+               case hyperapi::TypeTag::BigInt:
+                  digest.add(value.get<int64_t>());
+                  break;
+               case hyperapi::TypeTag::Double:
+                  digest.add(value.get<double>());
+                  break;
+               case hyperapi::TypeTag::Date:
+                  digest.add(static_cast<int64_t>(samples::detail::getUnixDays(value.get<hyperapi::Date>())));
+                  break;
+               case hyperapi::TypeTag::Text:
+                  digest.add(value.get<hyperapi::string_view>());
+                  break;
+               default:
+                  throw std::runtime_error("Unexpected type " + schema.getColumn(column).getType().toString());
+            }
+         }
+         ++column;
+      }
+      ++rowCount;
+   }
+   return digests;
+}
+
+/**
+ * Helper function adding the fixed-width values of type `T` in `column` to `digest`
+ */
+template <class T>
+static void addValues(ColumnDigest& digest, const samples::ColumnarColumn& column, size_t rowCount) {
+   // Integers are added as `int64_t` and floating-point values as `double`, like in `readValues()`.
+   typedef typename std::conditional<std::is_floating_point<T>::value, double, int64_t>::type DigestType;
+   const T* values = column.getValues<T>();
+   for (size_t row = 0; row < rowCount; ++row) {
+      if (column.isValid(row)) {
+         digest.add(static_cast<DigestType>(values[row]));
+      } else {
+         digest.addNull();
+      }
+   }
+}
+
+/**
+ * Reads `query` into column buffers chunk by chunk and computes the digests from the buffers.
+ */
+static std::vector<ColumnDigest> readColumns(hyperapi::Connection& connection, const std::string& query, int64_t& rowCount) {
+   hyperapi::Result result = connection.executeQuery(query);
+   std::vector<ColumnDigest> digests(result.getSchema().getColumnCount());
+   rowCount = samples::readColumnarChunks(result, [&](const samples::ColumnarResult& chunk) {
+      for (size_t i = 0; i < digests.size(); ++i) {
+         const samples::ColumnarColumn& column = chunk.getColumn(i);
+         switch (column.type.getTag()) {
+            case hyperapi::TypeTag::SmallInt:
+               addValues<int16_t>(digests[i], column, chunk.getRowCount());
+               break;
+            case hyperapi::TypeTag::Int:
+            case hyperapi::TypeTag::Date:
+               addValues<int32_t>(digests[i], column, chunk.getRowCount());
+               break;
+            case hyperapi::TypeTag::BigInt:
+               addValues<int64_t>(digests[i], column, chunk.getRowCount());
+               break;
+            case hyperapi::TypeTag::Double:
+               addValues<double>(digests[i], column, chunk.getRowCount());
+               break;
+            case hyperapi::TypeTag::Text:
+               for (size_t row = 0; row < chunk.getRowCount(); ++row) {
+                  if (column.isValid(row)) {
+                     digests[i].add(column.getBytes(row));
+                  } else {
+                     digests[i].addNull();
+                  }
+               }
+               break;
+            default:
+               throw std::runtime_error("Unexpected type " + column.type.toString());
+         }
+      }
+   });
+   return digests;
+}
+
+/**
+ * Runs `read` `runCount` times and returns the fastest time. The digests of all runs must match.
+ */
+template <class Read>
+static double measure(int runCount, std::vector<ColumnDigest>& digests, int64_t& rowCount, Read&& read) {
+   double bestSeconds = 0;
+   for (int run = 0; run < runCount; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<ColumnDigest> runDigests = read(rowCount);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      bestSeconds = (run == 0) ? seconds : std::min(bestSeconds, seconds);
+      if ((run > 0) && (runDigests != digests)) {
+         throw std::runtime_error("Two runs read different values.");
+      }
+      digests = runDigests;
+   }
+   return bestSeconds;
+}
+
+static void runBenchmarkColumnarResultReads(int repetitions) {
+   std::cout << "EXAMPLE - Read query results into column buffers" << std::endl;
+   const std::string pathToDatabase = "data/columnar_result_reads.hyper";
+   const int runCount = 3;
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "columnar_result_reads.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         // The line items with their orders, repeated to get a result large enough to measure.
+         const std::string sales = hyperapi::escapeName("Sales Repeated");
+         samples::timePhase(samples::Phase::Execute, [&] {
+            connection.executeCommand(
+               "CREATE TABLE " + sales + " AS SELECT l.*, o." + hyperapi::escapeName("Order Date") + ", o." + hyperapi::escapeName("Ship Date") + ", o." +
+               hyperapi::escapeName("Ship Mode") + ", r.repetition FROM " + samples::lineItemsTable.getTableName().toString() + " l JOIN " +
+               samples::ordersTable.getTableName().toString() + " o ON l." + hyperapi::escapeName("Order ID") + " = o." +
+               hyperapi::escapeName("Order ID") + " CROSS JOIN generate_series(1, " + std::to_string(repetitions) + ") AS r(repetition)");
+         });
+         const std::string query = "SELECT * FROM " + sales;
+
+         std::vector<ColumnDigest> valueDigests, columnDigests;
+         int64_t valueRows = 0, columnRows = 0;
+         samples::PhaseTimer queryTimer(samples::Phase::Query);
+         double valueSeconds =
+            measure(runCount, valueDigests, valueRows, [&](int64_t& rowCount) { return readValues(connection, query, rowCount); });
+         double columnSeconds =
+            measure(runCount, columnDigests, columnRows, [&](int64_t& rowCount) { return readColumns(connection, query, rowCount); });
+         queryTimer.stop();
+         if ((valueRows != columnRows) || (valueDigests != columnDigests)) {
+            throw std::runtime_error("Reading the result into column buffers returned different values.");
+         }
+
+         std::cout << "Read " << columnRows << " rows with " << columnDigests.size() << " columns, fastest of " << runCount << " runs:" << std::endl;
+         std::cout << "  Rows and values: " << valueSeconds << " s (" << static_cast<int64_t>(valueRows / valueSeconds) << " rows/s)" << std::endl;
+         std::cout << "  Column buffers:  " << columnSeconds << " s (" << static_cast<int64_t>(columnRows / columnSeconds) << " rows/s)" << std::endl;
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of times the line items are repeated in the result can be passed on the command line.
+   int repetitions = (arguments.size() > 0) ? std::atoi(arguments[0].c_str()) : 20;
+   try {
+      runBenchmarkColumnarResultReads(repetitions);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
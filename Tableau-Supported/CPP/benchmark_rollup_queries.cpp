@@ -0,0 +1,203 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example benchmark_rollup_queries.cpp
+ *
+ * An example of how to pre-aggregate the sales and profit per date and category into rollup tables, so dashboard
+ * queries read a few thousand groups instead of joining and aggregating all line items. The rollup tables are
+ * refreshed incrementally after new line items have been appended, and the latency of the dashboard queries is
+ * compared on the raw tables and on the rollup tables.
+ */
+
+#include "instrumentation.hpp"
+#include "rollup_table.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Helper function printing what a build or refresh of the rollup tables did
+ */
+static void printResults(const std::string& name, const std::vector<samples::RollupRefreshResult>& results) {
+   for (const samples::RollupRefreshResult& result : results) {
+      std::cout << name << " " << result.tableName << ": aggregated " << result.sourceRows << " line items into " << result.changedGroups << " groups in "
+                << result.seconds << " s." << std::endl;
+   }
+}
+
+/**
+ * Appends a copy of the original line items with new IDs for every number from `first` to `last`.
+ */
+static int64_t appendLineItems(hyperapi::Connection& connection, int first, int last) {
+   const std::string lineItems = samples::lineItemsTable.getTableName().toString();
+   return samples::timePhase(samples::Phase::Execute, [&] {
+      return connection.executeCommand(
+         "INSERT INTO " + lineItems + " SELECT l." + hyperapi::escapeName("Line Item ID") + " + r.copy * 100000, l." + hyperapi::escapeName("Order ID") +
+         ", l." + hyperapi::escapeName("Product ID") + ", l." + hyperapi::escapeName("Sales") + ", l." + hyperapi::escapeName("Quantity") + ", l." +
+         hyperapi::escapeName("Discount") + ", l." + hyperapi::escapeName("Profit") + " FROM " + lineItems + " l CROSS JOIN generate_series(" +
+         std::to_string(first) + ", " + std::to_string(last) + ") AS r(copy) WHERE l." + hyperapi::escapeName("Line Item ID") + " < 100000");
+   });
+}
+
+/**
+ * Runs `query` `runCount` times and returns the fastest time in milliseconds.
+ */
+static double measureQuery(hyperapi::Connection& connection, const std::string& query, int runCount) {
+   double bestMilliseconds = 0;
+   for (int run = 0; run < runCount; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      hyperapi::Result result = connection.executeQuery(query);
+      for (const hyperapi::Row& row : result) {
+         (void)row;
+      }
+      double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      bestMilliseconds = (run == 0) ? milliseconds : std::min(bestMilliseconds, milliseconds);
+   }
+   return bestMilliseconds;
+}
+
+/**
+ * Returns the number of groups in which the rollup table differs from aggregating its source directly. Sums of
+ * doubles depend on the order they are added in, so they only have to match up to rounding.
+ */
+static int64_t countDifferentGroups(hyperapi::Connection& connection, const samples::RollupDefinition& definition) {
+   std::string sameGroup, differentMeasures;
+   for (const samples::RollupColumn& column : definition.groupBy) {
+      const std::string name = hyperapi::escapeName(column.name);
+      sameGroup += (sameGroup.empty() ? "" : " AND ") + ("r." + name + " = q." + name);
+   }
+   for (const samples::RollupColumn& column : definition.measures) {
+      const std::string name = hyperapi::escapeName(column.name);
+      differentMeasures += " OR ABS(r." + name + " - q." + name + ") > 0.001 * (1 + ABS(q." + name + "))";
+   }
+   return connection.executeScalarQuery<int64_t>(
+      "SELECT COUNT(*) FROM " + definition.tableName.toString() + " r FULL OUTER JOIN (" + samples::RollupBuilder::getAggregateQuery(definition) +
+      ") q ON " + sameGroup + " WHERE r." + hyperapi::escapeName(definition.groupBy[0].name) + " IS NULL OR q." +
+      hyperapi::escapeName(definition.groupBy[0].name) + " IS NULL" + differentMeasures);
+}
+
+static void runBenchmarkRollupQueries(int copies) {
+   std::cout << "EXAMPLE - Pre-aggregate line items into rollup tables and compare dashboard queries" << std::endl;
+   const std::string pathToDatabase = "data/rollup_queries.hyper";
+   const int runCount = 5;
+
+   const std::string source = samples::lineItemsTable.getTableName().toString() + " l JOIN " + samples::productTable.getTableName().toString() +
+                              " p ON l." + hyperapi::escapeName("Product ID") + " = p." + hyperapi::escapeName("Product ID") + " JOIN " +
+                              samples::ordersTable.getTableName().toString() + " o ON l." + hyperapi::escapeName("Order ID") + " = o." +
+                              hyperapi::escapeName("Order ID");
+   const std::vector<samples::RollupColumn> measures = {
+      {"Sales", "l." + hyperapi::escapeName("Sales"), samples::RollupFunction::Sum},
+      {"Profit", "l." + hyperapi::escapeName("Profit"), samples::RollupFunction::Sum},
+      {"Line Items", "*", samples::RollupFunction::Count}};
+   const samples::RollupDefinition byDay{hyperapi::TableName("Sales By Day And Category"),
+                                         source,
+                                         "l." + hyperapi::escapeName("Line Item ID"),
+                                         {{"Order Date", "o." + hyperapi::escapeName("Order Date")}, {"Category", "p." + hyperapi::escapeName("Category")}},
+                                         measures};
+   const samples::RollupDefinition byMonth{
+      hyperapi::TableName("Sales By Month And Sub-Category"),
+      source,
+      "l." + hyperapi::escapeName("Line Item ID"),
+      {{"Order Month", "CAST(date_trunc('month', o." + hyperapi::escapeName("Order Date") + ") AS DATE)"},
+       {"Sub-Category", "p." + hyperapi::escapeName("Sub-Category")}},
+      measures};
+   samples::RollupBuilder builder;
+   builder.addRollup(byDay);
+   builder.addRollup(byMonth);
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "rollup_queries.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         // The line items are copied to get enough rows to measure, and the rollup tables are built after the load.
+         appendLineItems(connection, 1, copies - 1);
+         printResults("Built", builder.build(connection));
+
+         // The dashboard queries: the monthly sales and profit per category in one year, and the daily sales of one
+         // category in one month. Both can be answered from the rollup by day.
+         const std::string categoryFilter = hyperapi::escapeName("Category") + " = 'Technology'";
+         const std::vector<std::pair<std::string, std::string>> queries = {
+            {"SELECT date_trunc('month', o." + hyperapi::escapeName("Order Date") + ") AS m, p." + hyperapi::escapeName("Category") + ", SUM(l." +
+                hyperapi::escapeName("Sales") + "), SUM(l." + hyperapi::escapeName("Profit") + ") FROM " + source + " WHERE o." +
+                hyperapi::escapeName("Order Date") + " BETWEEN DATE '2014-01-01' AND DATE '2014-12-31' GROUP BY 1, 2",
+             "SELECT date_trunc('month', " + hyperapi::escapeName("Order Date") + ") AS m, " + hyperapi::escapeName("Category") + ", SUM(" +
+                hyperapi::escapeName("Sales") + "), SUM(" + hyperapi::escapeName("Profit") + ") FROM " + byDay.tableName.toString() + " WHERE " +
+                hyperapi::escapeName("Order Date") + " BETWEEN DATE '2014-01-01' AND DATE '2014-12-31' GROUP BY 1, 2"},
+            {"SELECT o." + hyperapi::escapeName("Order Date") + ", SUM(l." + hyperapi::escapeName("Sales") + ") FROM " + source + " WHERE p." +
+                categoryFilter + " AND o." + hyperapi::escapeName("Order Date") + " BETWEEN DATE '2015-11-01' AND DATE '2015-11-30' GROUP BY 1",
+             "SELECT " + hyperapi::escapeName("Order Date") + ", SUM(" + hyperapi::escapeName("Sales") + ") FROM " + byDay.tableName.toString() + " WHERE " +
+                categoryFilter + " AND " + hyperapi::escapeName("Order Date") + " BETWEEN DATE '2015-11-01' AND DATE '2015-11-30' GROUP BY 1"}};
+         std::cout << "Dashboard queries, fastest of " << runCount << " runs:" << std::endl;
+         samples::PhaseTimer queryTimer(samples::Phase::Query);
+         for (size_t i = 0; i < queries.size(); ++i) {
+            double rawMilliseconds = measureQuery(connection, queries[i].first, runCount);
+            double rollupMilliseconds = measureQuery(connection, queries[i].second, runCount);
+            std::cout << "  Query " << i + 1 << ": " << rawMilliseconds << " ms on the raw tables, " << rollupMilliseconds << " ms on the rollup table"
+                      << std::endl;
+         }
+         queryTimer.stop();
+
+         // New line items arrive: only they are aggregated and merged into the rollup tables.
+         int64_t appendedRows = appendLineItems(connection, copies, copies);
+         std::cout << "Appended " << appendedRows << " line items." << std::endl;
+         printResults("Refreshed", builder.refresh(connection));
+         for (const samples::RollupDefinition& definition : {byDay, byMonth}) {
+            int64_t differentGroups = samples::timePhase(samples::Phase::Query, [&] { return countDifferentGroups(connection, definition); });
+            if (differentGroups != 0) {
+               throw std::runtime_error(
+                  "The rollup table " + definition.tableName.toString() + " differs from its source in " + std::to_string(differentGroups) + " groups.");
+            }
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of copies of the line items before the refresh can be passed on the command line.
+   int copies = (arguments.size() > 0) ? std::atoi(arguments[0].c_str()) : 100;
+   try {
+      runBenchmarkRollupQueries(copies);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
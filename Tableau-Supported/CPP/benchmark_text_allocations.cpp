@@ -0,0 +1,320 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example benchmark_text_allocations.cpp
+ *
+ * An example of how to read and insert text values without allocating a `std::string` per value, measured by counting
+ * the heap allocations of reading the superstore tables and of copying the line items.
+ *
+ * Only the allocations of the C++ code are counted. The allocations of the Hyper API's C library and of the Hyper
+ * Process itself are not visible to this program.
+ */
+
+#include "column_batch.hpp"
+#include "instrumentation.hpp"
+#include "string_arena.hpp"
+#include "superstore_normalized.hpp"
+#include "typed_table.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** The number of calls to `operator new` made by this program. */
+static std::atomic<int64_t> allocationCount{0};
+
+// Replacing the global allocation functions counts every allocation of the C++ code, including those made inside the
+// standard library. `operator new[]` and the `nothrow` variants forward to these.
+void* operator new(size_t size) {
+   allocationCount.fetch_add(1, std::memory_order_relaxed);
+   if (void* memory = std::malloc(size ? size : 1)) {
+      return memory;
+   }
+   throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+   std::free(memory);
+}
+
+typedef samples::TypedTable<int64_t, std::string, std::string, double, int16_t, hyperapi::optional<double>, double> LineItemsTable;
+
+/** The allocations and the time of one variant. */
+struct Measurement {
+   int64_t allocations;
+   double seconds;
+};
+
+/**
+ * Runs `function` and returns the allocations it made and the time it took.
+ */
+template <class Function>
+static Measurement measure(Function&& function) {
+   int64_t allocationsBefore = allocationCount.load();
+   auto start = std::chrono::steady_clock::now();
+   function();
+   return Measurement{allocationCount.load() - allocationsBefore, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+}
+
+/**
+ * A digest of text values, used to check that both read variants saw the same values.
+ */
+class TextDigest {
+   public:
+   void add(hyperapi::string_view value) {
+      for (size_t i = 0; i < value.size(); ++i) {
+         hash = (hash ^ static_cast<unsigned char>(value.data()[i])) * 1099511628211ull;
+      }
+      hash = (hash ^ 0xff) * 1099511628211ull;
+      ++valueCount;
+   }
+
+   bool operator==(const TextDigest& other) const { return (hash == other.hash) && (valueCount == other.valueCount); }
+
+   uint64_t hash = 14695981039346656037ull;
+   int64_t valueCount = 0;
+};
+
+/**
+ * Helper function returning the indexes of the text columns of `result`
+ */
+static std::vector<size_t> getTextColumns(const hyperapi::Result& result) {
+   std::vector<size_t> textColumns;
+   const hyperapi::ResultSchema& schema = result.getSchema();
+   for (size_t i = 0; i < schema.getColumnCount(); ++i) {
+      if (schema.getColumn(i).getType().getTag() == hyperapi::TypeTag::Text) {
+         textColumns.push_back(i);
+      }
+   }
+   return textColumns;
+}
+
+/**
+ * Reads all text values of `table` as `std::string`s. The values of a chunk are kept until the chunk has been read,
+ * as a consumer that processes the result in batches would.
+ */
+static TextDigest readOwnedStrings(hyperapi::Connection& connection, const hyperapi::TableName& table) {
+   TextDigest digest;
+   hyperapi::Result result = connection.executeQuery("SELECT * FROM " + table.toString());
+   std::vector<size_t> textColumns = getTextColumns(result);
+   std::vector<std::string> values;
+   samples::readChunks(result, [&](const hyperapi::Chunk& chunk) {
+      for (const hyperapi::Row& row : chunk) {
+         for (size_t column : textColumns) {
+            hyperapi::optional<std::string> value = row.get<hyperapi::optional<std::string>>(column);
+            if (value.has_value()) {
+               values.push_back(std::move(*value));
+            }
+         }
+      }
+      for (const std::string& value : values) {
+         digest.add(value);
+      }
+      values.clear();
+   });
+   return digest;
+}
+
+/**
+ * Reads all text values of `table` as views into the result chunks. The views are valid until the chunk has been read.
+ */
+static TextDigest readStringViews(hyperapi::Connection& connection, const hyperapi::TableName& table) {
+   TextDigest digest;
+   hyperapi::Result result = connection.executeQuery("SELECT * FROM " + table.toString());
+   std::vector<size_t> textColumns = getTextColumns(result);
+   std::vector<hyperapi::string_view> values;
+   samples::readChunks(result, [&](const hyperapi::Chunk& chunk) {
+      for (const hyperapi::Row& row : chunk) {
+         for (size_t column : textColumns) {
+            hyperapi::optional<hyperapi::string_view> value = samples::getTextView(row, column);
+            if (value.has_value()) {
+               values.push_back(*value);
+            }
+         }
+      }
+      for (hyperapi::string_view value : values) {
+         digest.add(value);
+      }
+      values.clear();
+   });
+   return digest;
+}
+
+/**
+ * Helper function returning the query that reads the line items in the column order of `LineItemsTable`
+ */
+static std::string selectLineItems() {
+   return "SELECT " + hyperapi::escapeName("Line Item ID") + ", " + hyperapi::escapeName("Order ID") + ", " + hyperapi::escapeName("Product ID") + ", " +
+          hyperapi::escapeName("Sales") + ", " + hyperapi::escapeName("Quantity") + ", " + hyperapi::escapeName("Discount") + ", " +
+          hyperapi::escapeName("Profit") + " FROM " + samples::lineItemsTable.getTableName().toString();
+}
+
+/**
+ * Copies the line items `repetitions` times into `target`, reading every text value as a `std::string`.
+ * The line items are read through `source`, as `connection` is busy with the insert.
+ */
+static void copyRowByRow(hyperapi::Connection& connection, hyperapi::Connection& source, const LineItemsTable& target, int repetitions) {
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   hyperapi::Inserter inserter(connection, target.getDefinition());
+   for (int repetition = 0; repetition < repetitions; ++repetition) {
+      hyperapi::Result result = source.executeQuery(selectLineItems());
+      for (const hyperapi::Row& row : result) {
+         inserter.addRow(
+            row.get<int64_t>(0), row.get<std::string>(1), row.get<std::string>(2), row.get<double>(3), row.get<int16_t>(4),
+            row.get<hyperapi::optional<double>>(5), row.get<double>(6));
+      }
+   }
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+}
+
+/**
+ * Copies the line items `repetitions` times into `target` through a column batch. The text values are read as views
+ * into the result chunks and copied into the batch's arena.
+ */
+static void copyInColumnBatches(hyperapi::Connection& connection, hyperapi::Connection& source, const LineItemsTable& target, int repetitions) {
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   hyperapi::Inserter inserter(connection, target.getDefinition());
+   samples::ColumnBatch<LineItemsTable> batch(8192);
+   for (int repetition = 0; repetition < repetitions; ++repetition) {
+      hyperapi::Result result = source.executeQuery(selectLineItems());
+      samples::readChunks(result, [&](const hyperapi::Chunk& chunk) {
+         for (const hyperapi::Row& row : chunk) {
+            bool isFull = batch.addRow(
+               row.get<int64_t>(0), row.get<hyperapi::string_view>(1), row.get<hyperapi::string_view>(2), row.get<double>(3), row.get<int16_t>(4),
+               row.get<hyperapi::optional<double>>(5), row.get<double>(6));
+            if (isFull) {
+               batch.flush(inserter);
+            }
+         }
+      });
+   }
+   batch.flush(inserter);
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+}
+
+/**
+ * Helper function printing one line of the comparison
+ */
+static void printMeasurement(const std::string& variant, const Measurement& measurement, int64_t valueCount) {
+   std::cout << variant << measurement.allocations << " allocations ("
+             << static_cast<double>(measurement.allocations) / static_cast<double>(valueCount) << " per value), " << measurement.seconds << " s"
+             << std::endl;
+}
+
+static void runBenchmarkTextAllocations(int repetitions) {
+   std::cout << "EXAMPLE - Count the allocations of reading and inserting text values" << std::endl;
+   const std::string pathToDatabase = "data/text_allocations.hyper";
+   const char* const columnNames[] = {"Line Item ID", "Order ID", "Product ID", "Sales", "Quantity", "Discount", "Profit"};
+   const LineItemsTable rowByRowTable{"Line Items Row By Row", columnNames};
+   const LineItemsTable columnBatchTable{"Line Items Column Batches", columnNames};
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "text_allocations.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         hyperapi::Connection source(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         // Read the text values of all four tables both ways.
+         const hyperapi::TableName tables[] = {
+            samples::ordersTable.getTableName(), samples::customerTable.getTableName(), samples::productTable.getTableName(),
+            samples::lineItemsTable.getTableName()};
+         TextDigest ownedDigest, viewDigest;
+         samples::PhaseTimer queryTimer(samples::Phase::Query);
+         Measurement ownedRead = measure([&] {
+            for (const hyperapi::TableName& table : tables) {
+               TextDigest digest = readOwnedStrings(connection, table);
+               ownedDigest.hash ^= digest.hash;
+               ownedDigest.valueCount += digest.valueCount;
+            }
+         });
+         Measurement viewRead = measure([&] {
+            for (const hyperapi::TableName& table : tables) {
+               TextDigest digest = readStringViews(connection, table);
+               viewDigest.hash ^= digest.hash;
+               viewDigest.valueCount += digest.valueCount;
+            }
+         });
+         queryTimer.stop();
+         if (!(ownedDigest == viewDigest)) {
+            throw std::runtime_error("Reading the text values as views returned different values.");
+         }
+         std::cout << "Read " << ownedDigest.valueCount << " text values:" << std::endl;
+         printMeasurement("  std::string:  ", ownedRead, ownedDigest.valueCount);
+         printMeasurement("  string_view:  ", viewRead, viewDigest.valueCount);
+
+         // Copy the line items both ways.
+         samples::PhaseTimer ddlTimer(samples::Phase::DDL);
+         connection.getCatalog().createTable(rowByRowTable.getDefinition());
+         connection.getCatalog().createTable(columnBatchTable.getDefinition());
+         ddlTimer.stop();
+         Measurement rowByRowCopy = measure([&] { copyRowByRow(connection, source, rowByRowTable, repetitions); });
+         Measurement columnBatchCopy = measure([&] { copyInColumnBatches(connection, source, columnBatchTable, repetitions); });
+
+         // Both tables must contain the same rows.
+         int64_t differentRows = samples::timePhase(samples::Phase::Query, [&] {
+            return connection.executeScalarQuery<int64_t>(
+               "SELECT COUNT(*) FROM ((SELECT * FROM " + rowByRowTable.getTableName().toString() + " EXCEPT ALL SELECT * FROM " +
+               columnBatchTable.getTableName().toString() + ") UNION ALL (SELECT * FROM " + columnBatchTable.getTableName().toString() +
+               " EXCEPT ALL SELECT * FROM " + rowByRowTable.getTableName().toString() + ")) AS differences");
+         });
+         if (differentRows != 0) {
+            throw std::runtime_error("The column batches inserted different rows.");
+         }
+         int64_t copiedTextValues =
+            2 * connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + columnBatchTable.getTableName().toString());
+         std::cout << "Copied " << copiedTextValues << " text values:" << std::endl;
+         printMeasurement("  row by row:     ", rowByRowCopy, copiedTextValues);
+         printMeasurement("  column batches: ", columnBatchCopy, copiedTextValues);
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of times the line items are copied can be passed on the command line.
+   int repetitions = (arguments.size() > 0) ? std::atoi(arguments[0].c_str()) : 10;
+   try {
+      runBenchmarkTextAllocations(repetitions);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
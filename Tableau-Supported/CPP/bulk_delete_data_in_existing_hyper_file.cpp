@@ -0,0 +1,189 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example bulk_delete_data_in_existing_hyper_file.cpp
+ *
+ * An example of how to delete all data of a large set of customers from every table that references them.
+ */
+
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** The temporary table the keys to be deleted are staged in. */
+static const hyperapi::TableDefinition erasedCustomersTable{
+   "Erased Customers",
+   {hyperapi::TableDefinition::Column{"Customer ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable}},
+   hyperapi::Persistence::Temporary};
+
+/** A table that references the erased customers and the column through which it does so. */
+struct ReferencingTable {
+   hyperapi::TableName table;
+   std::string keyColumn;
+   /// A query returning the values of `keyColumn` that have to be deleted.
+   std::string keysToDelete;
+};
+
+/**
+ * Helper function returning the seconds elapsed since `start`
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Reads the customer IDs to be erased, one per line. If no file is given, every second customer of the superstore
+ * data set is erased.
+ */
+static std::vector<std::string> readCustomerIds(const std::string& pathToKeys) {
+   std::vector<std::string> customerIds;
+   if (!pathToKeys.empty()) {
+      std::ifstream keys(pathToKeys);
+      if (!keys) {
+         throw std::runtime_error("Could not open " + pathToKeys);
+      }
+      std::string line;
+      while (std::getline(keys, line)) {
+         if (!line.empty() && (line.back() == '\r')) {
+            line.pop_back();
+         }
+         if (!line.empty()) {
+            customerIds.push_back(line);
+         }
+      }
+      return customerIds;
+   }
+
+   std::ifstream customers("data/customers.csv");
+   std::string line;
+   std::getline(customers, line); // Skip the header.
+   for (size_t lineNumber = 0; std::getline(customers, line); ++lineNumber) {
+      if (lineNumber % 2 == 0) {
+         customerIds.push_back(line.substr(0, line.find(',')));
+      }
+   }
+   return customerIds;
+}
+
+static void runBulkDeleteDataInExistingHyperFile(const std::string& pathToKeys) {
+   std::cout << "EXAMPLE - Delete the data of many customers from all tables of a Hyper file" << std::endl;
+   const std::string pathToDatabase = "data/superstore_bulk_delete.hyper";
+
+   std::vector<std::string> customerIds = readCustomerIds(pathToKeys);
+
+   // The tables are listed in the order in which they have to be deleted from: "Line Items" only references the
+   // customers through "Orders", so its rows must be deleted before the orders are gone.
+   const std::string erasedCustomers = "SELECT " + hyperapi::escapeName("Customer ID") + " FROM " + erasedCustomersTable.getTableName().toString();
+   const std::vector<ReferencingTable> referencingTables{
+      {samples::lineItemsTable.getTableName(), "Order ID",
+       "SELECT " + hyperapi::escapeName("Order ID") + " FROM " + samples::ordersTable.getTableName().toString() + " WHERE " +
+          hyperapi::escapeName("Customer ID") + " IN (" + erasedCustomers + ")"},
+      {samples::ordersTable.getTableName(), "Customer ID", erasedCustomers},
+      {samples::customerTable.getTableName(), "Customer ID", erasedCustomers}};
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "superstore_bulk_delete.hyper" and loads the normalized superstore tables into it.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         // Stage the keys with an inserter.
+         auto start = std::chrono::steady_clock::now();
+         samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(erasedCustomersTable); });
+         {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
+            hyperapi::Inserter inserter(connection, erasedCustomersTable);
+            for (const std::string& customerId : customerIds) {
+               inserter.addRow(customerId);
+            }
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+         }
+         std::cout << "Staged " << customerIds.size() << " customer IDs in " << secondsSince(start) << " s." << std::endl;
+
+         // Delete from every referencing table with one semi-join each. The deletions run in one transaction, so a
+         // failure never leaves a customer partially erased.
+         int64_t totalRowCount = 0;
+         start = std::chrono::steady_clock::now();
+         samples::PhaseTimer executeTimer(samples::Phase::Execute);
+         connection.executeCommand("BEGIN TRANSACTION");
+         try {
+            for (const ReferencingTable& referencingTable : referencingTables) {
+               auto tableStart = std::chrono::steady_clock::now();
+               int64_t rowCount = connection.executeCommand(
+                  "DELETE FROM " + referencingTable.table.toString() + " WHERE " + hyperapi::escapeName(referencingTable.keyColumn) + " IN (" +
+                  referencingTable.keysToDelete + ")");
+               double seconds = secondsSince(tableStart);
+               std::cout << "The number of deleted rows in table " << referencingTable.table << " is " << rowCount << " (" << seconds << " s, "
+                         << static_cast<double>(rowCount) / seconds << " rows/s)." << std::endl;
+               totalRowCount += rowCount;
+            }
+            connection.executeCommand("COMMIT");
+         } catch (...) {
+            // A failing ROLLBACK must not hide the exception that aborted the transaction.
+            try {
+               connection.executeCommand("ROLLBACK");
+            } catch (const hyperapi::HyperException&) {
+            }
+            throw;
+         }
+         executeTimer.stop();
+         double seconds = secondsSince(start);
+         std::cout << "Deleted " << totalRowCount << " rows in " << seconds << " s (" << static_cast<double>(totalRowCount) / seconds << " rows/s)."
+                   << std::endl;
+
+         // No order of an erased customer may remain.
+         int64_t remainingOrders = connection.executeScalarQuery<int64_t>(
+            "SELECT COUNT(*) FROM " + samples::ordersTable.getTableName().toString() + " WHERE " + hyperapi::escapeName("Customer ID") + " IN (" +
+            erasedCustomers + ")");
+         if (remainingOrders != 0) {
+            throw std::runtime_error("Orders of erased customers remain in the Hyper file.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, a file with one customer ID per line can be passed on the command line.
+   try {
+      runBulkDeleteDataInExistingHyperFile(arguments.empty() ? "" : arguments[0]);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
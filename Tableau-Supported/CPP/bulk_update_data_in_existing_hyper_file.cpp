@@ -0,0 +1,182 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example bulk_update_data_in_existing_hyper_file.cpp
+ *
+ * An example of how to apply a large number of keyed updates to a Hyper file with a single set-based UPDATE
+ * instead of one UPDATE statement per changed row.
+ */
+
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** A keyed change to a row of the "Line Items" table. */
+struct LineItemChange {
+   int64_t lineItemId;
+   double sales;
+   double profit;
+};
+
+/** The temporary table the changes are staged in. It only lives as long as the connection. */
+static const hyperapi::TableDefinition lineItemChangesTable{
+   "Line Item Changes",
+   {hyperapi::TableDefinition::Column{"Line Item ID", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Sales", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Profit", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable}},
+   hyperapi::Persistence::Temporary};
+
+/** The number of changes that are applied with individual UPDATE statements for comparison. */
+static const size_t perRowSampleSize = 1000;
+
+/**
+ * Helper function returning the seconds elapsed since `start`
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Applies the changes with one UPDATE statement per row. This is the approach the bulk update replaces.
+ */
+static void applyRowByRow(hyperapi::Connection& connection, const std::vector<LineItemChange>& changes) {
+   samples::PhaseTimer executeTimer(samples::Phase::Execute);
+   for (const LineItemChange& change : changes) {
+      connection.executeCommand(
+         "UPDATE " + samples::lineItemsTable.getTableName().toString() + " SET " + hyperapi::escapeName("Sales") + " = " + std::to_string(change.sales) +
+         ", " + hyperapi::escapeName("Profit") + " = " + std::to_string(change.profit) + " WHERE " + hyperapi::escapeName("Line Item ID") + " = " +
+         std::to_string(change.lineItemId));
+   }
+}
+
+/**
+ * Stages the changes in a temporary table with an `Inserter` and applies them with a single set-based UPDATE.
+ * Returns the number of updated rows.
+ */
+static int64_t applyBulk(hyperapi::Connection& connection, const std::vector<LineItemChange>& changes) {
+   samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(lineItemChangesTable); });
+   {
+      samples::PhaseTimer insertTimer(samples::Phase::Insert);
+      hyperapi::Inserter inserter(connection, lineItemChangesTable);
+      for (const LineItemChange& change : changes) {
+         inserter.addRow(change.lineItemId, change.sales, change.profit);
+      }
+      insertTimer.stop();
+      samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+   }
+
+   // The correlated subqueries are decorrelated by Hyper into a join between "Line Items" and the staged changes, so
+   // the whole update runs as one set-based operation inside Hyper.
+   const std::string target = samples::lineItemsTable.getTableName().toString();
+   const std::string delta = lineItemChangesTable.getTableName().toString();
+   const std::string key = hyperapi::escapeName("Line Item ID");
+   auto changedValue = [&](const std::string& column) {
+      return "(SELECT d." + column + " FROM " + delta + " d WHERE d." + key + " = " + target + "." + key + ")";
+   };
+   samples::PhaseTimer executeTimer(samples::Phase::Execute);
+   int64_t rowCount = connection.executeCommand(
+      "UPDATE " + target + " SET " + hyperapi::escapeName("Sales") + " = " + changedValue(hyperapi::escapeName("Sales")) + ", " +
+      hyperapi::escapeName("Profit") + " = " + changedValue(hyperapi::escapeName("Profit")) + " WHERE " + key + " IN (SELECT " + key + " FROM " + delta +
+      ")");
+
+   connection.executeCommand("DROP TABLE " + delta);
+   return rowCount;
+}
+
+static void runBulkUpdateDataInExistingHyperFile() {
+   std::cout << "EXAMPLE - Apply keyed changes to an existing Hyper file with a single set-based UPDATE" << std::endl;
+   const std::string pathToDatabase = "data/superstore_bulk_update.hyper";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "superstore_bulk_update.hyper" and loads the normalized superstore tables into it.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         // In production, the changes arrive from an upstream system. Here, every line item gets a new sales and profit value.
+         std::vector<LineItemChange> changes;
+         {
+            samples::PhaseTimer queryTimer(samples::Phase::Query);
+            hyperapi::Result lineItemIds = connection.executeQuery(
+               "SELECT " + hyperapi::escapeName("Line Item ID") + " FROM " + samples::lineItemsTable.getTableName().toString() + " ORDER BY 1");
+            for (const hyperapi::Row& row : lineItemIds) {
+               int64_t lineItemId = row.get<int64_t>(0);
+               changes.push_back({lineItemId, static_cast<double>(lineItemId % 1000) + 0.5, static_cast<double>(lineItemId % 100) - 25.25});
+            }
+         }
+         std::cout << "Applying " << changes.size() << " changes to table " << samples::lineItemsTable.getTableName() << "." << std::endl;
+
+         // Row-by-row UPDATE statements are too slow to apply all changes, so only a sample of them is timed.
+         std::vector<LineItemChange> sample(changes.begin(), changes.begin() + static_cast<std::ptrdiff_t>(std::min(perRowSampleSize, changes.size())));
+         auto start = std::chrono::steady_clock::now();
+         applyRowByRow(connection, sample);
+         double rowByRowSeconds = secondsSince(start);
+
+         start = std::chrono::steady_clock::now();
+         int64_t rowCount = applyBulk(connection, changes);
+         double bulkSeconds = secondsSince(start);
+
+         std::cout << "Row-by-row UPDATE statements: " << sample.size() << " rows in " << rowByRowSeconds << " s ("
+                   << static_cast<double>(sample.size()) / rowByRowSeconds << " rows/s)." << std::endl;
+         std::cout << "Staged set-based UPDATE: " << rowCount << " rows in " << bulkSeconds << " s (" << static_cast<double>(rowCount) / bulkSeconds
+                   << " rows/s)." << std::endl;
+
+         // Every change must be visible in the table now.
+         double expectedSales = 0;
+         for (const LineItemChange& change : changes) {
+            expectedSales += change.sales;
+         }
+         double actualSales =
+            connection.executeScalarQuery<double>("SELECT SUM(" + hyperapi::escapeName("Sales") + ") FROM " + samples::lineItemsTable.getTableName().toString());
+         if ((rowCount != static_cast<int64_t>(changes.size())) || (std::abs(actualSales - expectedSales) > 1e-6 * expectedSales)) {
+            throw std::runtime_error("The updated table does not match the applied changes.");
+         }
+         std::cout << "All changes have been applied." << std::endl;
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
+   try {
+      runBulkUpdateDataInExistingHyperFile();
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,187 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file column_batch.hpp
+ *
+ * A struct-of-arrays buffer for the rows of a `TypedTable`.
+ *
+ * Producers append rows to one contiguous array per column instead of building a row object per row. Text values are
+ * copied into a `StringArena` per column, so appending a text value does not allocate a `std::string`, and
+ * nullable columns keep a null bitmap next to their values. Once the batch is full, `flush()` hands all rows to an
+ * `Inserter` in one tight loop and clears the batch while keeping its capacity, so a steady-state load does not
+ * allocate at all on the client side.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_COLUMN_BATCH_HPP
+#define TABLEAU_HYPER_SAMPLES_COLUMN_BATCH_HPP
+
+#include "string_arena.hpp"
+#include "typed_table.hpp"
+
+#include <cstdint>
+#include <hyperapi/hyperapi.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace samples {
+
+/** The values of one column of a `ColumnBatch`. Fixed-size values are stored in a vector. */
+template <class T>
+class ColumnStorage {
+   public:
+   void append(const T& value) { values.push_back(value); }
+   void appendDefault() { values.push_back(T()); }
+   void addTo(hyperapi::Inserter& inserter, size_t row) const { inserter.add(values[row]); }
+   void reserve(size_t rowCount) { values.reserve(rowCount); }
+   void clear() { values.clear(); }
+
+   private:
+   std::vector<T> values;
+};
+
+/** Text values are copied into an arena that is reset with the batch and handed to the inserter as views into it. */
+template <>
+class ColumnStorage<std::string> {
+   public:
+   void append(hyperapi::string_view value) { values.push_back(arena.store(value)); }
+   void appendDefault() { values.push_back(hyperapi::string_view("", 0)); }
+   void addTo(hyperapi::Inserter& inserter, size_t row) const { inserter.add(values[row]); }
+   void reserve(size_t rowCount) { values.reserve(rowCount); }
+   void clear() {
+      values.clear();
+      arena.reset();
+   }
+
+   private:
+   StringArena arena;
+   std::vector<hyperapi::string_view> values;
+};
+
+/** Nullable values are stored like their non-nullable counterparts, with a bitmap marking the nulls. */
+template <class T>
+class ColumnStorage<hyperapi::optional<T>> {
+   public:
+   template <class Value>
+   void append(const Value& value) {
+      setNull(false);
+      values.append(value);
+   }
+   void append(const hyperapi::Null&) {
+      setNull(true);
+      values.appendDefault();
+   }
+   void append(const hyperapi::optional<T>& value) {
+      if (value.has_value()) {
+         append(*value);
+      } else {
+         append(hyperapi::null);
+      }
+   }
+   void addTo(hyperapi::Inserter& inserter, size_t row) const {
+      if (nulls[row / 64] & (uint64_t{1} << (row % 64))) {
+         inserter.add(hyperapi::null);
+      } else {
+         values.addTo(inserter, row);
+      }
+   }
+   void reserve(size_t rowCount) {
+      values.reserve(rowCount);
+      nulls.reserve((rowCount + 63) / 64);
+   }
+   void clear() {
+      values.clear();
+      nulls.clear();
+      rowCount = 0;
+   }
+
+   private:
+   void setNull(bool isNull) {
+      if (rowCount % 64 == 0) {
+         nulls.push_back(0);
+      }
+      if (isNull) {
+         nulls.back() |= uint64_t{1} << (rowCount % 64);
+      }
+      ++rowCount;
+   }
+
+   ColumnStorage<T> values;
+   std::vector<uint64_t> nulls;
+   size_t rowCount = 0;
+};
+
+template <class Table>
+class ColumnBatch;
+
+/**
+ * Buffers up to `capacity` rows of a `TypedTable<Types...>` column by column.
+ *
+ * `addRow` takes one value per column. Text columns accept anything that converts to `hyperapi::string_view`, e.g., a
+ * `const char*` or a view into a buffer the producer formats into, and nullable columns additionally accept
+ * `hyperapi::null`.
+ */
+template <class... Types>
+class ColumnBatch<TypedTable<Types...>> {
+   public:
+   explicit ColumnBatch(size_t capacity) : capacity(capacity) { reserve(typename detail::MakeIndexSequence<sizeof...(Types)>::Type()); }
+
+   /** Appends a row. Returns true if the batch is full and should be flushed. */
+   template <class... Values>
+   bool addRow(const Values&... values) {
+      static_assert(sizeof...(Values) == sizeof...(Types), "A row needs one value per column");
+      append(typename detail::MakeIndexSequence<sizeof...(Types)>::Type(), values...);
+      return ++rowCount >= capacity;
+   }
+
+   size_t getRowCount() const { return rowCount; }
+
+   /** Adds all buffered rows to `inserter` and clears the batch. */
+   void flush(hyperapi::Inserter& inserter) {
+      for (size_t row = 0; row < rowCount; ++row) {
+         addTo(inserter, row, typename detail::MakeIndexSequence<sizeof...(Types)>::Type());
+         inserter.endRow();
+      }
+      clear(typename detail::MakeIndexSequence<sizeof...(Types)>::Type());
+      rowCount = 0;
+   }
+
+   private:
+   // The arrays only exist to expand the parameter packs in column order.
+   template <size_t... Indexes, class... Values>
+   void append(detail::IndexSequence<Indexes...>, const Values&... values) {
+      int expand[] = {0, (std::get<Indexes>(columns).append(values), 0)...};
+      (void)expand;
+   }
+   template <size_t... Indexes>
+   void addTo(hyperapi::Inserter& inserter, size_t row, detail::IndexSequence<Indexes...>) const {
+      int expand[] = {0, (std::get<Indexes>(columns).addTo(inserter, row), 0)...};
+      (void)expand;
+   }
+   template <size_t... Indexes>
+   void reserve(detail::IndexSequence<Indexes...>) {
+      int expand[] = {0, (std::get<Indexes>(columns).reserve(capacity), 0)...};
+      (void)expand;
+   }
+   template <size_t... Indexes>
+   void clear(detail::IndexSequence<Indexes...>) {
+      int expand[] = {0, (std::get<Indexes>(columns).clear(), 0)...};
+      (void)expand;
+   }
+
+   std::tuple<ColumnStorage<Types>...> columns;
+   size_t capacity;
+   size_t rowCount = 0;
+};
+}
+
+#endif
@@ -0,0 +1,322 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file columnar_result.hpp
+ *
+ * Reads query results into column buffers that are laid out like Apache Arrow arrays, without depending on Arrow.
+ *
+ * Each column gets a validity bitmap and either one buffer of fixed-width values or, for text and binary data, an
+ * offset buffer and a data buffer. A result chunk is appended column by column, so the type of a column is checked
+ * once per chunk and every value is read with `Row::get` straight into its buffer, without a `hyperapi::Value` per
+ * cell. `clear()` keeps the capacity of the buffers, so reading a result chunk by chunk stops allocating after the
+ * largest chunk.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_COLUMNAR_RESULT_HPP
+#define TABLEAU_HYPER_SAMPLES_COLUMNAR_RESULT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <hyperapi/hyperapi.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+namespace detail {
+/** Helper function returning the number of days between 1970-01-01 and `date` */
+inline int32_t getUnixDays(const hyperapi::Date& date) {
+   // Counts in eras of 400 years, with years starting in March so the leap day is the last day of a year.
+   const int64_t year = date.getYear() - (date.getMonth() <= 2);
+   const int64_t era = (year >= 0 ? year : year - 399) / 400;
+   const int64_t yearOfEra = year - era * 400;
+   const int64_t dayOfYear = (153 * (date.getMonth() > 2 ? date.getMonth() - 3 : date.getMonth() + 9) + 2) / 5 + date.getDay() - 1;
+   const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+   return static_cast<int32_t>(era * 146097 + dayOfEra - 719468);
+}
+
+/** Helper function returning the microseconds between midnight and `time` */
+inline int64_t getMicroseconds(const hyperapi::Time& time) {
+   return ((time.getHour() * int64_t(60) + time.getMinute()) * 60 + time.getSecond()) * 1000000 + time.getMicrosecond();
+}
+
+/** Helper function returning the microseconds between 1970-01-01 00:00 and `date` `time` */
+inline int64_t getUnixMicroseconds(const hyperapi::Date& date, const hyperapi::Time& time) {
+   return getUnixDays(date) * int64_t(86400000000) + getMicroseconds(time);
+}
+
+/** Helper function returning the microseconds between 1970-01-01 00:00 UTC and `timestamp` */
+inline int64_t getUnixMicroseconds(const hyperapi::OffsetTimestamp& timestamp) {
+   return getUnixMicroseconds(timestamp.getDate(), timestamp.getTime()) -
+          std::chrono::duration_cast<std::chrono::microseconds>(timestamp.getOffset()).count();
+}
+}
+
+/** How the values of a column are stored. */
+enum class ColumnarLayout {
+   /// One value of a fixed size per row, see `getColumnarValueSize()`.
+   FixedWidth,
+   /// The values of row `i` are the bytes from `offsets[i]` to `offsets[i + 1]` of the data buffer.
+   Variable
+};
+
+/**
+ * Returns the layout of columns of `type`, throws if the type cannot be read into columns. Numerics need their
+ * precision at compile time to be read, so they are best cast to double precision in the query.
+ */
+inline ColumnarLayout getColumnarLayout(const hyperapi::SqlType& type) {
+   switch (type.getTag()) {
+      case hyperapi::TypeTag::Bool:
+      case hyperapi::TypeTag::SmallInt:
+      case hyperapi::TypeTag::Int:
+      case hyperapi::TypeTag::BigInt:
+      case hyperapi::TypeTag::Oid:
+      case hyperapi::TypeTag::Double:
+      case hyperapi::TypeTag::Date:
+      case hyperapi::TypeTag::Time:
+      case hyperapi::TypeTag::Timestamp:
+      case hyperapi::TypeTag::TimestampTZ:
+         return ColumnarLayout::FixedWidth;
+      case hyperapi::TypeTag::Text:
+      case hyperapi::TypeTag::Varchar:
+      case hyperapi::TypeTag::Char:
+      case hyperapi::TypeTag::Json:
+      case hyperapi::TypeTag::Bytes:
+         return ColumnarLayout::Variable;
+      default:
+         throw std::runtime_error("The SQL type " + type.toString() + " cannot be read into columns");
+   }
+}
+
+/**
+ * Returns the size of one value of a fixed-width column of `type`. The values are stored as
+ * - `uint8_t` 0 or 1 for BOOL,
+ * - `int16_t`, `int32_t`, `int64_t`, `uint32_t`, and `double` for SMALLINT, INTEGER, BIGINT, OID, and DOUBLE PRECISION,
+ * - `int32_t` days since 1970-01-01 for DATE,
+ * - `int64_t` microseconds since midnight for TIME,
+ * - `int64_t` microseconds since 1970-01-01 00:00 for TIMESTAMP, in UTC for TIMESTAMPTZ.
+ */
+inline size_t getColumnarValueSize(const hyperapi::SqlType& type) {
+   switch (type.getTag()) {
+      case hyperapi::TypeTag::Bool:
+         return 1;
+      case hyperapi::TypeTag::SmallInt:
+         return 2;
+      case hyperapi::TypeTag::Int:
+      case hyperapi::TypeTag::Oid:
+      case hyperapi::TypeTag::Date:
+         return 4;
+      default:
+         return 8;
+   }
+}
+
+/** The values of one result column. */
+struct ColumnarColumn {
+   std::string name;
+   hyperapi::SqlType type;
+   ColumnarLayout layout;
+   /// One bit per row, least significant bit first, set if the value is not NULL.
+   std::vector<uint8_t> validity;
+   size_t nullCount;
+   /// The fixed-width values, or the bytes of all values of a variable layout. NULLs take no bytes in the latter.
+   std::vector<uint8_t> data;
+   /// For the variable layout, one offset into `data` per row plus one past the last value.
+   std::vector<int32_t> offsets;
+
+   ColumnarColumn(std::string name, hyperapi::SqlType type) : name(std::move(name)), type(type), layout(getColumnarLayout(type)), nullCount(0) {}
+
+   /** Returns whether the value of `row` is not NULL. */
+   bool isValid(size_t row) const { return (validity[row / 8] >> (row % 8)) & 1; }
+
+   /** Returns the fixed-width values. `T` must match `getColumnarValueSize()`. */
+   template <class T>
+   const T* getValues() const {
+      return reinterpret_cast<const T*>(data.data());
+   }
+
+   /** Returns the text or binary value of `row`, an empty view for NULL. */
+   hyperapi::string_view getBytes(size_t row) const {
+      return hyperapi::string_view(reinterpret_cast<const char*>(data.data()) + offsets[row], static_cast<size_t>(offsets[row + 1] - offsets[row]));
+   }
+};
+
+namespace detail {
+/** Helper function marking `row` of `column` as valid or NULL, the bitmap must have room for it */
+inline void setValid(ColumnarColumn& column, size_t row, bool isValid) {
+   if (isValid) {
+      column.validity[row / 8] |= static_cast<uint8_t>(1 << (row % 8));
+   } else {
+      ++column.nullCount;
+   }
+}
+
+/**
+ * Appends the values of column `index` of `chunk` to `column`, whose first `firstRow` rows are filled already. The
+ * values are read as `T` and stored as `Stored`, converted with `convert`.
+ */
+template <class T, class Stored, class Convert>
+void appendFixedWidth(ColumnarColumn& column, const hyperapi::Chunk& chunk, size_t index, size_t firstRow, Convert convert) {
+   column.data.resize((firstRow + chunk.getRowCount()) * sizeof(Stored));
+   Stored* values = reinterpret_cast<Stored*>(column.data.data());
+   size_t row = firstRow;
+   for (const hyperapi::Row& resultRow : chunk) {
+      hyperapi::optional<T> value = resultRow.get<hyperapi::optional<T>>(index);
+      values[row] = value.has_value() ? convert(*value) : Stored();
+      setValid(column, row, value.has_value());
+      ++row;
+   }
+}
+
+/** Appends the values of column `index` of `chunk` to the offset and data buffers of `column`. */
+template <class T, class GetBytes>
+void appendVariable(ColumnarColumn& column, const hyperapi::Chunk& chunk, size_t index, size_t firstRow, GetBytes getBytes) {
+   column.offsets.resize(firstRow + chunk.getRowCount() + 1);
+   size_t row = firstRow;
+   for (const hyperapi::Row& resultRow : chunk) {
+      hyperapi::optional<T> value = resultRow.get<hyperapi::optional<T>>(index);
+      if (value.has_value()) {
+         hyperapi::string_view bytes = getBytes(*value);
+         column.data.insert(column.data.end(), bytes.data(), bytes.data() + bytes.size());
+      }
+      setValid(column, row, value.has_value());
+      column.offsets[++row] = static_cast<int32_t>(column.data.size());
+   }
+   if (column.data.size() > static_cast<size_t>(INT32_MAX)) {
+      throw std::runtime_error("The values of column " + column.name + " exceed the 2 GB that 32-bit offsets can address");
+   }
+}
+
+/** Helper function appending column `index` of `chunk` to `column` */
+inline void appendColumn(ColumnarColumn& column, const hyperapi::Chunk& chunk, size_t index, size_t firstRow) {
+   column.validity.resize((firstRow + chunk.getRowCount() + 7) / 8, 0);
+   switch (column.type.getTag()) {
+      case hyperapi::TypeTag::Bool:
+         appendFixedWidth<bool, uint8_t>(column, chunk, index, firstRow, [](bool value) { return static_cast<uint8_t>(value); });
+         break;
+      case hyperapi::TypeTag::SmallInt:
+         appendFixedWidth<int16_t, int16_t>(column, chunk, index, firstRow, [](int16_t value) { return value; });
+         break;
+      case hyperapi::TypeTag::Int:
+         appendFixedWidth<int32_t, int32_t>(column, chunk, index, firstRow, [](int32_t value) { return value; });
+         break;
+      case hyperapi::TypeTag::BigInt:
+         appendFixedWidth<int64_t, int64_t>(column, chunk, index, firstRow, [](int64_t value) { return value; });
+         break;
+      case hyperapi::TypeTag::Oid:
+         appendFixedWidth<uint32_t, uint32_t>(column, chunk, index, firstRow, [](uint32_t value) { return value; });
+         break;
+      case hyperapi::TypeTag::Double:
+         appendFixedWidth<double, double>(column, chunk, index, firstRow, [](double value) { return value; });
+         break;
+      case hyperapi::TypeTag::Date:
+         appendFixedWidth<hyperapi::Date, int32_t>(column, chunk, index, firstRow, [](const hyperapi::Date& value) { return getUnixDays(value); });
+         break;
+      case hyperapi::TypeTag::Time:
+         appendFixedWidth<hyperapi::Time, int64_t>(column, chunk, index, firstRow, [](const hyperapi::Time& value) { return getMicroseconds(value); });
+         break;
+      case hyperapi::TypeTag::Timestamp:
+         appendFixedWidth<hyperapi::Timestamp, int64_t>(
+            column, chunk, index, firstRow, [](const hyperapi::Timestamp& value) { return getUnixMicroseconds(value.getDate(), value.getTime()); });
+         break;
+      case hyperapi::TypeTag::TimestampTZ:
+         appendFixedWidth<hyperapi::OffsetTimestamp, int64_t>(
+            column, chunk, index, firstRow, [](const hyperapi::OffsetTimestamp& value) { return getUnixMicroseconds(value); });
+         break;
+      case hyperapi::TypeTag::Bytes:
+         appendVariable<hyperapi::ByteSpan>(column, chunk, index, firstRow, [](const hyperapi::ByteSpan& value) {
+            return hyperapi::string_view(reinterpret_cast<const char*>(value.data), value.size);
+         });
+         break;
+      default:
+         // The text values are views into the chunk, they are copied into the data buffer.
+         appendVariable<hyperapi::string_view>(column, chunk, index, firstRow, [](hyperapi::string_view value) { return value; });
+         break;
+   }
+}
+}
+
+/**
+ * The rows of a query result, stored column by column.
+ */
+class ColumnarResult {
+   public:
+   /** Creates an empty result with the columns of `schema`. Throws if a column has a type that cannot be read. */
+   explicit ColumnarResult(const hyperapi::ResultSchema& schema) {
+      for (size_t i = 0; i < schema.getColumnCount(); ++i) {
+         columns.emplace_back(schema.getColumn(i).getName().getUnescaped(), schema.getColumn(i).getType());
+         if (columns.back().layout == ColumnarLayout::Variable) {
+            columns.back().offsets.push_back(0);
+         }
+      }
+   }
+
+   /** Appends the rows of `chunk`, one column after the other. */
+   void appendChunk(const hyperapi::Chunk& chunk) {
+      for (size_t i = 0; i < columns.size(); ++i) {
+         detail::appendColumn(columns[i], chunk, i, rowCount);
+      }
+      rowCount += chunk.getRowCount();
+   }
+
+   /** Removes all rows and keeps the capacity of the buffers. */
+   void clear() {
+      for (ColumnarColumn& column : columns) {
+         column.validity.clear();
+         column.nullCount = 0;
+         column.data.clear();
+         column.offsets.resize(column.layout == ColumnarLayout::Variable ? 1 : 0);
+      }
+      rowCount = 0;
+   }
+
+   size_t getRowCount() const { return rowCount; }
+   const std::vector<ColumnarColumn>& getColumns() const { return columns; }
+   const ColumnarColumn& getColumn(size_t index) const { return columns[index]; }
+
+   private:
+   std::vector<ColumnarColumn> columns;
+   size_t rowCount = 0;
+};
+
+/**
+ * Calls `processChunk(columns)` for every chunk of `result`, with the rows of the chunk as a `ColumnarResult`. The
+ * buffers are reused for the next chunk. Returns the number of rows read.
+ */
+template <class Function>
+int64_t readColumnarChunks(hyperapi::Result& result, Function&& processChunk) {
+   ColumnarResult columns(result.getSchema());
+   int64_t rowCount = 0;
+   for (const hyperapi::Chunk& chunk : hyperapi::Chunks(result)) {
+      columns.clear();
+      columns.appendChunk(chunk);
+      processChunk(static_cast<const ColumnarResult&>(columns));
+      rowCount += static_cast<int64_t>(chunk.getRowCount());
+   }
+   return rowCount;
+}
+
+/**
+ * Reads all rows of `result` into one `ColumnarResult`.
+ */
+inline ColumnarResult readColumnar(hyperapi::Result& result) {
+   ColumnarResult columns(result.getSchema());
+   for (const hyperapi::Chunk& chunk : hyperapi::Chunks(result)) {
+      columns.appendChunk(chunk);
+   }
+   return columns;
+}
+}
+
+#endif
@@ -0,0 +1,520 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file compressed_stream.hpp
+ *
+ * Streaming decompression of gzip and zstd files on background threads.
+ *
+ * A `DecompressedBlocks` reads a compressed file and hands out the decompressed data in blocks, in order, while the
+ * next blocks are already being decompressed. A zstd file that consists of several frames, like the files written by
+ * `pzstd` or concatenated from separately compressed parts, is decompressed with one thread per core, one frame per
+ * thread at a time. A gzip file and a zstd file with a single frame can only be decompressed sequentially, but still on
+ * a thread of their own. A `DecompressingInputStream` wraps the blocks into a `std::istream`, e.g., for a `CsvReader`.
+ *
+ * gzip support requires zlib and `TABLEAU_HYPER_SAMPLES_HAVE_ZLIB` to be defined, zstd support requires libzstd and
+ * `TABLEAU_HYPER_SAMPLES_HAVE_ZSTD` to be defined. Uncompressed files are always supported.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_COMPRESSED_STREAM_HPP
+#define TABLEAU_HYPER_SAMPLES_COMPRESSED_STREAM_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace samples {
+
+enum class Compression { None, Gzip, Zstd };
+
+/** Options of `DecompressedBlocks`. */
+struct DecompressionOptions {
+   /// The size of the blocks that are read from the file and of the blocks a sequential decompression produces.
+   size_t blockSize = 1 << 20;
+   /// The number of threads decompressing a zstd file with several frames, 0 for one per core.
+   unsigned threadCount = 0;
+   /// At most this many decompressed blocks are buffered ahead of the reader. For a zstd file with several frames,
+   /// a block is a whole frame.
+   size_t maxBufferedBlocks = 8;
+};
+
+/** Returns the compression of the file at `path` as told by its first bytes. */
+inline Compression detectCompression(const std::string& path) {
+   std::ifstream file(path, std::ios::binary);
+   if (!file) {
+      throw std::runtime_error("Could not open " + path);
+   }
+   unsigned char magic[4] = {0, 0, 0, 0};
+   file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+   if ((magic[0] == 0x1F) && (magic[1] == 0x8B)) {
+      return Compression::Gzip;
+   }
+   if ((magic[0] == 0x28) && (magic[1] == 0xB5) && (magic[2] == 0x2F) && (magic[3] == 0xFD)) {
+      return Compression::Zstd;
+   }
+   return Compression::None;
+}
+
+/** Returns the name of `compression`. */
+inline const char* getCompressionName(Compression compression) {
+   switch (compression) {
+      case Compression::Gzip:
+         return "gzip";
+      case Compression::Zstd:
+         return "zstd";
+      default:
+         return "none";
+   }
+}
+
+namespace detail {
+/** Helper function reading an unsigned little-endian integer of `size` bytes */
+inline uint64_t readLittleEndian(const unsigned char* bytes, size_t size) {
+   uint64_t value = 0;
+   for (size_t i = size; i > 0; --i) {
+      value = (value << 8) | bytes[i - 1];
+   }
+   return value;
+}
+
+/**
+ * Returns the byte ranges [begin, end) of the frames of the zstd file at `path`, without skippable frames.
+ *
+ * Only the frame and block headers are read (see RFC 8878), so finding the frames of a large file is cheap.
+ */
+inline std::vector<std::pair<uint64_t, uint64_t>> findZstdFrames(const std::string& path) {
+   std::ifstream file(path, std::ios::binary);
+   if (!file) {
+      throw std::runtime_error("Could not open " + path);
+   }
+   unsigned char header[4];
+   auto readAt = [&](uint64_t offset, size_t size) {
+      file.clear();
+      file.seekg(static_cast<std::streamoff>(offset));
+      file.read(reinterpret_cast<char*>(header), static_cast<std::streamsize>(size));
+      return static_cast<size_t>(file.gcount());
+   };
+   auto truncated = [&](uint64_t offset) { return std::runtime_error(path + " is truncated or corrupt at offset " + std::to_string(offset)); };
+
+   std::vector<std::pair<uint64_t, uint64_t>> frames;
+   uint64_t offset = 0;
+   for (size_t count; (count = readAt(offset, 4)) > 0;) {
+      if (count < 4) {
+         throw truncated(offset);
+      }
+      uint64_t magic = readLittleEndian(header, 4);
+      if ((magic & 0xFFFFFFF0) == 0x184D2A50) {
+         // A skippable frame holds its size after the magic number.
+         if (readAt(offset + 4, 4) < 4) {
+            throw truncated(offset);
+         }
+         offset += 8 + readLittleEndian(header, 4);
+         continue;
+      }
+      if (magic != 0xFD2FB528) {
+         throw std::runtime_error(path + " contains data that is not a zstd frame at offset " + std::to_string(offset));
+      }
+
+      // The frame header descriptor tells the sizes of the optional fields of the frame header.
+      uint64_t frameBegin = offset;
+      if (readAt(offset + 4, 1) < 1) {
+         throw truncated(offset);
+      }
+      const unsigned descriptor = header[0];
+      const bool isSingleSegment = (descriptor & 0x20) != 0;
+      const bool hasChecksum = (descriptor & 0x04) != 0;
+      const unsigned dictionaryIdSizes[] = {0, 1, 2, 4};
+      const unsigned contentSizeFlag = descriptor >> 6;
+      const unsigned contentSizeSize = (contentSizeFlag == 0) ? (isSingleSegment ? 1 : 0) : (1u << contentSizeFlag);
+      offset += 5 + (isSingleSegment ? 0 : 1) + dictionaryIdSizes[descriptor & 0x03] + contentSizeSize;
+
+      // Every block starts with a 3-byte header holding its type, its size, and whether it is the last block.
+      for (bool isLastBlock = false; !isLastBlock;) {
+         if (readAt(offset, 3) < 3) {
+            throw truncated(offset);
+         }
+         uint64_t blockHeader = readLittleEndian(header, 3);
+         isLastBlock = (blockHeader & 1) != 0;
+         unsigned blockType = (blockHeader >> 1) & 0x03;
+         if (blockType == 3) {
+            throw std::runtime_error(path + " has an invalid zstd block at offset " + std::to_string(offset));
+         }
+         // An RLE block holds a single byte that is repeated `size` times.
+         offset += 3 + ((blockType == 1) ? 1 : (blockHeader >> 3));
+      }
+      offset += hasChecksum ? 4 : 0;
+      frames.emplace_back(frameBegin, offset);
+   }
+   return frames;
+}
+}
+
+/**
+ * Decompresses a file on background threads and hands out the decompressed data in blocks, in order.
+ *
+ * The decompression runs ahead of the reader by at most `maxBufferedBlocks` blocks, so a slow reader slows down the
+ * decompression instead of letting the buffered data grow.
+ */
+class DecompressedBlocks {
+   public:
+   explicit DecompressedBlocks(const std::string& path, const DecompressionOptions& options = {})
+      : path(path), options(options), compression(detectCompression(path)) {
+#ifndef TABLEAU_HYPER_SAMPLES_HAVE_ZLIB
+      if (compression == Compression::Gzip) {
+         throw std::runtime_error(path + " is compressed with gzip, but the samples have been built without zlib.");
+      }
+#endif
+#ifndef TABLEAU_HYPER_SAMPLES_HAVE_ZSTD
+      if (compression == Compression::Zstd) {
+         throw std::runtime_error(path + " is compressed with zstd, but the samples have been built without libzstd.");
+      }
+#endif
+      unsigned threadCount = (options.threadCount > 0) ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+      if (compression == Compression::Zstd) {
+         frames = detail::findZstdFrames(path);
+      }
+      if ((frames.size() > 1) && (threadCount > 1)) {
+         runningThreads = std::min<size_t>(threadCount, frames.size());
+         for (size_t i = 0; i < runningThreads; ++i) {
+            threads.emplace_back([this] { run(&DecompressedBlocks::decompressFrames); });
+         }
+      } else {
+         runningThreads = 1;
+         threads.emplace_back([this] { run(&DecompressedBlocks::decompressSequentially); });
+      }
+   }
+
+   DecompressedBlocks(const DecompressedBlocks&) = delete;
+   DecompressedBlocks& operator=(const DecompressedBlocks&) = delete;
+
+   ~DecompressedBlocks() {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         isStopped = true;
+      }
+      changed.notify_all();
+      for (std::thread& thread : threads) {
+         thread.join();
+      }
+   }
+
+   /**
+    * Moves the next block of decompressed data into `block`, waiting for it if needed.
+    * Returns false at the end of the data, and rethrows the first error of the decompression.
+    */
+   bool read(std::string& block) {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+         changed.wait(lock, [&] { return error || blocks.count(nextToRead) || (runningThreads == 0); });
+         if (error) {
+            std::rethrow_exception(error);
+         }
+         auto it = blocks.find(nextToRead);
+         if (it == blocks.end()) {
+            return false;
+         }
+         block.swap(it->second);
+         blocks.erase(it);
+         ++nextToRead;
+         changed.notify_all();
+         if (!block.empty()) {
+            return true;
+         }
+      }
+   }
+
+   Compression getCompression() const { return compression; }
+
+   /** The number of zstd frames of the file, 0 if the file is not compressed with zstd. */
+   size_t getFrameCount() const { return frames.size(); }
+
+   /** The number of threads decompressing the file. */
+   size_t getThreadCount() const { return threads.size(); }
+
+   private:
+   /** Runs `decompress` on the current thread and records its error. */
+   void run(void (DecompressedBlocks::*decompress)()) {
+      try {
+         (this->*decompress)();
+      } catch (...) {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (!error) {
+            error = std::current_exception();
+         }
+      }
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         --runningThreads;
+      }
+      changed.notify_all();
+   }
+
+   /** Waits until block `sequence` may be buffered. Returns false if the decompression is to stop. */
+   bool waitForSpace(uint64_t sequence) {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&] { return isStopped || error || (sequence < nextToRead + options.maxBufferedBlocks); });
+      return !isStopped && !error;
+   }
+
+   /** Hands block `sequence` to the reader. */
+   void store(uint64_t sequence, std::string block) {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         blocks.emplace(sequence, std::move(block));
+      }
+      changed.notify_all();
+   }
+
+   /** Waits for space for block `sequence`, then hands it to the reader. Returns false if the decompression is to stop. */
+   bool push(uint64_t sequence, std::string block) {
+      if (!waitForSpace(sequence)) {
+         return false;
+      }
+      store(sequence, std::move(block));
+      return true;
+   }
+
+   /** Decompresses the whole file on one thread. */
+   void decompressSequentially() {
+      std::ifstream file(path, std::ios::binary);
+      if (!file) {
+         throw std::runtime_error("Could not open " + path);
+      }
+      std::vector<char> input(options.blockSize);
+      auto readInput = [&] {
+         file.read(input.data(), static_cast<std::streamsize>(input.size()));
+         return static_cast<size_t>(file.gcount());
+      };
+      uint64_t sequence = 0;
+
+      if (compression == Compression::None) {
+         for (size_t count; (count = readInput()) > 0;) {
+            if (!push(sequence++, std::string(input.data(), count))) {
+               return;
+            }
+         }
+         return;
+      }
+
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZLIB
+      if (compression == Compression::Gzip) {
+         z_stream stream = {};
+         // 15 + 32 accepts both gzip and zlib headers with the largest window.
+         if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw std::runtime_error("Could not initialize zlib");
+         }
+         std::unique_ptr<z_stream, int (*)(z_streamp)> guard(&stream, inflateEnd);
+         bool isMemberComplete = false;
+         bool isOutputFull = false;
+         while (true) {
+            // Only read more input once the decompressor has flushed all output for the current input.
+            if ((stream.avail_in == 0) && !isOutputFull) {
+               stream.avail_in = static_cast<uInt>(readInput());
+               stream.next_in = reinterpret_cast<Bytef*>(input.data());
+               if (stream.avail_in == 0) {
+                  break;
+               }
+            }
+            std::string output(options.blockSize, '\0');
+            stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+            stream.avail_out = static_cast<uInt>(output.size());
+            int status = inflate(&stream, Z_NO_FLUSH);
+            isMemberComplete = (status == Z_STREAM_END);
+            if (isMemberComplete) {
+               // A gzip file may consist of several members, e.g., if it has been appended to.
+               inflateReset(&stream);
+            } else if ((status != Z_OK) && (status != Z_BUF_ERROR)) {
+               throw std::runtime_error("Could not decompress " + path + ": " + (stream.msg ? stream.msg : "invalid data"));
+            }
+            // A full output block may hold back more output of the member, but not once the member is complete.
+            // Calling inflate again without input would then return Z_BUF_ERROR and lose the completed member.
+            isOutputFull = !isMemberComplete && (stream.avail_out == 0);
+            output.resize(output.size() - stream.avail_out);
+            if (!output.empty() && !push(sequence++, std::move(output))) {
+               return;
+            }
+         }
+         if (!isMemberComplete) {
+            throw std::runtime_error(path + " is truncated");
+         }
+         return;
+      }
+#endif
+
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZSTD
+      std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)> stream(ZSTD_createDStream(), ZSTD_freeDStream);
+      ZSTD_initDStream(stream.get());
+      ZSTD_inBuffer in = {input.data(), 0, 0};
+      // 0 once a frame is complete. Subsequent frames are decompressed by the same stream.
+      size_t status = 0;
+      bool isOutputFull = false;
+      while (true) {
+         if ((in.pos == in.size) && !isOutputFull) {
+            in.size = readInput();
+            in.pos = 0;
+            if (in.size == 0) {
+               break;
+            }
+         }
+         std::string output(options.blockSize, '\0');
+         ZSTD_outBuffer out = {&output[0], output.size(), 0};
+         status = ZSTD_decompressStream(stream.get(), &out, &in);
+         if (ZSTD_isError(status)) {
+            throw std::runtime_error("Could not decompress " + path + ": " + ZSTD_getErrorName(status));
+         }
+         // A status of 0 means the frame is complete and flushed, even if it filled the output block exactly.
+         isOutputFull = (status != 0) && (out.pos == out.size);
+         output.resize(out.pos);
+         if (!output.empty() && !push(sequence++, std::move(output))) {
+            return;
+         }
+      }
+      if (status != 0) {
+         throw std::runtime_error(path + " is truncated");
+      }
+#endif
+   }
+
+   /** Decompresses one frame after the other until no frame is left. The block of a frame is the whole frame. */
+   void decompressFrames() {
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZSTD
+      std::ifstream file(path, std::ios::binary);
+      if (!file) {
+         throw std::runtime_error("Could not open " + path);
+      }
+      std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)> stream(ZSTD_createDStream(), ZSTD_freeDStream);
+      std::string input;
+      while (true) {
+         size_t frame;
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (isStopped || error || (nextFrame == frames.size())) {
+               return;
+            }
+            frame = nextFrame++;
+         }
+         // Wait before decompressing, so at most `maxBufferedBlocks` frames are held in memory.
+         if (!waitForSpace(frame)) {
+            return;
+         }
+
+         input.resize(static_cast<size_t>(frames[frame].second - frames[frame].first));
+         file.seekg(static_cast<std::streamoff>(frames[frame].first));
+         if (!file.read(&input[0], static_cast<std::streamsize>(input.size()))) {
+            throw std::runtime_error("Could not read " + path);
+         }
+         std::string output;
+         unsigned long long contentSize = ZSTD_getFrameContentSize(input.data(), input.size());
+         if ((contentSize != ZSTD_CONTENTSIZE_UNKNOWN) && (contentSize != ZSTD_CONTENTSIZE_ERROR)) {
+            output.reserve(static_cast<size_t>(contentSize));
+         }
+
+         ZSTD_initDStream(stream.get());
+         ZSTD_inBuffer in = {input.data(), input.size(), 0};
+         size_t status = 1;
+         while (status != 0) {
+            size_t outputBegin = output.size();
+            output.resize(outputBegin + ZSTD_DStreamOutSize());
+            ZSTD_outBuffer out = {&output[outputBegin], ZSTD_DStreamOutSize(), 0};
+            status = ZSTD_decompressStream(stream.get(), &out, &in);
+            if (ZSTD_isError(status)) {
+               throw std::runtime_error("Could not decompress " + path + ": " + ZSTD_getErrorName(status));
+            }
+            output.resize(outputBegin + out.pos);
+            if ((status != 0) && (in.pos == in.size) && (out.pos < out.size)) {
+               throw std::runtime_error(path + " is truncated");
+            }
+         }
+         store(frame, std::move(output));
+      }
+#endif
+   }
+
+   const std::string path;
+   const DecompressionOptions options;
+   const Compression compression;
+   std::vector<std::pair<uint64_t, uint64_t>> frames;
+
+   std::mutex mutex;
+   std::condition_variable changed;
+   /// The decompressed blocks that have not been read yet, by their position in the file.
+   std::map<uint64_t, std::string> blocks;
+   uint64_t nextToRead = 0;
+   size_t nextFrame = 0;
+   size_t runningThreads = 0;
+   std::exception_ptr error;
+   bool isStopped = false;
+   std::vector<std::thread> threads;
+};
+
+namespace detail {
+/** A stream buffer over the blocks of a `DecompressedBlocks`. */
+class DecompressedBlocksBuffer : public std::streambuf {
+   public:
+   explicit DecompressedBlocksBuffer(DecompressedBlocks& blocks) : blocks(blocks) {}
+
+   protected:
+   int_type underflow() override {
+      if (!blocks.read(block)) {
+         return traits_type::eof();
+      }
+      setg(&block[0], &block[0], &block[0] + block.size());
+      return traits_type::to_int_type(block[0]);
+   }
+
+   private:
+   DecompressedBlocks& blocks;
+   std::string block;
+};
+}
+
+/**
+ * An input stream of the decompressed contents of a file.
+ *
+ * Errors of the decompression are rethrown by the reading operation, instead of just ending the stream, as a truncated
+ * file must not look like a complete one. The stream cannot seek.
+ */
+class DecompressingInputStream : public std::istream {
+   public:
+   explicit DecompressingInputStream(const std::string& path, const DecompressionOptions& options = {})
+      : std::istream(nullptr), blocks(path, options), buffer(blocks) {
+      rdbuf(&buffer);
+      exceptions(std::ios::badbit);
+   }
+
+   const DecompressedBlocks& getBlocks() const { return blocks; }
+
+   private:
+   DecompressedBlocks blocks;
+   detail::DecompressedBlocksBuffer buffer;
+};
+}
+
+#endif
@@ -0,0 +1,199 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example create_hyper_file_from_arrow_ipc.cpp
+ *
+ * An example of how to exchange Apache Arrow record batches with Hyper. A query result is exported as Arrow record
+ * batches and written both as an Arrow IPC file and as an Arrow IPC stream. Both are then read back into new tables,
+ * whose definitions are derived from the Arrow schema.
+ */
+
+#include "arrow_interop.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <chrono>
+#include <cstdio>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Helper function returning the seconds elapsed since `start`
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns the query whose result is exported: the line items with the dates of their orders and the categories of
+ * their products.
+ */
+static std::string getSalesQuery() {
+   return "SELECT l." + hyperapi::escapeName("Line Item ID") + ", l." + hyperapi::escapeName("Order ID") + ", o." + hyperapi::escapeName("Order Date") +
+          ", o." + hyperapi::escapeName("Ship Date") + ", o." + hyperapi::escapeName("Ship Mode") + ", p." + hyperapi::escapeName("Category") + ", l." +
+          hyperapi::escapeName("Sales") + ", l." + hyperapi::escapeName("Quantity") + ", l." + hyperapi::escapeName("Discount") + ", l." +
+          hyperapi::escapeName("Profit") + " FROM " + samples::lineItemsTable.getTableName().toString() + " l JOIN " +
+          samples::ordersTable.getTableName().toString() + " o ON l." + hyperapi::escapeName("Order ID") + " = o." + hyperapi::escapeName("Order ID") +
+          " JOIN " + samples::productTable.getTableName().toString() + " p ON l." + hyperapi::escapeName("Product ID") + " = p." +
+          hyperapi::escapeName("Product ID");
+}
+
+/**
+ * Runs `query` and writes its result as an Arrow IPC file to `pathToFile` and as an Arrow IPC stream to
+ * `pathToStream`. Returns the number of rows written.
+ */
+static int64_t exportToArrow(hyperapi::Connection& connection, const std::string& query, const std::string& pathToFile, const std::string& pathToStream) {
+   samples::PhaseTimer queryTimer(samples::Phase::Query);
+   hyperapi::Result result = connection.executeQuery(query);
+   const std::shared_ptr<arrow::Schema> schema = samples::getArrowSchema(result.getSchema());
+   std::shared_ptr<arrow::io::FileOutputStream> file = samples::getArrowValue(arrow::io::FileOutputStream::Open(pathToFile));
+   std::shared_ptr<arrow::ipc::RecordBatchWriter> fileWriter = samples::getArrowValue(arrow::ipc::MakeFileWriter(file, schema));
+   std::shared_ptr<arrow::io::FileOutputStream> stream = samples::getArrowValue(arrow::io::FileOutputStream::Open(pathToStream));
+   std::shared_ptr<arrow::ipc::RecordBatchWriter> streamWriter = samples::getArrowValue(arrow::ipc::MakeStreamWriter(stream, schema));
+
+   int64_t batchCount = 0;
+   int64_t rowCount = samples::readArrowBatches(result, [&](const std::shared_ptr<arrow::RecordBatch>& batch) {
+      samples::checkArrow(fileWriter->WriteRecordBatch(*batch));
+      samples::checkArrow(streamWriter->WriteRecordBatch(*batch));
+      ++batchCount;
+   });
+   // Closing the file writer writes the footer, which tells readers where the batches are.
+   samples::checkArrow(fileWriter->Close());
+   samples::checkArrow(file->Close());
+   samples::checkArrow(streamWriter->Close());
+   samples::checkArrow(stream->Close());
+   std::cout << "Exported " << rowCount << " rows in " << batchCount << " record batches with " << schema->num_fields() << " columns." << std::endl;
+   return rowCount;
+}
+
+/**
+ * Creates a table named `tableName` from the schema of the Arrow IPC file at `path` and inserts its record batches.
+ */
+static int64_t importArrowFile(hyperapi::Connection& connection, const std::string& path, const hyperapi::TableName& tableName) {
+   std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader = samples::openArrowIpcFile(path);
+   const hyperapi::TableDefinition table = samples::getTableDefinition(*reader->schema(), tableName);
+   samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(table); });
+
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   const std::vector<hyperapi::TableDefinition::Column> inserterColumns = samples::getInserterColumns(table);
+   hyperapi::Inserter inserter(connection, table, samples::getInserterMappings(table), inserterColumns);
+   int64_t rowCount = samples::insertRecordBatches(inserter, *reader, inserterColumns);
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+   return rowCount;
+}
+
+/**
+ * Creates a table named `tableName` from the schema of the Arrow IPC stream at `path` and inserts its record batches
+ * as they are read.
+ */
+static int64_t importArrowStream(hyperapi::Connection& connection, const std::string& path, const hyperapi::TableName& tableName) {
+   std::shared_ptr<arrow::ipc::RecordBatchStreamReader> reader = samples::openArrowIpcStream(path);
+   const hyperapi::TableDefinition table = samples::getTableDefinition(*reader->schema(), tableName);
+   samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(table); });
+
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   const std::vector<hyperapi::TableDefinition::Column> inserterColumns = samples::getInserterColumns(table);
+   hyperapi::Inserter inserter(connection, table, samples::getInserterMappings(table), inserterColumns);
+   int64_t rowCount = samples::insertRecordBatches(inserter, *reader, inserterColumns);
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+   return rowCount;
+}
+
+static void runCreateHyperFileFromArrowIPC() {
+   std::cout << "EXAMPLE - Export query results as Arrow record batches and insert Arrow IPC files" << std::endl;
+   const std::string pathToDatabase = "data/arrow_ipc.hyper";
+   const std::string pathToFile = "data/sales.arrow";
+   const std::string pathToStream = "data/sales.arrows";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "arrow_ipc.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         const std::string query = getSalesQuery();
+         auto start = std::chrono::steady_clock::now();
+         int64_t exportedRows = exportToArrow(connection, query, pathToFile, pathToStream);
+         double exportSeconds = secondsSince(start);
+
+         start = std::chrono::steady_clock::now();
+         int64_t fileRows = importArrowFile(connection, pathToFile, hyperapi::TableName("Sales From Arrow File"));
+         double fileSeconds = secondsSince(start);
+         start = std::chrono::steady_clock::now();
+         int64_t streamRows = importArrowStream(connection, pathToStream, hyperapi::TableName("Sales From Arrow Stream"));
+         double streamSeconds = secondsSince(start);
+
+         std::cout << "Exported to Arrow:        " << exportedRows << " rows in " << exportSeconds << " s ("
+                   << static_cast<int64_t>(exportedRows / exportSeconds) << " rows/s)" << std::endl;
+         std::cout << "Inserted the IPC file:    " << fileRows << " rows in " << fileSeconds << " s (" << static_cast<int64_t>(fileRows / fileSeconds)
+                   << " rows/s)" << std::endl;
+         std::cout << "Inserted the IPC stream:  " << streamRows << " rows in " << streamSeconds << " s ("
+                   << static_cast<int64_t>(streamRows / streamSeconds) << " rows/s)" << std::endl;
+
+         // Both tables must contain the rows of the query.
+         for (const std::string& table : {std::string("Sales From Arrow File"), std::string("Sales From Arrow Stream")}) {
+            const std::string imported = hyperapi::escapeName(table);
+            int64_t differentRows = samples::timePhase(samples::Phase::Query, [&] {
+               return connection.executeScalarQuery<int64_t>(
+                  "SELECT COUNT(*) FROM ((" + query + " EXCEPT ALL SELECT * FROM " + imported + ") UNION ALL (SELECT * FROM " + imported +
+                  " EXCEPT ALL " + query + ")) AS differences");
+            });
+            if (differentRows != 0) {
+               throw std::runtime_error("The table " + imported + " does not contain the rows of the query.");
+            }
+         }
+         if ((fileRows != exportedRows) || (streamRows != exportedRows)) {
+            throw std::runtime_error("The number of inserted rows does not match the number of exported rows.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+
+   std::remove(pathToFile.c_str());
+   std::remove(pathToStream.c_str());
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
+   try {
+      runCreateHyperFileFromArrowIPC();
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,263 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example create_hyper_file_from_compressed_csv.cpp
+ *
+ * An example of how to load gzip and zstd compressed CSV files without decompressing them to disk first. The files are
+ * decompressed on background threads while the records are parsed and sent to Hyper with an `Inserter`. For
+ * comparison, the files are also decompressed to a temporary file that is loaded with COPY.
+ */
+
+#include "compressed_stream.hpp"
+#include "csv_reader.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/**
+ * Helper function returning the seconds elapsed since `start`
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns the contents of the CSV file at `path` with its records repeated `repeatCount` times, to get a file large
+ * enough to measure.
+ */
+static std::string readRepeated(const std::string& path, int repeatCount) {
+   std::ifstream file(path, std::ios::binary);
+   if (!file) {
+      throw std::runtime_error("Could not open " + path);
+   }
+   std::ostringstream contents;
+   contents << file.rdbuf();
+   const std::string original = contents.str();
+   const std::string records = original.substr(original.find('\n') + 1);
+   std::string repeated = original;
+   for (int i = 1; i < repeatCount; ++i) {
+      repeated += records;
+   }
+   return repeated;
+}
+
+/**
+ * Writes `data` as a gzip file.
+ */
+static void writeGzip(const std::string& data, const std::string& path) {
+   gzFile file = gzopen(path.c_str(), "wb");
+   if (!file) {
+      throw std::runtime_error("Could not create " + path);
+   }
+   bool isWritten = (gzwrite(file, data.data(), static_cast<unsigned>(data.size())) == static_cast<int>(data.size()));
+   if ((gzclose(file) != Z_OK) || !isWritten) {
+      throw std::runtime_error("Could not write " + path);
+   }
+}
+
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZSTD
+/**
+ * Writes `data` as a zstd file with one frame per `frameSize` bytes of `data`, so it can be decompressed in parallel.
+ */
+static void writeZstdFrames(const std::string& data, const std::string& path, size_t frameSize) {
+   std::ofstream file(path, std::ios::binary);
+   std::vector<char> frame(ZSTD_compressBound(frameSize));
+   for (size_t begin = 0; begin < data.size(); begin += frameSize) {
+      size_t size = ZSTD_compress(frame.data(), frame.size(), data.data() + begin, std::min(frameSize, data.size() - begin), 3);
+      if (ZSTD_isError(size)) {
+         throw std::runtime_error(std::string("Could not compress ") + path + ": " + ZSTD_getErrorName(size));
+      }
+      file.write(frame.data(), static_cast<std::streamsize>(size));
+   }
+   if (!file) {
+      throw std::runtime_error("Could not write " + path);
+   }
+}
+#endif
+
+/**
+ * Helper function returning the orders table as `name` in `schema`
+ */
+static hyperapi::TableDefinition getOrdersTable(const hyperapi::SchemaName& schema, const std::string& name) {
+   hyperapi::TableDefinition table(samples::ordersTable);
+   table.setTableName(hyperapi::TableName(schema, name));
+   return table;
+}
+
+/**
+ * The way it is done without streaming: Decompresses the file at `path` to a temporary file and loads that with COPY.
+ */
+static int64_t loadStaged(hyperapi::Connection& connection, const std::string& path, const hyperapi::TableDefinition& table) {
+   const std::string pathToDecompressed = "data/orders_decompressed.csv";
+   {
+      samples::DecompressedBlocks blocks(path);
+      std::ofstream file(pathToDecompressed, std::ios::binary);
+      std::string block;
+      while (blocks.read(block)) {
+         file.write(block.data(), static_cast<std::streamsize>(block.size()));
+      }
+      if (!file) {
+         throw std::runtime_error("Could not write " + pathToDecompressed);
+      }
+   }
+   int64_t rowCount = samples::timePhase(samples::Phase::Execute, [&] {
+      return connection.executeCommand(
+         "COPY " + table.getTableName().toString() + " from " + hyperapi::escapeStringLiteral(pathToDecompressed) +
+         " with (format csv, delimiter ',', header)");
+   });
+   std::remove(pathToDecompressed.c_str());
+   return rowCount;
+}
+
+/**
+ * Decompresses the file at `path` on background threads, while the records are parsed and inserted into `table`.
+ */
+static int64_t loadStreamed(hyperapi::Connection& connection, const std::string& path, const hyperapi::TableDefinition& table) {
+   samples::DecompressingInputStream input(path);
+   const samples::DecompressedBlocks& blocks = input.getBlocks();
+   std::cout << "Decompressing " << path << " (" << samples::getCompressionName(blocks.getCompression());
+   if (blocks.getFrameCount() > 0) {
+      std::cout << ", " << blocks.getFrameCount() << " frames";
+   }
+   std::cout << ") with " << blocks.getThreadCount() << " threads." << std::endl;
+   samples::CsvReader reader(input);
+   std::vector<std::string> fields;
+   reader.readRecord(fields);
+
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   hyperapi::Inserter inserter(connection, table);
+   int64_t rowCount = 0;
+   while (reader.readRecord(fields)) {
+      for (size_t i = 0; i < table.getColumnCount(); ++i) {
+         samples::addCsvValue(inserter, table.getColumn(i), fields.at(i));
+      }
+      inserter.endRow();
+      ++rowCount;
+   }
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+   return rowCount;
+}
+
+static void runCreateHyperFileFromCompressedCSV(int repeatCount) {
+   std::cout << "EXAMPLE - Load compressed CSV files with streaming decompression" << std::endl;
+   const std::string pathToDatabase = "data/compressed_csv.hyper";
+   const std::string pathToCSV = "data/orders.csv";
+   const hyperapi::SchemaName stagedSchema("Staged");
+   const hyperapi::SchemaName streamedSchema("Streamed");
+
+   // Write compressed copies of the orders, the zstd file with several frames.
+   const std::string data = readRepeated(pathToCSV, repeatCount);
+   std::vector<std::string> compressedPaths = {"data/orders.csv.gz"};
+   writeGzip(data, compressedPaths.back());
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_ZSTD
+   compressedPaths.push_back("data/orders.csv.zst");
+   writeZstdFrames(data, compressedPaths.back(), 256 * 1024);
+#else
+   std::cout << "The samples have been built without libzstd, only the gzip file is loaded." << std::endl;
+#endif
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "compressed_csv.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::timePhase(samples::Phase::DDL, [&] {
+            connection.getCatalog().createSchema(stagedSchema);
+            connection.getCatalog().createSchema(streamedSchema);
+         });
+
+         for (const std::string& path : compressedPaths) {
+            const std::string name = std::string("Orders ") + samples::getCompressionName(samples::detectCompression(path));
+            const hyperapi::TableDefinition stagedTable = getOrdersTable(stagedSchema, name);
+            const hyperapi::TableDefinition streamedTable = getOrdersTable(streamedSchema, name);
+            samples::timePhase(samples::Phase::DDL, [&] {
+               connection.getCatalog().createTable(stagedTable);
+               connection.getCatalog().createTable(streamedTable);
+            });
+
+            auto start = std::chrono::steady_clock::now();
+            int64_t stagedRows = loadStaged(connection, path, stagedTable);
+            double stagedSeconds = secondsSince(start);
+            start = std::chrono::steady_clock::now();
+            int64_t streamedRows = loadStreamed(connection, path, streamedTable);
+            double streamedSeconds = secondsSince(start);
+
+            std::cout << path << ":" << std::endl;
+            std::cout << "  Decompressed to disk, then COPY: " << stagedRows << " rows in " << stagedSeconds << " s" << std::endl;
+            std::cout << "  Streamed into an Inserter:       " << streamedRows << " rows in " << streamedSeconds << " s" << std::endl;
+
+            // Both tables must contain the same rows.
+            const std::string staged = stagedTable.getTableName().toString();
+            const std::string streamed = streamedTable.getTableName().toString();
+            int64_t differentRows = samples::timePhase(samples::Phase::Query, [&] {
+               return connection.executeScalarQuery<int64_t>(
+                  "SELECT COUNT(*) FROM ((SELECT * FROM " + staged + " EXCEPT ALL SELECT * FROM " + streamed + ") UNION ALL (SELECT * FROM " + streamed +
+                  " EXCEPT ALL SELECT * FROM " + staged + ")) AS differences");
+            });
+            if ((stagedRows != streamedRows) || (differentRows != 0)) {
+               throw std::runtime_error("The streamed load of " + path + " inserted different rows.");
+            }
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+
+   for (const std::string& path : compressedPaths) {
+      std::remove(path.c_str());
+   }
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, how many times the records of the orders are repeated in the compressed files can be passed on the
+   // command line.
+   int repeatCount = arguments.empty() ? 20 : std::atoi(arguments[0].c_str());
+   try {
+      runCreateHyperFileFromCompressedCSV(repeatCount);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
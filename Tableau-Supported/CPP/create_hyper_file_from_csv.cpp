@@ -15,6 +15,8 @@
  * An example of how to load data from a CSV file into a new Hyper file.
  */
 
+#include "instrumentation.hpp"
+
 #include <hyperapi/hyperapi.hpp>
 #include <iostream>
 #include <string>
@@ -43,7 +45,9 @@ static void runCreateHyperFileFromCSV() {
          // Limits the size of Hyper event log files to 100 megabytes.
          {"log_file_size_limit", "100M"}};
 
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
       hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau, "example", processParameters);
+      startupTimer.stop();
       // Creates new Hyper file "customer.hyper".
       // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
       {
@@ -51,10 +55,12 @@ static void runCreateHyperFileFromCSV() {
          // (https://help.tableau.com/current/api/hyper_api/en-us/reference/sql/connectionsettings.html).
          std::unordered_map<std::string, std::string> connectionParameters = {{"lc_time", "en_US"}};
 
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
          hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, connectionParameters);
+         connectTimer.stop();
          const hyperapi::Catalog& catalog = connection.getCatalog();
 
-         catalog.createTable(customerTable);
+         samples::timePhase(samples::Phase::DDL, [&] { catalog.createTable(customerTable); });
 
          // Using path to current file, create a path that locates CSV file packaged with these examples.
          std::string pathToCSV = "data/customers.csv";
@@ -73,23 +79,29 @@ static void runCreateHyperFileFromCSV() {
          // (https:#help.tableau.com/current/api/hyper_api/en-us/reference/sql/sql-copy.html).
          std::cout << "Issuing the SQL COPY command to load the csv file into the table. Since the first line" << std::endl;
          std::cout << "of our csv file contains the column names, we use the `header` option to skip it." << std::endl;
-         int64_t rowCount = connection.executeCommand(
-            "COPY " + customerTable.getTableName().toString() + " from " + hyperapi::escapeStringLiteral(pathToCSV) +
-            " with (format csv, NULL 'NULL', delimiter ',', header)");
+         int64_t rowCount = samples::timePhase(samples::Phase::Execute, [&] {
+            return connection.executeCommand(
+               "COPY " + customerTable.getTableName().toString() + " from " + hyperapi::escapeStringLiteral(pathToCSV) +
+               " with (format csv, NULL 'NULL', delimiter ',', header)");
+         });
 
          std::cout << "The number of rows in table " << customerTable.getTableName() << " is " << rowCount << "." << std::endl;
       }
       std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
    }
    std::cout << "The Hyper Process has been shut down." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
    try {
       runCreateHyperFileFromCSV();
    } catch (const hyperapi::HyperException& e) {
       std::cout << e.toString() << std::endl;
       return 1;
    }
+   samples::reportMetrics(metricsFormat);
    return 0;
 }
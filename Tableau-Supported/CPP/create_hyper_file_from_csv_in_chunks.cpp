@@ -0,0 +1,211 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example create_hyper_file_from_csv_in_chunks.cpp
+ *
+ * An example of how to load a CSV file in chunks that are recorded in a manifest table, so that a load that failed
+ * halfway through only has to load the remaining chunks when it is run again.
+ */
+
+#include "csv_chunks.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** Records the byte ranges of the source files that have been loaded completely. */
+static const hyperapi::TableDefinition chunkManifestTable{
+   "Chunk Manifest",
+   {hyperapi::TableDefinition::Column{"Source", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Source Size", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Chunk Begin", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Chunk End", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Row Count", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable}}};
+
+typedef samples::CsvChunk Chunk;
+
+/** Thrown to simulate a failure of the load. */
+struct SimulatedFailure : std::runtime_error {
+   SimulatedFailure() : std::runtime_error("Simulated failure") {}
+};
+
+/**
+ * Returns the parts of `chunks` that are not covered by the byte ranges in `loadedRanges`.
+ *
+ * The loaded ranges may come from a run with a different chunk size, so their boundaries do not have to match the
+ * boundaries of `chunks`. Both end at record boundaries, so the remaining parts contain complete records only.
+ */
+static std::vector<Chunk> removeLoadedRanges(const std::vector<Chunk>& chunks, std::vector<Chunk> loadedRanges) {
+   std::sort(loadedRanges.begin(), loadedRanges.end());
+   std::vector<Chunk> remaining;
+   for (const Chunk& chunk : chunks) {
+      uint64_t begin = chunk.first;
+      for (const Chunk& range : loadedRanges) {
+         if ((range.second <= begin) || (range.first >= chunk.second)) {
+            continue;
+         }
+         if (range.first > begin) {
+            remaining.emplace_back(begin, range.first);
+         }
+         begin = std::max(begin, range.second);
+      }
+      if (begin < chunk.second) {
+         remaining.emplace_back(begin, chunk.second);
+      }
+   }
+   return remaining;
+}
+
+/**
+ * Loads all byte ranges of `pathToCSV` into `table` that are not yet recorded in the manifest.
+ *
+ * Every chunk is loaded with its own COPY and recorded in the manifest in the same transaction, so a chunk is either
+ * loaded and recorded or neither. If `failAfterChunks` is positive, the load fails after loading that many chunks.
+ */
+static void loadChunks(
+   hyperapi::Connection& connection, const hyperapi::TableDefinition& table, const std::string& pathToCSV, uint64_t chunkSize, int failAfterChunks = 0) {
+   const hyperapi::Catalog& catalog = connection.getCatalog();
+   samples::PhaseTimer ddlTimer(samples::Phase::DDL);
+   catalog.createTableIfNotExists(table);
+   catalog.createTableIfNotExists(chunkManifestTable);
+   ddlTimer.stop();
+
+   uint64_t fileSize = 0;
+   std::vector<Chunk> chunks = samples::splitCsvIntoChunks(pathToCSV, chunkSize, fileSize);
+
+   // Read the byte ranges that have already been loaded. If the file changed since then, the manifest cannot be trusted.
+   std::vector<Chunk> loadedRanges;
+   {
+      samples::PhaseTimer queryTimer(samples::Phase::Query);
+      hyperapi::Result result = connection.executeQuery(
+         "SELECT " + hyperapi::escapeName("Source Size") + ", " + hyperapi::escapeName("Chunk Begin") + ", " + hyperapi::escapeName("Chunk End") +
+         " FROM " + chunkManifestTable.getTableName().toString() + " WHERE " + hyperapi::escapeName("Source") + " = " +
+         hyperapi::escapeStringLiteral(pathToCSV));
+      for (const hyperapi::Row& row : result) {
+         if (static_cast<uint64_t>(row.get<int64_t>(0)) != fileSize) {
+            throw std::runtime_error(pathToCSV + " has changed since it was partially loaded");
+         }
+         loadedRanges.emplace_back(static_cast<uint64_t>(row.get<int64_t>(1)), static_cast<uint64_t>(row.get<int64_t>(2)));
+      }
+   }
+   // A previous run may have used a different chunk size, so the loaded ranges are cut out of the chunks of this run.
+   std::vector<Chunk> remainingChunks = removeLoadedRanges(chunks, loadedRanges);
+   if (!loadedRanges.empty()) {
+      std::cout << "Skipping " << loadedRanges.size() << " chunks that have already been loaded, " << remainingChunks.size() << " chunks remain."
+                << std::endl;
+   }
+
+   // COPY reads from a file, so every chunk is written to a file of its own first.
+   const std::string pathToChunk = pathToCSV + ".chunk";
+   int loadedCount = 0;
+   try {
+      for (const Chunk& chunk : remainingChunks) {
+         if ((failAfterChunks > 0) && (loadedCount == failAfterChunks)) {
+            throw SimulatedFailure();
+         }
+         samples::copyFileRange(pathToCSV, chunk, pathToChunk);
+
+         samples::PhaseTimer executeTimer(samples::Phase::Execute);
+         connection.executeCommand("BEGIN TRANSACTION");
+         try {
+            int64_t rowCount = connection.executeCommand(
+               "COPY " + table.getTableName().toString() + " from " + hyperapi::escapeStringLiteral(pathToChunk) +
+               " with (format csv, NULL 'NULL', delimiter ',')");
+            hyperapi::Inserter inserter(connection, chunkManifestTable);
+            inserter.addRow(pathToCSV, static_cast<int64_t>(fileSize), static_cast<int64_t>(chunk.first), static_cast<int64_t>(chunk.second), rowCount);
+            inserter.execute();
+            connection.executeCommand("COMMIT");
+         } catch (...) {
+            // A failing ROLLBACK must not hide the exception that aborted the transaction.
+            try {
+               connection.executeCommand("ROLLBACK");
+            } catch (const hyperapi::HyperException&) {
+            }
+            throw;
+         }
+         ++loadedCount;
+      }
+   } catch (...) {
+      std::remove(pathToChunk.c_str());
+      throw;
+   }
+   std::remove(pathToChunk.c_str());
+   std::cout << "Loaded " << loadedCount << " chunks of " << pathToCSV << "." << std::endl;
+}
+
+static void runCreateHyperFileFromCSVInChunks(uint64_t chunkSize) {
+   std::cout << "EXAMPLE - Load data from CSV into a table in resumable chunks" << std::endl;
+   const std::string pathToDatabase = "data/customer_chunked.hyper";
+   const std::string pathToCSV = "data/customers.csv";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // The first attempt fails after three chunks.
+      try {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         loadChunks(connection, samples::customerTable, pathToCSV, chunkSize, 3);
+      } catch (const SimulatedFailure& e) {
+         std::cout << e.what() << " while loading " << pathToCSV << "." << std::endl;
+      }
+
+      // Running the load again only loads the remaining bytes, even with a different chunk size.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
+         loadChunks(connection, samples::customerTable, pathToCSV, chunkSize * 3);
+
+         int64_t rowCount = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + samples::customerTable.getTableName().toString());
+         int64_t distinctCount = connection.executeScalarQuery<int64_t>(
+            "SELECT COUNT(DISTINCT " + hyperapi::escapeName("Customer ID") + ") FROM " + samples::customerTable.getTableName().toString());
+         std::cout << "The number of rows in table " << samples::customerTable.getTableName() << " is " << rowCount << "." << std::endl;
+         if (rowCount != distinctCount) {
+            throw std::runtime_error("A chunk has been loaded twice.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the chunk size in bytes can be passed on the command line.
+   uint64_t chunkSize = arguments.empty() ? 4096 : std::strtoull(arguments[0].c_str(), nullptr, 10);
+   try {
+      runCreateHyperFileFromCSVInChunks(chunkSize);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,240 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example create_hyper_file_from_csv_in_parallel.cpp
+ *
+ * An example of how to validate a CSV file before loading it, and how to load it with several COPY commands in
+ * parallel. A single scan finds the malformed records with their line numbers and the record boundaries the file can
+ * be split at.
+ */
+
+#include "csv_index.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Helper function returning the table worker `worker` loads its chunks into
+ */
+static hyperapi::TableDefinition getWorkerTable(int worker) {
+   hyperapi::TableDefinition table(samples::lineItemsTable);
+   table.setTableName(hyperapi::TableName("Line Items Part " + std::to_string(worker)));
+   return table;
+}
+
+/**
+ * Indexes the CSV file at `path` and prints how long it took.
+ */
+static samples::CsvIndex indexFile(const std::string& path, const samples::CsvIndexOptions& options) {
+   auto start = std::chrono::steady_clock::now();
+   samples::CsvIndex index = samples::indexCsv(path, options);
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   std::cout << "Indexed " << index.recordCount << " records of " << path << " in " << 1000 * seconds << " ms ("
+             << static_cast<double>(index.fileSize) / seconds / 1e9 << " GB/s, " << (index.usedAvx2 ? "AVX2" : "scalar") << ")." << std::endl;
+   return index;
+}
+
+/**
+ * Writes a copy of the CSV file at `sourcePath` to `destinationPath` in which three records are malformed: one has a
+ * field too few, one a field too many, and one opens a quote that is never closed.
+ */
+static void writeCorruptedCopy(const std::string& sourcePath, const std::string& destinationPath) {
+   std::ifstream source(sourcePath, std::ios::binary);
+   std::ofstream destination(destinationPath, std::ios::binary);
+   if (!source || !destination) {
+      throw std::runtime_error("Could not copy " + sourcePath + " to " + destinationPath);
+   }
+   std::string line;
+   for (uint64_t lineNumber = 1; std::getline(source, line); ++lineNumber) {
+      if (lineNumber == 5000) {
+         line.erase(0, line.find(',') + 1);
+      } else if (lineNumber == 7001) {
+         line.insert(0, "0,0,");
+      } else if (lineNumber == 9002) {
+         line.insert(0, "\"");
+      }
+      destination << line << '\n';
+   }
+}
+
+/** Removes a file when it goes out of scope, also if an exception is thrown. */
+struct RemoveFileOnExit {
+   explicit RemoveFileOnExit(std::string path) : path(std::move(path)) {}
+   RemoveFileOnExit(const RemoveFileOnExit&) = delete;
+   RemoveFileOnExit& operator=(const RemoveFileOnExit&) = delete;
+   ~RemoveFileOnExit() { std::remove(path.c_str()); }
+
+   const std::string path;
+};
+
+/**
+ * Loads `chunks` of the CSV file at `pathToCSV` into the table of worker `worker`, one COPY per chunk.
+ */
+static void runWorker(
+   const hyperapi::Endpoint& endpoint, const std::string& pathToDatabase, int worker, const std::string& pathToCSV,
+   const std::vector<samples::CsvChunk>& chunks) {
+   hyperapi::Connection connection(endpoint, pathToDatabase);
+   const std::string table = getWorkerTable(worker).getTableName().toString();
+   // COPY reads from a file, so every chunk is written to a file of its own first. This doubles the disk I/O of the
+   // load: the index saves the workers from scanning for record boundaries, not from this copy.
+   RemoveFileOnExit chunkFile(pathToCSV + ".part" + std::to_string(worker));
+   const std::string& pathToChunk = chunkFile.path;
+   for (const samples::CsvChunk& chunk : chunks) {
+      samples::copyFileRange(pathToCSV, chunk, pathToChunk);
+      // The columns of "lineitems.csv" are ordered alphabetically, so they are listed explicitly. The chunks have no header.
+      samples::timePhase(samples::Phase::Execute, [&] {
+         connection.executeCommand(
+            "COPY " + table + " (" + hyperapi::escapeName("Discount") + ", " + hyperapi::escapeName("Line Item ID") + ", " +
+            hyperapi::escapeName("Order ID") + ", " + hyperapi::escapeName("Product ID") + ", " + hyperapi::escapeName("Profit") + ", " +
+            hyperapi::escapeName("Quantity") + ", " + hyperapi::escapeName("Sales") + ") from " + hyperapi::escapeStringLiteral(pathToChunk) +
+            " with (format csv, delimiter ',')");
+      });
+   }
+}
+
+static void runCreateHyperFileFromCSVInParallel(uint64_t checkpointInterval, int workerCount) {
+   std::cout << "EXAMPLE - Validate a CSV file and load it with parallel COPY commands" << std::endl;
+   const std::string pathToDatabase = "data/lineitems_parallel.hyper";
+   const std::string pathToCSV = "data/lineitems.csv";
+   const std::string pathToCorruptedCSV = "data/lineitems_corrupted.csv";
+
+   samples::CsvIndexOptions options;
+   options.checkpointInterval = checkpointInterval;
+
+   // A malformed file is rejected before anything is sent to Hyper.
+   writeCorruptedCopy(pathToCSV, pathToCorruptedCSV);
+   samples::CsvIndex corruptedIndex = indexFile(pathToCorruptedCSV, options);
+   for (const samples::CsvError& error : corruptedIndex.errors) {
+      std::cout << "  Line " << error.lineNumber << ": ";
+      if (error.fieldCount == 0) {
+         std::cout << "unterminated quoted field" << std::endl;
+      } else {
+         std::cout << error.fieldCount << " fields instead of " << corruptedIndex.headerFieldCount << std::endl;
+      }
+   }
+   if (!corruptedIndex.isValid()) {
+      std::cout << "Skipping " << pathToCorruptedCSV << ", it has " << corruptedIndex.errorCount << " malformed records." << std::endl;
+   }
+   std::remove(pathToCorruptedCSV.c_str());
+
+   samples::CsvIndex index = indexFile(pathToCSV, options);
+   if (!index.isValid()) {
+      throw std::runtime_error(pathToCSV + " has " + std::to_string(index.errorCount) + " malformed records.");
+   }
+
+   // Deal the chunks out to the workers in turns.
+   std::vector<samples::CsvChunk> chunks = index.getChunks();
+   workerCount = std::max(1, std::min(workerCount, static_cast<int>(chunks.size())));
+   std::vector<std::vector<samples::CsvChunk>> workerChunks(static_cast<size_t>(workerCount));
+   for (size_t i = 0; i < chunks.size(); ++i) {
+      workerChunks[i % workerChunks.size()].push_back(chunks[i]);
+   }
+   std::cout << "Loading " << chunks.size() << " chunks with " << workerCount << " workers." << std::endl;
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "lineitems_parallel.hyper" with one table per worker. The tables are created upfront, so
+      // the workers do not change the catalog concurrently.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         samples::PhaseTimer ddlTimer(samples::Phase::DDL);
+         for (int worker = 0; worker < workerCount; ++worker) {
+            connection.getCatalog().createTable(getWorkerTable(worker));
+         }
+      }
+
+      // Run the workers. An exception of a worker is rethrown after all workers have finished.
+      std::vector<std::thread> workers;
+      std::vector<std::exception_ptr> errors(static_cast<size_t>(workerCount));
+      for (int worker = 0; worker < workerCount; ++worker) {
+         workers.emplace_back([&, worker] {
+            try {
+               runWorker(hyper.getEndpoint(), pathToDatabase, worker, pathToCSV, workerChunks[static_cast<size_t>(worker)]);
+            } catch (...) {
+               errors[static_cast<size_t>(worker)] = std::current_exception();
+            }
+         });
+      }
+      for (std::thread& worker : workers) {
+         worker.join();
+      }
+      for (const std::exception_ptr& error : errors) {
+         if (error) {
+            std::rethrow_exception(error);
+         }
+      }
+
+      // Combine the parts into one table.
+      {
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(samples::lineItemsTable); });
+         std::string parts;
+         for (int worker = 0; worker < workerCount; ++worker) {
+            parts += (parts.empty() ? "SELECT * FROM " : " UNION ALL SELECT * FROM ") + getWorkerTable(worker).getTableName().toString();
+         }
+         int64_t rowCount = samples::timePhase(
+            samples::Phase::Execute, [&] { return connection.executeCommand("INSERT INTO " + samples::lineItemsTable.getTableName().toString() + " " + parts); });
+         samples::timePhase(samples::Phase::DDL, [&] {
+            for (int worker = 0; worker < workerCount; ++worker) {
+               connection.executeCommand("DROP TABLE " + getWorkerTable(worker).getTableName().toString());
+            }
+         });
+
+         std::cout << "The number of rows in table " << samples::lineItemsTable.getTableName() << " is " << rowCount << "." << std::endl;
+         if (static_cast<uint64_t>(rowCount) != index.recordCount) {
+            throw std::runtime_error("The number of rows does not match the number of records in the index.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the checkpoint interval in bytes and the number of workers can be passed on the command line.
+   uint64_t checkpointInterval = (arguments.size() > 0) ? std::strtoull(arguments[0].c_str(), nullptr, 10) : 64 * 1024;
+   int workerCount = (arguments.size() > 1) ? std::atoi(arguments[1].c_str()) : std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+   try {
+      runCreateHyperFileFromCSVInParallel(checkpointInterval, workerCount);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
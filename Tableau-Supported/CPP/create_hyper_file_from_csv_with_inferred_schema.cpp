@@ -0,0 +1,110 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example create_hyper_file_from_csv_with_inferred_schema.cpp
+ *
+ * An example of how to load CSV files into a new Hyper file without writing their table definitions by hand.
+ * The definitions are inferred from a sample of the records of each file.
+ */
+
+#include "csv_schema_inference.hpp"
+#include "instrumentation.hpp"
+
+#include <chrono>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Helper function returning the file name of `path` without its directory and extension
+ */
+static std::string getFileStem(const std::string& path) {
+   size_t nameBegin = path.find_last_of("/\\");
+   nameBegin = (nameBegin == std::string::npos) ? 0 : nameBegin + 1;
+   size_t nameEnd = path.find_last_of('.');
+   return path.substr(nameBegin, ((nameEnd == std::string::npos) || (nameEnd < nameBegin)) ? std::string::npos : nameEnd - nameBegin);
+}
+
+static void runCreateHyperFileFromCsvWithInferredSchema(const std::vector<std::string>& csvPaths) {
+   std::cout << "EXAMPLE - Load CSV files into tables with inferred definitions" << std::endl;
+   const std::string pathToDatabase = "data/inferred_schema.hyper";
+
+   // Infer the table definitions before connecting, as month/day/year dates require a connection setting.
+   std::vector<samples::InferredSchema> schemas;
+   bool hasMonthDayYearDates = false;
+   for (const std::string& path : csvPaths) {
+      auto start = std::chrono::steady_clock::now();
+      schemas.push_back(samples::inferCsvSchema(path, hyperapi::TableName(getFileStem(path))));
+      double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      const samples::InferredSchema& schema = schemas.back();
+      hasMonthDayYearDates = hasMonthDayYearDates || schema.hasMonthDayYearDates;
+
+      std::cout << "Inferred " << schema.table.getTableName() << " from " << schema.sampledRows << " records of " << path << " in " << milliseconds
+                << " ms:" << std::endl;
+      for (const hyperapi::TableDefinition::Column& column : schema.table.getColumns()) {
+         std::cout << "  " << column.getName() << " " << column.getType()
+                   << ((column.getNullability() == hyperapi::Nullability::NotNullable) ? " NOT NULL" : "") << std::endl;
+      }
+   }
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "inferred_schema.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         std::unordered_map<std::string, std::string> connectionParameters;
+         if (hasMonthDayYearDates) {
+            connectionParameters["date_style"] = "MDY";
+         }
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, connectionParameters);
+         connectTimer.stop();
+
+         for (size_t i = 0; i < schemas.size(); ++i) {
+            samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(schemas[i].table); });
+            int64_t rowCount =
+               samples::timePhase(samples::Phase::Execute, [&] { return connection.executeCommand(schemas[i].getCopyCommand(csvPaths[i])); });
+            std::cout << "The number of rows in table " << schemas[i].table.getTableName() << " is " << rowCount << "." << std::endl;
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the CSV files can be passed on the command line.
+   if (arguments.empty()) {
+      arguments = {"data/calcs.csv", "data/Starbucks.csv", "data/Batters.csv", "data/superstore.csv", "data/shunting_report.csv"};
+   }
+   try {
+      runCreateHyperFileFromCsvWithInferredSchema(arguments);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,151 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example create_hyper_file_from_named_pipe.cpp
+ *
+ * An example of how to load CSV data from a live producer with COPY through a named pipe, without writing it to a
+ * file first. The data is produced once by a shell command and once by a throttled producer in this process, which
+ * stands in for a slow upstream system. For both, the throughput is reported, along with whether the load was bound
+ * by Hyper or by the producer.
+ */
+
+#include "instrumentation.hpp"
+#include "named_pipe.hpp"
+#include "superstore_normalized.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Helper function printing the statistics of the load named `name`
+ */
+static void printStatistics(const std::string& name, const samples::NamedPipeCopyStatistics& statistics) {
+   std::cout << name << ": " << statistics.rowCount << " rows, " << statistics.byteCount / (1024.0 * 1024.0) << " MB in " << statistics.seconds
+             << " s (" << static_cast<int64_t>(statistics.rowCount / statistics.seconds) << " rows/s, "
+             << statistics.byteCount / (1024.0 * 1024.0) / statistics.seconds << " MB/s)" << std::endl;
+   std::cout << "  Waited " << statistics.producerWaitSeconds << " s for the producer and " << statistics.hyperWaitSeconds << " s for Hyper: "
+             << (statistics.isProducerBound() ? "bound by the producer" : "bound by Hyper") << std::endl;
+}
+
+/**
+ * Reads the records of `path` without its header line.
+ */
+static std::vector<std::string> readRecords(const std::string& path) {
+   std::ifstream file(path, std::ios::binary);
+   if (!file) {
+      throw std::runtime_error("Could not open " + path);
+   }
+   std::vector<std::string> records;
+   std::string line;
+   std::getline(file, line);
+   while (std::getline(file, line)) {
+      records.push_back(line + "\n");
+   }
+   return records;
+}
+
+static void runCreateHyperFileFromNamedPipe(int repetitions) {
+   std::cout << "EXAMPLE - Load data from a live producer through a named pipe" << std::endl;
+   const std::string pathToDatabase = "data/named_pipe.hyper";
+   const std::string pathToPipe = "data/orders.fifo";
+   const std::string pathToOrders = "data/orders.csv";
+   // The producers write the records without the header line.
+   const std::string copyOptions = "format csv, delimiter ','";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "named_pipe.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+
+         hyperapi::TableDefinition fromCommand = samples::ordersTable;
+         fromCommand.setTableName(hyperapi::TableName("Orders From Command"));
+         hyperapi::TableDefinition fromProducer = samples::ordersTable;
+         fromProducer.setTableName(hyperapi::TableName("Orders From Producer"));
+         samples::timePhase(samples::Phase::DDL, [&] {
+            connection.getCatalog().createTable(fromCommand);
+            connection.getCatalog().createTable(fromProducer);
+         });
+         const std::vector<std::string> records = readRecords(pathToOrders);
+         const int64_t expectedRows = static_cast<int64_t>(records.size()) * repetitions;
+
+         // A shell command as fast as it gets: Hyper parsing the CSV data is expected to be the bottleneck.
+         const std::string command = "i=0; while [ $i -lt " + std::to_string(repetitions) + " ]; do tail -n +2 " + pathToOrders + "; i=$((i+1)); done";
+         samples::NamedPipeCopyStatistics commandStatistics = samples::timePhase(samples::Phase::Execute, [&] {
+            return samples::copyFromCommand(connection, fromCommand.getTableName(), command, copyOptions, pathToPipe);
+         });
+         if (commandStatistics.producerExitCode != 0) {
+            throw std::runtime_error("The producer command failed with exit code " + std::to_string(commandStatistics.producerExitCode));
+         }
+         printStatistics("From a shell command", commandStatistics);
+
+         // A producer that pauses after every 1000 records, like an upstream system that delivers its data in bursts.
+         samples::NamedPipeCopyStatistics producerStatistics = samples::timePhase(samples::Phase::Execute, [&] {
+            return samples::copyFromProducer(
+               connection, fromProducer.getTableName(),
+               [&](int output) {
+                  for (int repetition = 0; repetition < repetitions; ++repetition) {
+                     for (size_t i = 0; i < records.size(); ++i) {
+                        samples::writeToPipe(output, records[i].data(), records[i].size());
+                        if (i % 1000 == 999) {
+                           std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                        }
+                     }
+                  }
+               },
+               copyOptions, pathToPipe);
+         });
+         printStatistics("From a throttled producer", producerStatistics);
+
+         if ((commandStatistics.rowCount != expectedRows) || (producerStatistics.rowCount != expectedRows)) {
+            throw std::runtime_error("Expected " + std::to_string(expectedRows) + " rows from each producer.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of times the orders are produced can be passed on the command line.
+   int repetitions = (arguments.size() > 0) ? std::atoi(arguments[0].c_str()) : 50;
+   try {
+      runCreateHyperFileFromNamedPipe(repetitions);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,342 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example create_hyper_file_from_parquet.cpp
+ *
+ * An example of how to convert Parquet files into a Hyper file. The table definitions are derived from the metadata of
+ * the Parquet files, and the files are loaded in parallel with Hyper's own Parquet reader.
+ *
+ * If the samples have been built with Apache Arrow, the row groups can instead be read on the client and inserted with
+ * an `Inserter`, in parallel as well. That is used if Hyper cannot read the files itself, or if `--batch` is passed.
+ * Files whose names only differ in a trailing number, like "lineitems-0.parquet" and "lineitems-1.parquet", are
+ * loaded into the same table.
+ */
+
+#include "instrumentation.hpp"
+#include "parquet_metadata.hpp"
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_PARQUET
+#include "arrow_interop.hpp"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_PARQUET
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#endif
+
+/** Parquet files that are loaded into the same table. */
+struct ParquetDataset {
+   hyperapi::TableDefinition table;
+   std::vector<std::string> paths;
+   std::vector<samples::ParquetMetadata> metadata;
+};
+
+/** A unit of work of the load: a whole file for Hyper's Parquet reader, a row group for the batch path. */
+struct LoadItem {
+   size_t dataset;
+   size_t file;
+   /// The row group, -1 for the whole file.
+   int rowGroup;
+   int64_t rowCount;
+   double seconds;
+};
+
+/**
+ * Helper function returning the name of the table the Parquet file at `path` is loaded into: its file name without
+ * directory, extension, and trailing number
+ */
+static std::string getTableName(const std::string& path) {
+   size_t nameBegin = path.find_last_of("/\\");
+   nameBegin = (nameBegin == std::string::npos) ? 0 : nameBegin + 1;
+   size_t nameEnd = path.find_last_of('.');
+   std::string name = path.substr(nameBegin, ((nameEnd == std::string::npos) || (nameEnd < nameBegin)) ? std::string::npos : nameEnd - nameBegin);
+   size_t numberBegin = name.find_last_not_of("0123456789");
+   if ((numberBegin != std::string::npos) && (numberBegin + 1 < name.size()) && ((name[numberBegin] == '-') || (name[numberBegin] == '_'))) {
+      name.erase(numberBegin);
+   }
+   return name;
+}
+
+/**
+ * Helper function returning the table worker `worker` loads the files of `table` into
+ */
+static hyperapi::TableDefinition getWorkerTable(const hyperapi::TableDefinition& table, int worker) {
+   hyperapi::TableDefinition workerTable(table);
+   workerTable.setTableName(hyperapi::TableName(table.getTableName().getName().getUnescaped() + " Part " + std::to_string(worker)));
+   return workerTable;
+}
+
+/**
+ * Reads the metadata of all files and groups them into datasets. The files of a dataset must have the same columns.
+ */
+static std::vector<ParquetDataset> readDatasets(const std::vector<std::string>& paths) {
+   std::vector<ParquetDataset> datasets;
+   std::map<std::string, size_t> datasetIndexes;
+   for (const std::string& path : paths) {
+      samples::ParquetMetadata metadata = samples::readParquetMetadata(path);
+      const std::string tableName = getTableName(path);
+      hyperapi::TableDefinition table = samples::getTableDefinition(metadata, hyperapi::TableName(tableName));
+      auto inserted = datasetIndexes.emplace(tableName, datasets.size());
+      if (inserted.second) {
+         datasets.push_back(ParquetDataset{table, {}, {}});
+      } else {
+         const hyperapi::TableDefinition& datasetTable = datasets[inserted.first->second].table;
+         bool isSame = (table.getColumnCount() == datasetTable.getColumnCount());
+         for (size_t i = 0; isSame && (i < table.getColumnCount()); ++i) {
+            isSame = (table.getColumn(i).getName() == datasetTable.getColumn(i).getName()) &&
+                     (table.getColumn(i).getType().toString() == datasetTable.getColumn(i).getType().toString()) &&
+                     (table.getColumn(i).getNullability() == datasetTable.getColumn(i).getNullability());
+         }
+         if (!isSame) {
+            throw std::runtime_error(path + " has other columns than the other files of table " + tableName);
+         }
+      }
+      ParquetDataset& dataset = datasets[inserted.first->second];
+      dataset.paths.push_back(path);
+      dataset.metadata.push_back(metadata);
+
+      std::cout << path << ": " << metadata.rowCount << " rows in " << metadata.rowGroups.size() << " row groups, written by "
+                << (metadata.createdBy.empty() ? "an unknown writer" : metadata.createdBy) << std::endl;
+      if (inserted.second) {
+         for (const hyperapi::TableDefinition::Column& column : table.getColumns()) {
+            std::cout << "  " << column.getName() << " " << column.getType()
+                      << ((column.getNullability() == hyperapi::Nullability::NotNullable) ? " NOT NULL" : "") << std::endl;
+         }
+      }
+   }
+   return datasets;
+}
+
+/**
+ * Returns whether Hyper can read the Parquet file at `path` itself. Older versions of Hyper cannot read Parquet files.
+ * Hyper reads the schema from the footer of the file, and `LIMIT 0` keeps it from scanning any row group.
+ */
+static bool canHyperReadParquet(hyperapi::Connection& connection, const std::string& path) {
+   try {
+      hyperapi::Result result =
+         connection.executeQuery("SELECT * FROM external(" + hyperapi::escapeStringLiteral(path) + ", FORMAT => 'parquet') LIMIT 0");
+      for (const hyperapi::Row& row : result) {
+         (void)row;
+      }
+      return true;
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << "Hyper cannot read " << path << " itself: " << e.getMainMessage() << std::endl;
+      return false;
+   }
+}
+
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_PARQUET
+/**
+ * Reads one row group of a Parquet file on the client and inserts it into `table`.
+ */
+static int64_t insertRowGroup(
+   hyperapi::Connection& connection, parquet::arrow::FileReader& reader, int rowGroup, const hyperapi::TableDefinition& table) {
+   std::shared_ptr<arrow::Table> rows = samples::getArrowValue(reader.ReadRowGroup(rowGroup));
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   const std::vector<hyperapi::TableDefinition::Column> inserterColumns = samples::getInserterColumns(table);
+   hyperapi::Inserter inserter(connection, table, samples::getInserterMappings(table), inserterColumns);
+   int64_t rowCount = samples::insertArrowTable(inserter, *rows, inserterColumns);
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+   return rowCount;
+}
+#endif
+
+/**
+ * Loads the items with index `worker`, `worker + workerCount`, and so on into the worker's own tables.
+ */
+static void runWorker(
+   const hyperapi::Endpoint& endpoint, const std::string& pathToDatabase, int worker, int workerCount, const std::vector<ParquetDataset>& datasets,
+   std::vector<LoadItem>& items) {
+   hyperapi::Connection connection(endpoint, pathToDatabase);
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_PARQUET
+   // The readers are kept open, so the metadata of a file is only read once per worker.
+   std::map<std::string, std::unique_ptr<parquet::arrow::FileReader>> readers;
+#endif
+   for (size_t i = static_cast<size_t>(worker); i < items.size(); i += static_cast<size_t>(workerCount)) {
+      LoadItem& item = items[i];
+      const std::string& path = datasets[item.dataset].paths[item.file];
+      const hyperapi::TableDefinition table = getWorkerTable(datasets[item.dataset].table, worker);
+      auto start = std::chrono::steady_clock::now();
+      if (item.rowGroup < 0) {
+         item.rowCount = samples::timePhase(samples::Phase::Execute, [&] {
+            return connection.executeCommand(
+               "COPY " + table.getTableName().toString() + " from " + hyperapi::escapeStringLiteral(path) + " with (format parquet)");
+         });
+      } else {
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_PARQUET
+         std::unique_ptr<parquet::arrow::FileReader>& reader = readers[path];
+         if (!reader) {
+            reader = samples::getArrowValue(parquet::arrow::OpenFile(samples::getArrowValue(arrow::io::ReadableFile::Open(path)), arrow::default_memory_pool()));
+         }
+         item.rowCount = insertRowGroup(connection, *reader, item.rowGroup, table);
+#endif
+      }
+      item.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+}
+
+static void runCreateHyperFileFromParquet(const std::vector<std::string>& paths, bool useBatchPath) {
+   std::cout << "EXAMPLE - Convert Parquet files into a Hyper file" << std::endl;
+   const std::string pathToDatabase = "data/parquet.hyper";
+
+   // The table definitions only need the metadata of the files.
+   const std::vector<ParquetDataset> datasets = readDatasets(paths);
+   const int workerCount = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "parquet.hyper" with the tables and one part of each table per worker. The tables are
+      // created upfront, so the workers do not change the catalog concurrently.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         samples::timePhase(samples::Phase::DDL, [&] {
+            for (const ParquetDataset& dataset : datasets) {
+               connection.getCatalog().createTable(dataset.table);
+               for (int worker = 0; worker < workerCount; ++worker) {
+                  connection.getCatalog().createTable(getWorkerTable(dataset.table, worker));
+               }
+            }
+         });
+
+         // Hyper's own reader loads a whole file with one COPY and reads its row groups in parallel. The batch path reads
+         // the row groups on the client instead, so a row group is the unit of work.
+         if (!useBatchPath && !canHyperReadParquet(connection, datasets.front().paths.front())) {
+#ifdef TABLEAU_HYPER_SAMPLES_HAVE_PARQUET
+            useBatchPath = true;
+#else
+            throw std::runtime_error("Hyper cannot read Parquet files, and the samples have been built without Apache Arrow.");
+#endif
+         }
+#ifndef TABLEAU_HYPER_SAMPLES_HAVE_PARQUET
+         if (useBatchPath) {
+            throw std::runtime_error("The batch path requires the samples to be built with Apache Arrow.");
+         }
+#endif
+         std::vector<LoadItem> items;
+         for (size_t d = 0; d < datasets.size(); ++d) {
+            for (size_t f = 0; f < datasets[d].paths.size(); ++f) {
+               for (size_t g = 0; g < (useBatchPath ? datasets[d].metadata[f].rowGroups.size() : 1); ++g) {
+                  items.push_back(LoadItem{d, f, useBatchPath ? static_cast<int>(g) : -1, 0, 0});
+               }
+            }
+         }
+         std::cout << "Loading " << items.size() << (useBatchPath ? " row groups with inserters" : " files with Hyper's Parquet reader") << " using "
+                   << workerCount << " workers." << std::endl;
+
+         // Run the workers. An exception of a worker is rethrown after all workers have finished.
+         auto start = std::chrono::steady_clock::now();
+         std::vector<std::thread> workers;
+         std::vector<std::exception_ptr> errors(static_cast<size_t>(workerCount));
+         for (int worker = 0; worker < workerCount; ++worker) {
+            workers.emplace_back([&, worker] {
+               try {
+                  runWorker(hyper.getEndpoint(), pathToDatabase, worker, workerCount, datasets, items);
+               } catch (...) {
+                  errors[static_cast<size_t>(worker)] = std::current_exception();
+               }
+            });
+         }
+         for (std::thread& worker : workers) {
+            worker.join();
+         }
+         for (const std::exception_ptr& error : errors) {
+            if (error) {
+               std::rethrow_exception(error);
+            }
+         }
+         double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         int64_t totalRows = 0;
+         for (const LoadItem& item : items) {
+            std::cout << "  " << datasets[item.dataset].paths[item.file];
+            if (item.rowGroup >= 0) {
+               std::cout << ", row group " << item.rowGroup;
+            }
+            std::cout << ": " << item.rowCount << " rows in " << 1000 * item.seconds << " ms (" << static_cast<int64_t>(item.rowCount / item.seconds)
+                      << " rows/s)" << std::endl;
+            totalRows += item.rowCount;
+         }
+         std::cout << "Loaded " << totalRows << " rows in " << seconds << " s (" << static_cast<int64_t>(totalRows / seconds) << " rows/s)." << std::endl;
+
+         // Combine the parts of each table.
+         for (const ParquetDataset& dataset : datasets) {
+            std::string parts;
+            for (int worker = 0; worker < workerCount; ++worker) {
+               parts += (parts.empty() ? "SELECT * FROM " : " UNION ALL SELECT * FROM ") + getWorkerTable(dataset.table, worker).getTableName().toString();
+            }
+            int64_t rowCount = samples::timePhase(
+               samples::Phase::Execute, [&] { return connection.executeCommand("INSERT INTO " + dataset.table.getTableName().toString() + " " + parts); });
+            samples::timePhase(samples::Phase::DDL, [&] {
+               for (int worker = 0; worker < workerCount; ++worker) {
+                  connection.executeCommand("DROP TABLE " + getWorkerTable(dataset.table, worker).getTableName().toString());
+               }
+            });
+
+            int64_t expectedRowCount = 0;
+            for (const samples::ParquetMetadata& metadata : dataset.metadata) {
+               expectedRowCount += metadata.rowCount;
+            }
+            std::cout << "The number of rows in table " << dataset.table.getTableName() << " is " << rowCount << "." << std::endl;
+            if (rowCount != expectedRowCount) {
+               throw std::runtime_error("The number of rows does not match the metadata of the Parquet files.");
+            }
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, `--batch` forces the batch path, and the Parquet files can be passed on the command line.
+   bool useBatchPath = false;
+   auto batchOption = std::find(arguments.begin(), arguments.end(), "--batch");
+   if (batchOption != arguments.end()) {
+      useBatchPath = true;
+      arguments.erase(batchOption);
+   }
+   if (arguments.empty()) {
+      arguments = {"data/parquet/orders.parquet", "data/parquet/lineitems-0.parquet", "data/parquet/lineitems-1.parquet"};
+   }
+   try {
+      runCreateHyperFileFromParquet(arguments, useBatchPath);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
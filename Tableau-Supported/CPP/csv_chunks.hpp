@@ -0,0 +1,106 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file csv_chunks.hpp
+ *
+ * Helpers to split a CSV file into byte ranges of complete records that can be loaded with one COPY each.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_CSV_CHUNKS_HPP
+#define TABLEAU_HYPER_SAMPLES_CSV_CHUNKS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** A byte range [begin, end) of a CSV file that contains complete records only. */
+typedef std::pair<uint64_t, uint64_t> CsvChunk;
+
+/**
+ * Splits the records after the header line of a CSV file into chunks of roughly `chunkSize` bytes.
+ * Newlines within quoted fields do not end a record, so the file is scanned once from the beginning.
+ */
+inline std::vector<CsvChunk> splitCsvIntoChunks(const std::string& pathToCSV, uint64_t chunkSize, uint64_t& fileSize) {
+   std::ifstream file(pathToCSV, std::ios::binary);
+   if (!file) {
+      throw std::runtime_error("Could not open " + pathToCSV);
+   }
+   std::vector<CsvChunk> chunks;
+   std::vector<char> buffer(1 << 20);
+   bool inQuotes = false;
+   bool inHeader = true;
+   uint64_t offset = 0;
+   uint64_t chunkBegin = 0;
+   while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || (file.gcount() > 0)) {
+      size_t count = static_cast<size_t>(file.gcount());
+      for (size_t i = 0; i < count; ++i) {
+         char c = buffer[i];
+         if (c == '"') {
+            inQuotes = !inQuotes;
+         } else if ((c == '\n') && !inQuotes) {
+            uint64_t recordEnd = offset + i + 1;
+            if (inHeader) {
+               inHeader = false;
+               chunkBegin = recordEnd;
+            } else if (recordEnd - chunkBegin >= chunkSize) {
+               chunks.emplace_back(chunkBegin, recordEnd);
+               chunkBegin = recordEnd;
+            }
+         }
+      }
+      offset += count;
+   }
+   if (offset > chunkBegin) {
+      chunks.emplace_back(chunkBegin, offset);
+   }
+   fileSize = offset;
+   return chunks;
+}
+
+/**
+ * Copies a byte range of a file into a new file. Throws if the range cannot be read completely or the new file cannot
+ * be written, so a partial chunk is never loaded as if it were complete.
+ */
+inline void copyFileRange(const std::string& sourcePath, const CsvChunk& chunk, const std::string& destinationPath) {
+   std::ifstream source(sourcePath, std::ios::binary);
+   if (!source) {
+      throw std::runtime_error("Could not open " + sourcePath);
+   }
+   std::ofstream destination(destinationPath, std::ios::binary);
+   if (!destination) {
+      throw std::runtime_error("Could not create " + destinationPath);
+   }
+   source.seekg(static_cast<std::streamoff>(chunk.first));
+   std::vector<char> buffer(1 << 20);
+   for (uint64_t remaining = chunk.second - chunk.first; remaining > 0;) {
+      std::streamsize count = static_cast<std::streamsize>(std::min<uint64_t>(remaining, buffer.size()));
+      source.read(buffer.data(), count);
+      if (source.gcount() != count) {
+         throw std::runtime_error("Could not read bytes " + std::to_string(chunk.first) + " to " + std::to_string(chunk.second) + " of " + sourcePath);
+      }
+      destination.write(buffer.data(), count);
+      remaining -= static_cast<uint64_t>(count);
+   }
+   destination.close();
+   if (!destination) {
+      throw std::runtime_error("Could not write " + destinationPath);
+   }
+}
+}
+
+#endif
@@ -0,0 +1,293 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file csv_index.hpp
+ *
+ * A fast validator for CSV files that also builds an index of record boundaries.
+ *
+ * The file is scanned in blocks of 64 bytes. For each block, one bitmask each marks the quotes, the delimiters and the
+ * newlines, computed with AVX2 where the CPU supports it and byte by byte otherwise. The quoted regions follow from a
+ * prefix XOR over the quote mask, so the delimiters and newlines outside of quotes are found without a branch per
+ * byte. From these masks, the scanner counts the fields of every record, reports the records whose field count
+ * differs from the header's with their line numbers, and records a checkpoint every `checkpointInterval` bytes.
+ * The checkpoints split the file into chunks of complete records that can be loaded with one COPY each.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_CSV_INDEX_HPP
+#define TABLEAU_HYPER_SAMPLES_CSV_INDEX_HPP
+
+#include "csv_chunks.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TABLEAU_HYPER_SAMPLES_CSV_INDEX_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace samples {
+
+/** Options of `indexCsv()`. */
+struct CsvIndexOptions {
+   char delimiter = ',';
+   /// The minimum distance in bytes between two checkpoints, i.e., the size of the chunks.
+   uint64_t checkpointInterval = 64 * 1024 * 1024;
+   /// At most this many errors are recorded, further errors are only counted.
+   size_t maxErrors = 100;
+   /// Whether to use AVX2 if the CPU supports it.
+   bool useAvx2 = true;
+};
+
+/** A record whose number of fields differs from the header's, or a quoted field that is never closed. */
+struct CsvError {
+   /// The line the record begins on, starting at 1 for the header.
+   uint64_t lineNumber;
+   /// The byte offset the record begins at.
+   uint64_t offset;
+   /// The number of fields of the record, 0 for an unterminated quote.
+   uint64_t fieldCount;
+};
+
+/** The result of `indexCsv()`. */
+struct CsvIndex {
+   uint64_t fileSize = 0;
+   /// The number of fields of the header.
+   uint64_t headerFieldCount = 0;
+   /// The number of records after the header.
+   uint64_t recordCount = 0;
+   /// The offset of the first record after the header, followed by the offsets of the checkpoints.
+   std::vector<uint64_t> checkpoints;
+   std::vector<CsvError> errors;
+   uint64_t errorCount = 0;
+   /// Whether the masks were computed with AVX2.
+   bool usedAvx2 = false;
+
+   bool isValid() const { return errorCount == 0; }
+
+   /** The records after the header, split at the checkpoints into chunks. */
+   std::vector<CsvChunk> getChunks() const {
+      std::vector<CsvChunk> chunks;
+      for (size_t i = 0; i < checkpoints.size(); ++i) {
+         uint64_t end = (i + 1 < checkpoints.size()) ? checkpoints[i + 1] : fileSize;
+         if (end > checkpoints[i]) {
+            chunks.emplace_back(checkpoints[i], end);
+         }
+      }
+      return chunks;
+   }
+};
+
+namespace detail {
+/** Helper function counting the set bits of `bits` */
+inline uint64_t popCount(uint64_t bits) {
+#if defined(_MSC_VER)
+   return __popcnt64(bits);
+#else
+   return static_cast<uint64_t>(__builtin_popcountll(bits));
+#endif
+}
+
+/** Helper function returning the position of the lowest set bit of `bits`, which must not be 0 */
+inline unsigned lowestBit(uint64_t bits) {
+#if defined(_MSC_VER)
+   unsigned long index;
+   _BitScanForward64(&index, bits);
+   return index;
+#else
+   return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+}
+
+/** Sets every bit whose number of set bits at or below it in `bits` is odd. */
+inline uint64_t prefixXor(uint64_t bits) {
+   bits ^= bits << 1;
+   bits ^= bits << 2;
+   bits ^= bits << 4;
+   bits ^= bits << 8;
+   bits ^= bits << 16;
+   bits ^= bits << 32;
+   return bits;
+}
+
+/** The positions of the quotes, delimiters and newlines in a block of 64 bytes. */
+struct BlockMasks {
+   uint64_t quotes;
+   uint64_t delimiters;
+   uint64_t newlines;
+};
+
+/** Computes the masks of a block byte by byte. */
+inline BlockMasks classifyScalar(const char* block, char delimiter) {
+   BlockMasks masks{0, 0, 0};
+   for (unsigned i = 0; i < 64; ++i) {
+      uint64_t bit = uint64_t{1} << i;
+      masks.quotes |= (block[i] == '"') ? bit : 0;
+      masks.delimiters |= (block[i] == delimiter) ? bit : 0;
+      masks.newlines |= (block[i] == '\n') ? bit : 0;
+   }
+   return masks;
+}
+
+#ifdef TABLEAU_HYPER_SAMPLES_CSV_INDEX_AVX2
+/** Compiled for AVX2 regardless of the compiler flags, so it must only be called if `hasAvx2()` returns true. */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+inline BlockMasks classifyAvx2(const char* block, char delimiter) {
+   const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+   const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+   const __m256i quote = _mm256_set1_epi8('"');
+   const __m256i comma = _mm256_set1_epi8(delimiter);
+   const __m256i newline = _mm256_set1_epi8('\n');
+   // `movemask` returns one bit per byte of the comparison, the high half of the block goes into the upper 32 bits.
+   BlockMasks masks;
+   masks.quotes = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, quote))) |
+                  (uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, quote)))} << 32);
+   masks.delimiters = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, comma))) |
+                      (uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, comma)))} << 32);
+   masks.newlines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline))) |
+                    (uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)))} << 32);
+   return masks;
+}
+
+/** Helper function returning whether the CPU supports AVX2 */
+inline bool hasAvx2() {
+#if defined(_MSC_VER)
+   int registers[4];
+   __cpuidex(registers, 7, 0);
+   return (registers[1] & (1 << 5)) != 0;
+#else
+   return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+/** The state of the scanner between two blocks. */
+struct ScanState {
+   bool inQuotes = false;
+   bool isHeader = true;
+   uint64_t fieldCount = 1;
+   uint64_t recordBegin = 0;
+   uint64_t recordLine = 1;
+   uint64_t line = 1;
+};
+
+/** Ends the current record, the next record begins at `nextRecord`. */
+inline void endRecord(uint64_t nextRecord, ScanState& state, CsvIndex& index, const CsvIndexOptions& options) {
+   if (state.isHeader) {
+      state.isHeader = false;
+      index.headerFieldCount = state.fieldCount;
+      index.checkpoints.push_back(nextRecord);
+   } else {
+      ++index.recordCount;
+      if (state.fieldCount != index.headerFieldCount) {
+         if (index.errors.size() < options.maxErrors) {
+            index.errors.push_back(CsvError{state.recordLine, state.recordBegin, state.fieldCount});
+         }
+         ++index.errorCount;
+      }
+      if (nextRecord - index.checkpoints.back() >= options.checkpointInterval) {
+         index.checkpoints.push_back(nextRecord);
+      }
+   }
+   state.fieldCount = 1;
+   state.recordBegin = nextRecord;
+   state.recordLine = state.line;
+}
+
+/** Processes the masks of the block at `offset`. `validBits` marks the bytes of the block that belong to the file. */
+inline void scanBlock(const BlockMasks& masks, uint64_t validBits, uint64_t offset, ScanState& state, CsvIndex& index, const CsvIndexOptions& options) {
+   // The bits inside quotes, including the opening quotes. A doubled quote within a quoted field toggles twice.
+   uint64_t quoted = prefixXor(masks.quotes & validBits) ^ (state.inQuotes ? ~uint64_t{0} : 0);
+   state.inQuotes = (quoted >> 63) != 0;
+   uint64_t delimiters = masks.delimiters & ~quoted & validBits;
+   uint64_t recordEnds = masks.newlines & ~quoted & validBits;
+   uint64_t newlines = masks.newlines & validBits;
+
+   while (recordEnds) {
+      unsigned position = lowestBit(recordEnds);
+      uint64_t upToEnd = (position == 63) ? ~uint64_t{0} : ((uint64_t{1} << (position + 1)) - 1);
+      state.fieldCount += popCount(delimiters & upToEnd);
+      state.line += popCount(newlines & upToEnd);
+      delimiters &= ~upToEnd;
+      newlines &= ~upToEnd;
+      recordEnds &= recordEnds - 1;
+      endRecord(offset + position + 1, state, index, options);
+   }
+   state.fieldCount += popCount(delimiters);
+   state.line += popCount(newlines);
+}
+}
+
+/**
+ * Validates the CSV file at `path`, which has a header, and indexes its record boundaries.
+ */
+inline CsvIndex indexCsv(const std::string& path, const CsvIndexOptions& options = {}) {
+   std::ifstream file(path, std::ios::binary);
+   if (!file) {
+      throw std::runtime_error("Could not open " + path);
+   }
+   CsvIndex index;
+#ifdef TABLEAU_HYPER_SAMPLES_CSV_INDEX_AVX2
+   index.usedAvx2 = options.useAvx2 && detail::hasAvx2();
+#endif
+
+   // The buffer is a multiple of the block size, the last block of the file is padded with zeros.
+   std::vector<char> buffer(1 << 20);
+   detail::ScanState state;
+   uint64_t offset = 0;
+   bool endsWithNewline = true;
+   while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || (file.gcount() > 0)) {
+      size_t count = static_cast<size_t>(file.gcount());
+      std::memset(buffer.data() + count, 0, (64 - count % 64) % 64);
+      for (size_t blockBegin = 0; blockBegin < count; blockBegin += 64) {
+         const char* block = buffer.data() + blockBegin;
+         size_t blockSize = std::min<size_t>(64, count - blockBegin);
+         uint64_t validBits = (blockSize == 64) ? ~uint64_t{0} : ((uint64_t{1} << blockSize) - 1);
+#ifdef TABLEAU_HYPER_SAMPLES_CSV_INDEX_AVX2
+         detail::BlockMasks masks = index.usedAvx2 ? detail::classifyAvx2(block, options.delimiter) : detail::classifyScalar(block, options.delimiter);
+#else
+         detail::BlockMasks masks = detail::classifyScalar(block, options.delimiter);
+#endif
+         detail::scanBlock(masks, validBits, offset + blockBegin, state, index, options);
+      }
+      endsWithNewline = (buffer[count - 1] == '\n');
+      offset += count;
+   }
+   index.fileSize = offset;
+
+   // The last record does not need to end with a newline.
+   if (state.inQuotes) {
+      if (index.errors.size() < options.maxErrors) {
+         index.errors.push_back(CsvError{state.recordLine, state.recordBegin, 0});
+      }
+      ++index.errorCount;
+   } else if (!endsWithNewline) {
+      detail::endRecord(offset, state, index, options);
+   }
+   if (index.checkpoints.empty()) {
+      index.checkpoints.push_back(offset);
+   }
+   return index;
+}
+}
+
+#endif
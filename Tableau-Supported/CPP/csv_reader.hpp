@@ -0,0 +1,273 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file csv_reader.hpp
+ *
+ * A small streaming CSV reader for samples that process CSV records on the client instead of using COPY,
+ * and a helper to add a CSV field to an `Inserter` as a value of the target column's type.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_CSV_READER_HPP
+#define TABLEAU_HYPER_SAMPLES_CSV_READER_HPP
+
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace samples {
+
+/**
+ * Reads RFC 4180 style CSV records: fields may be quoted, quotes within quoted fields are doubled, and records end
+ * with `\n` or `\r\n`. A UTF-8 byte order mark at the beginning of the file is skipped.
+ *
+ * The reader keeps track of the byte offset of the next record, so a consumer can remember how far it got and
+ * continue from there later with `seek()`.
+ */
+class CsvReader {
+   public:
+   explicit CsvReader(const std::string& path, char delimiter = ',')
+      : file(path, std::ios::binary), input(file), delimiter(delimiter), buffer(1 << 20) {
+      if (!file) {
+         throw std::runtime_error("Could not open " + path);
+      }
+   }
+
+   /** Reads the records from `input`, which must outlive the reader, e.g., a stream of decompressed data. */
+   explicit CsvReader(std::istream& input, char delimiter = ',') : input(input), delimiter(delimiter), buffer(1 << 20) {}
+
+   /**
+    * Reads the next record into `fields`, reusing the capacity of the strings already in it.
+    * Returns false if the end of the file has been reached.
+    */
+   bool readRecord(std::vector<std::string>& fields) { return readRecord(fields, nullptr); }
+
+   /**
+    * Reads the next record like `readRecord(fields)` and sets `quoted[i]` if field `i` was quoted. COPY reads an
+    * unquoted empty field as NULL, but a quoted one as an empty string.
+    */
+   bool readRecord(std::vector<std::string>& fields, std::vector<bool>& quoted) { return readRecord(fields, &quoted); }
+
+   /**
+    * Skips to the beginning of the next line without interpreting quotes. After seeking to an arbitrary offset, this
+    * finds the next record boundary unless the offset was within a quoted field containing a newline.
+    * Returns false if the end of the file has been reached.
+    */
+   bool skipLine() {
+      while ((position < end) || fill()) {
+         if (buffer[position++] == '\n') {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   /** The byte offset of the next record. */
+   uint64_t getOffset() const { return bufferOffset + position; }
+
+   /** Continues reading at `offset`, which must be the start of a record, e.g., a value returned by `getOffset()`. */
+   void seek(uint64_t offset) {
+      input.clear();
+      input.seekg(static_cast<std::streamoff>(offset));
+      bufferOffset = offset;
+      position = end = 0;
+   }
+
+   private:
+   /** Reads the next record and, unless `quoted` is null, which of its fields were quoted. */
+   bool readRecord(std::vector<std::string>& fields, std::vector<bool>* quoted) {
+      if (quoted) {
+         quoted->clear();
+      }
+      if ((getOffset() == 0) && skipByteOrderMark()) {
+         position += 3;
+      }
+      size_t fieldCount = 0;
+      bool inQuotes = false;
+      bool sawAnything = false;
+      std::string* field = nextField(fields, fieldCount);
+      while (true) {
+         if ((position == end) && !fill()) {
+            if (!sawAnything) {
+               fields.clear();
+               return false;
+            }
+            break;
+         }
+         char c = buffer[position++];
+         sawAnything = true;
+         if (inQuotes) {
+            if (c != '"') {
+               field->push_back(c);
+            } else if (((position < end) || fill()) && (buffer[position] == '"')) {
+               field->push_back('"');
+               ++position;
+            } else {
+               inQuotes = false;
+            }
+         } else if (c == delimiter) {
+            field = nextField(fields, fieldCount);
+         } else if (c == '\n') {
+            break;
+         } else if (c == '"') {
+            inQuotes = true;
+            if (quoted) {
+               quoted->resize(fieldCount, false);
+               quoted->back() = true;
+            }
+         } else if (c != '\r') {
+            field->push_back(c);
+         }
+      }
+      fields.resize(fieldCount);
+      if (quoted) {
+         quoted->resize(fieldCount, false);
+      }
+      return true;
+   }
+
+   /** Refills the buffer. Returns false at the end of the file. */
+   bool fill() {
+      bufferOffset += end;
+      position = end = 0;
+      input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      end = static_cast<size_t>(input.gcount());
+      return end > 0;
+   }
+
+   bool skipByteOrderMark() {
+      if ((position == end) && !fill()) {
+         return false;
+      }
+      return (end >= 3) && (buffer[0] == '\xEF') && (buffer[1] == '\xBB') && (buffer[2] == '\xBF');
+   }
+
+   static std::string* nextField(std::vector<std::string>& fields, size_t& fieldCount) {
+      if (fieldCount == fields.size()) {
+         fields.emplace_back();
+      }
+      std::string* field = &fields[fieldCount++];
+      field->clear();
+      return field;
+   }
+
+   std::ifstream file;
+   std::istream& input;
+   char delimiter;
+   std::vector<char> buffer;
+   size_t position = 0;
+   size_t end = 0;
+   uint64_t bufferOffset = 0;
+};
+
+/**
+ * Parses a date written as `YYYY-MM-DD` or as `M/D/YYYY`.
+ */
+inline hyperapi::Date parseCsvDate(const std::string& field) {
+   int year, month, day;
+   if ((std::sscanf(field.c_str(), "%d-%d-%d", &year, &month, &day) != 3) && (std::sscanf(field.c_str(), "%d/%d/%d", &month, &day, &year) != 3)) {
+      throw std::runtime_error("Invalid date: " + field);
+   }
+   return hyperapi::Date{year, static_cast<int16_t>(month), static_cast<int16_t>(day)};
+}
+
+namespace detail {
+/** Helper function throwing that `field` is not a valid value of `column` */
+[[noreturn]] inline void throwInvalidCsvValue(const hyperapi::TableDefinition::Column& column, const std::string& field) {
+   throw std::runtime_error("Invalid value for column " + column.getName().toString() + " of type " + column.getType().toString() + ": " + field);
+}
+
+/** Helper function parsing `field` as `true`, `t`, `1`, `false`, `f` or `0`, in any case */
+inline bool parseCsvBool(const hyperapi::TableDefinition::Column& column, const std::string& field) {
+   std::string lower;
+   for (char c : field) {
+      lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+   }
+   if ((lower == "true") || (lower == "t") || (lower == "1")) {
+      return true;
+   }
+   if ((lower == "false") || (lower == "f") || (lower == "0")) {
+      return false;
+   }
+   throwInvalidCsvValue(column, field);
+}
+
+/** Helper function parsing `field` as an integer between `min` and `max` */
+inline long long parseCsvInteger(const hyperapi::TableDefinition::Column& column, const std::string& field, long long min, long long max) {
+   char* end = nullptr;
+   errno = 0;
+   long long value = std::strtoll(field.c_str(), &end, 10);
+   if (field.empty() || (*end != '\0') || (errno == ERANGE) || (value < min) || (value > max)) {
+      throwInvalidCsvValue(column, field);
+   }
+   return value;
+}
+
+/** Helper function parsing `field` as a double */
+inline double parseCsvDouble(const hyperapi::TableDefinition::Column& column, const std::string& field) {
+   char* end = nullptr;
+   errno = 0;
+   double value = std::strtod(field.c_str(), &end);
+   if (field.empty() || (*end != '\0') || (errno == ERANGE)) {
+      throwInvalidCsvValue(column, field);
+   }
+   return value;
+}
+}
+
+/**
+ * Adds a CSV field to `inserter` as a value of the type of `column`.
+ * Empty fields are inserted as NULL into nullable columns. Throws if the field is not a valid value of the type.
+ */
+inline void addCsvValue(hyperapi::Inserter& inserter, const hyperapi::TableDefinition::Column& column, const std::string& field) {
+   if (field.empty() && (column.getNullability() == hyperapi::Nullability::Nullable)) {
+      inserter.add(hyperapi::null);
+      return;
+   }
+   switch (column.getType().getTag()) {
+      case hyperapi::TypeTag::Bool:
+         inserter.add(detail::parseCsvBool(column, field));
+         break;
+      case hyperapi::TypeTag::SmallInt:
+         inserter.add(static_cast<int16_t>(detail::parseCsvInteger(column, field, INT16_MIN, INT16_MAX)));
+         break;
+      case hyperapi::TypeTag::Int:
+         inserter.add(static_cast<int32_t>(detail::parseCsvInteger(column, field, INT32_MIN, INT32_MAX)));
+         break;
+      case hyperapi::TypeTag::BigInt:
+         inserter.add(static_cast<int64_t>(detail::parseCsvInteger(column, field, INT64_MIN, INT64_MAX)));
+         break;
+      case hyperapi::TypeTag::Double:
+         inserter.add(detail::parseCsvDouble(column, field));
+         break;
+      case hyperapi::TypeTag::Date:
+         inserter.add(parseCsvDate(field));
+         break;
+      case hyperapi::TypeTag::Text:
+      case hyperapi::TypeTag::Varchar:
+      case hyperapi::TypeTag::Char:
+         inserter.add(field);
+         break;
+      default:
+         throw std::runtime_error("Column " + column.getName().toString() + " has a type that cannot be read from CSV: " + column.getType().toString());
+   }
+}
+}
+
+#endif
@@ -0,0 +1,442 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file csv_schema_inference.hpp
+ *
+ * Infers the table definition of a CSV file with a header from a sample of its records.
+ *
+ * The records after the header are split into regions of equal size that are sampled by several threads. Each thread
+ * reads up to `rowsPerRegion` records from the beginning of its regions, so small files are read completely and the
+ * time spent on large files only depends on the number of regions. The type of a column is the narrowest type that
+ * can represent all sampled values:
+ *
+ *     BOOL < SMALLINT < INTEGER < BIGINT < DOUBLE PRECISION < TEXT, and DATE < TIMESTAMP < TEXT
+ *
+ * A column is nullable if one of the sampled values is empty and unquoted, which COPY reads as NULL. A quoted empty
+ * value is an empty string and makes the column TEXT. Files that write NULL as the literal `NULL` instead are
+ * detected as well. Since only a sample is read, a value outside of the sample can still fail the COPY, e.g., an
+ * INTEGER in a column inferred as SMALLINT. Raise `rowsPerRegion` to read more of the file.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_CSV_SCHEMA_INFERENCE_HPP
+#define TABLEAU_HYPER_SAMPLES_CSV_SCHEMA_INFERENCE_HPP
+
+#include "csv_reader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** Options of `inferCsvSchema()`. */
+struct SchemaInferenceOptions {
+   /// The number of regions the file is split into.
+   size_t regionCount = 16;
+   /// The maximum number of records read from each region.
+   size_t rowsPerRegion = 10000;
+   /// The number of threads, 0 uses one per hardware thread.
+   size_t threadCount = 0;
+   char delimiter = ',';
+};
+
+/** The result of `inferCsvSchema()`. */
+struct InferredSchema {
+   explicit InferredSchema(hyperapi::TableDefinition table) : table(std::move(table)) {}
+
+   hyperapi::TableDefinition table;
+   /// Whether dates are written as month/day/year, which requires the connection setting `date_style=MDY`.
+   bool hasMonthDayYearDates = false;
+   /// The text that stands for NULL, either empty or `NULL`.
+   std::string nullString;
+   /// The number of records the schema was inferred from.
+   int64_t sampledRows = 0;
+   char delimiter = ',';
+
+   /** The COPY command that loads the CSV file at `path` into `table`. */
+   std::string getCopyCommand(const std::string& path) const {
+      return "COPY " + table.getTableName().toString() + " from " + hyperapi::escapeStringLiteral(path) + " with (format csv, delimiter " +
+             hyperapi::escapeStringLiteral(std::string(1, delimiter)) + (nullString.empty() ? "" : ", NULL " + hyperapi::escapeStringLiteral(nullString)) +
+             ", header)";
+   }
+};
+
+namespace detail {
+/** The types a column can still have after some of its values have been seen. */
+struct ColumnCandidates {
+   enum : unsigned { Bool = 1, Integer = 2, Double = 4, Date = 8, Timestamp = 16, All = 31 };
+   unsigned types = All;
+   bool hasValue = false;
+   bool hasEmpty = false;
+   bool hasNullLiteral = false;
+   bool hasMonthDayYear = false;
+   int64_t minInteger = 0;
+   int64_t maxInteger = 0;
+
+   void merge(const ColumnCandidates& other) {
+      hasEmpty = hasEmpty || other.hasEmpty;
+      hasNullLiteral = hasNullLiteral || other.hasNullLiteral;
+      if (!other.hasValue) {
+         return;
+      }
+      minInteger = hasValue ? std::min(minInteger, other.minInteger) : other.minInteger;
+      maxInteger = hasValue ? std::max(maxInteger, other.maxInteger) : other.maxInteger;
+      types &= other.types;
+      hasValue = true;
+      hasMonthDayYear = hasMonthDayYear || other.hasMonthDayYear;
+   }
+};
+
+/** Helper function parsing between `minCount` and `maxCount` digits at `position` of `value` */
+inline bool parseDigits(const std::string& value, size_t& position, size_t minCount, size_t maxCount, int& result) {
+   size_t start = position;
+   result = 0;
+   while ((position < value.size()) && (position - start < maxCount) && std::isdigit(static_cast<unsigned char>(value[position]))) {
+      result = result * 10 + (value[position++] - '0');
+   }
+   return position - start >= minCount;
+}
+
+/** Helper function returning whether `value` is `true`, `false`, `t` or `f`, in any case */
+inline bool isBool(const std::string& value) {
+   static const char* const literals[] = {"true", "false", "t", "f"};
+   for (const char* literal : literals) {
+      size_t i = 0;
+      while ((i < value.size()) && literal[i] && (std::tolower(static_cast<unsigned char>(value[i])) == literal[i])) {
+         ++i;
+      }
+      if ((i == value.size()) && !literal[i]) {
+         return true;
+      }
+   }
+   return false;
+}
+
+/** Parses an integer without exponent or fraction that fits into 64 bits. */
+inline bool parseInteger(const std::string& value, int64_t& result) {
+   size_t position = ((value[0] == '-') || (value[0] == '+')) ? 1 : 0;
+   if ((position == value.size()) || (value.size() - position > 18)) {
+      return false;
+   }
+   int64_t magnitude = 0;
+   for (; position < value.size(); ++position) {
+      if (!std::isdigit(static_cast<unsigned char>(value[position]))) {
+         return false;
+      }
+      magnitude = magnitude * 10 + (value[position] - '0');
+   }
+   result = (value[0] == '-') ? -magnitude : magnitude;
+   return true;
+}
+
+/** Returns whether `value` is a decimal number like `-12.3` or `1.5e-3`. */
+inline bool isDouble(const std::string& value) {
+   size_t position = ((value[0] == '-') || (value[0] == '+')) ? 1 : 0;
+   size_t digits = 0;
+   while ((position < value.size()) && std::isdigit(static_cast<unsigned char>(value[position]))) {
+      ++position, ++digits;
+   }
+   if ((position < value.size()) && (value[position] == '.')) {
+      ++position;
+      while ((position < value.size()) && std::isdigit(static_cast<unsigned char>(value[position]))) {
+         ++position, ++digits;
+      }
+   }
+   if ((digits > 0) && (position < value.size()) && ((value[position] == 'e') || (value[position] == 'E'))) {
+      ++position;
+      if ((position < value.size()) && ((value[position] == '-') || (value[position] == '+'))) {
+         ++position;
+      }
+      size_t exponentStart = position;
+      while ((position < value.size()) && std::isdigit(static_cast<unsigned char>(value[position]))) {
+         ++position;
+      }
+      if (position == exponentStart) {
+         return false;
+      }
+   }
+   return (digits > 0) && (position == value.size());
+}
+
+/**
+ * Parses a date written as `YYYY-MM-DD` or `M/D/YYYY` at the beginning of `value`.
+ * Returns the position after the date, or 0 if there is none.
+ */
+inline size_t parseDate(const std::string& value, bool& isMonthDayYear) {
+   size_t position = 0;
+   int year, month, day;
+   if (parseDigits(value, position, 4, 4, year) && (position < value.size()) && (value[position] == '-')) {
+      ++position;
+      if (!parseDigits(value, position, 1, 2, month) || (position == value.size()) || (value[position++] != '-') || !parseDigits(value, position, 1, 2, day)) {
+         return 0;
+      }
+      isMonthDayYear = false;
+   } else {
+      position = 0;
+      if (!parseDigits(value, position, 1, 2, month) || (position == value.size()) || (value[position++] != '/') || !parseDigits(value, position, 1, 2, day) ||
+          (position == value.size()) || (value[position++] != '/') || !parseDigits(value, position, 4, 4, year)) {
+         return 0;
+      }
+      isMonthDayYear = true;
+   }
+   return ((month >= 1) && (month <= 12) && (day >= 1) && (day <= 31)) ? position : 0;
+}
+
+/** Returns whether `value`, starting at `position`, is a time of day like ` 21:07:32` or `T21:07:32.5`. */
+inline bool isTimeOfDay(const std::string& value, size_t position) {
+   int hour, minute, second;
+   if ((position == value.size()) || ((value[position] != ' ') && (value[position] != 'T'))) {
+      return false;
+   }
+   ++position;
+   if (!parseDigits(value, position, 1, 2, hour) || (position == value.size()) || (value[position++] != ':') || !parseDigits(value, position, 2, 2, minute)) {
+      return false;
+   }
+   if ((position < value.size()) && (value[position] == ':')) {
+      ++position;
+      if (!parseDigits(value, position, 2, 2, second)) {
+         return false;
+      }
+      if ((position < value.size()) && (value[position] == '.')) {
+         ++position;
+         int fraction;
+         if (!parseDigits(value, position, 1, 6, fraction)) {
+            return false;
+         }
+      }
+   }
+   return (position == value.size()) && (hour < 24) && (minute < 60);
+}
+
+/**
+ * Narrows the candidate types of a column by one of its values. COPY never reads a quoted field as NULL, so a quoted
+ * empty field is an empty string, which only a TEXT column can hold.
+ */
+inline void observe(ColumnCandidates& column, const std::string& value, bool isQuoted) {
+   if (!isQuoted && value.empty()) {
+      column.hasEmpty = true;
+      return;
+   }
+   if (!isQuoted && (value == "NULL")) {
+      column.hasNullLiteral = true;
+      return;
+   }
+   if (value.empty()) {
+      column.types = 0;
+      column.hasValue = true;
+      return;
+   }
+   unsigned types = 0;
+   if (isBool(value)) {
+      types |= ColumnCandidates::Bool;
+   }
+   int64_t integer;
+   if (parseInteger(value, integer)) {
+      types |= ColumnCandidates::Integer | ColumnCandidates::Double;
+      column.minInteger = column.hasValue ? std::min(column.minInteger, integer) : integer;
+      column.maxInteger = column.hasValue ? std::max(column.maxInteger, integer) : integer;
+   } else if (isDouble(value)) {
+      types |= ColumnCandidates::Double;
+   }
+   bool isMonthDayYear = false;
+   size_t dateEnd = parseDate(value, isMonthDayYear);
+   if (dateEnd == value.size()) {
+      types |= ColumnCandidates::Date | ColumnCandidates::Timestamp;
+   } else if ((dateEnd > 0) && isTimeOfDay(value, dateEnd)) {
+      types |= ColumnCandidates::Timestamp;
+   }
+   if (types & (ColumnCandidates::Date | ColumnCandidates::Timestamp)) {
+      column.hasMonthDayYear = column.hasMonthDayYear || isMonthDayYear;
+   }
+   column.types &= types;
+   column.hasValue = true;
+}
+
+/** The narrowest SQL type of a column. */
+inline hyperapi::SqlType getNarrowestType(const ColumnCandidates& column) {
+   if (!column.hasValue) {
+      return hyperapi::SqlType::text();
+   }
+   if (column.types & ColumnCandidates::Bool) {
+      return hyperapi::SqlType::boolean();
+   }
+   if (column.types & ColumnCandidates::Integer) {
+      if ((column.minInteger >= INT16_MIN) && (column.maxInteger <= INT16_MAX)) {
+         return hyperapi::SqlType::smallInt();
+      }
+      if ((column.minInteger >= INT32_MIN) && (column.maxInteger <= INT32_MAX)) {
+         return hyperapi::SqlType::integer();
+      }
+      return hyperapi::SqlType::bigInt();
+   }
+   if (column.types & ColumnCandidates::Double) {
+      return hyperapi::SqlType::doublePrecision();
+   }
+   if (column.types & ColumnCandidates::Date) {
+      return hyperapi::SqlType::date();
+   }
+   if (column.types & ColumnCandidates::Timestamp) {
+      return hyperapi::SqlType::timestamp();
+   }
+   return hyperapi::SqlType::text();
+}
+
+/** Returns unique, non-empty column names for the fields of a header. */
+inline std::vector<std::string> makeColumnNames(const std::vector<std::string>& header) {
+   std::vector<std::string> names;
+   std::set<std::string> usedNames;
+   for (size_t i = 0; i < header.size(); ++i) {
+      std::string base = header[i].empty() ? "Column " + std::to_string(i + 1) : header[i];
+      std::string name = base;
+      for (int suffix = 2; usedNames.count(name); ++suffix) {
+         name = base + " " + std::to_string(suffix);
+      }
+      usedNames.insert(name);
+      names.push_back(name);
+   }
+   return names;
+}
+}
+
+/**
+ * Infers the table definition of the CSV file at `path`, named `tableName`, from a sample of its records.
+ */
+inline InferredSchema inferCsvSchema(const std::string& path, const hyperapi::TableName& tableName, const SchemaInferenceOptions& options = {}) {
+   std::vector<std::string> header;
+   uint64_t dataBegin;
+   uint64_t fileSize;
+   {
+      CsvReader reader(path, options.delimiter);
+      if (!reader.readRecord(header)) {
+         throw std::runtime_error(path + " has no header");
+      }
+      dataBegin = reader.getOffset();
+      std::ifstream file(path, std::ios::binary | std::ios::ate);
+      fileSize = static_cast<uint64_t>(file.tellg());
+   }
+
+   const size_t regionCount = std::max<size_t>(options.regionCount, 1);
+   const uint64_t regionSize = (fileSize - dataBegin + regionCount - 1) / regionCount;
+   std::vector<detail::ColumnCandidates> columns(header.size());
+   int64_t sampledRows = 0;
+   std::atomic<size_t> nextRegion{0};
+   std::mutex mutex;
+   std::exception_ptr error;
+
+   // Each thread keeps its own candidates and merges them once it runs out of regions.
+   auto sampleRegions = [&] {
+      try {
+         std::vector<detail::ColumnCandidates> threadColumns(header.size());
+         int64_t threadRows = 0;
+         CsvReader reader(path, options.delimiter);
+         std::vector<std::string> fields;
+         std::vector<bool> quoted;
+         for (size_t region = nextRegion++; region < regionCount; region = nextRegion++) {
+            uint64_t regionBegin = dataBegin + region * regionSize;
+            uint64_t regionEnd = std::min(fileSize, regionBegin + regionSize);
+            if (regionBegin >= regionEnd) {
+               continue;
+            }
+            // The records of a region are the ones that start within it. Skipping the line that contains the byte
+            // before the region skips the rest of the record that started in the previous region.
+            if (region > 0) {
+               reader.seek(regionBegin - 1);
+               reader.skipLine();
+            } else {
+               reader.seek(regionBegin);
+            }
+            for (size_t row = 0; (row < options.rowsPerRegion) && (reader.getOffset() < regionEnd);) {
+               uint64_t recordBegin = reader.getOffset();
+               if (!reader.readRecord(fields, quoted)) {
+                  break;
+               }
+               // A region can begin within a quoted field that contains a newline. Records that do not match the
+               // header are skipped line by line until the reader is back in sync.
+               if (fields.size() != header.size()) {
+                  reader.seek(recordBegin);
+                  reader.skipLine();
+                  continue;
+               }
+               for (size_t i = 0; i < fields.size(); ++i) {
+                  detail::observe(threadColumns[i], fields[i], quoted[i]);
+               }
+               ++row;
+               ++threadRows;
+            }
+         }
+         std::lock_guard<std::mutex> lock(mutex);
+         for (size_t i = 0; i < columns.size(); ++i) {
+            columns[i].merge(threadColumns[i]);
+         }
+         sampledRows += threadRows;
+      } catch (...) {
+         std::lock_guard<std::mutex> lock(mutex);
+         error = std::current_exception();
+      }
+   };
+
+   size_t threadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+   std::vector<std::thread> threads;
+   for (size_t i = 0; i < std::min(threadCount, regionCount); ++i) {
+      threads.emplace_back(sampleRegions);
+   }
+   for (std::thread& thread : threads) {
+      thread.join();
+   }
+   if (error) {
+      std::rethrow_exception(error);
+   }
+
+   InferredSchema schema{hyperapi::TableDefinition(tableName)};
+   schema.sampledRows = sampledRows;
+   schema.delimiter = options.delimiter;
+   // COPY only knows one text for NULL. The other one is a value that only a TEXT column can hold, so the text is chosen
+   // that forces fewer columns to TEXT.
+   size_t emptyConflicts = 0, nullLiteralConflicts = 0;
+   for (const detail::ColumnCandidates& column : columns) {
+      if (detail::getNarrowestType(column).getTag() != hyperapi::TypeTag::Text) {
+         emptyConflicts += column.hasEmpty ? 1 : 0;
+         nullLiteralConflicts += column.hasNullLiteral ? 1 : 0;
+      }
+   }
+   if (emptyConflicts < nullLiteralConflicts) {
+      schema.nullString = "NULL";
+   }
+
+   std::vector<std::string> names = detail::makeColumnNames(header);
+   for (size_t i = 0; i < columns.size(); ++i) {
+      const detail::ColumnCandidates& column = columns[i];
+      bool isNullable = schema.nullString.empty() ? column.hasEmpty : column.hasNullLiteral;
+      bool hasOtherNull = schema.nullString.empty() ? column.hasNullLiteral : column.hasEmpty;
+      hyperapi::SqlType type = hasOtherNull ? hyperapi::SqlType::text() : detail::getNarrowestType(column);
+      schema.table.addColumn(hyperapi::TableDefinition::Column{
+         names[i], type, (isNullable || !column.hasValue) ? hyperapi::Nullability::Nullable : hyperapi::Nullability::NotNullable});
+      if ((type.getTag() == hyperapi::TypeTag::Date) || (type.getTag() == hyperapi::TypeTag::Timestamp)) {
+         schema.hasMonthDayYearDates = schema.hasMonthDayYearDates || column.hasMonthDayYear;
+      }
+   }
+   return schema;
+}
+}
+
+#endif
@@ -15,6 +15,8 @@
  * An example of how to delete data in an existing Hyper file.
  */
 
+#include "instrumentation.hpp"
+
 #include <fstream>
 #include <hyperapi/hyperapi.hpp>
 #include <iostream>
@@ -46,39 +48,51 @@ static void runDeleteDataInExistingHyperFile() {
    // Starts the Hyper Process with telemetry enabled to send data to Tableau.
    // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
    {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
       hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
 
       // Connect to existing Hyper file "superstore_sample_delete.hyper".
       {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
          hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
 
          std::cout << "Delete all rows from customer with the name 'Dennis Kane' from table " << hyperapi::escapeName("Orders") << "." << std::endl;
          // `executeCommand` executes a SQL statement and returns the impacted row count.
-         int64_t rowCount = connection.executeCommand(
-            "DELETE FROM " + hyperapi::escapeName("Orders") + " WHERE " + hyperapi::escapeName("Customer ID") + " = ANY(SELECT " +
-            hyperapi::escapeName("Customer ID") + " FROM " + hyperapi::escapeName("Customer") + " WHERE " + hyperapi::escapeName("Customer Name") + " = " +
-            hyperapi::escapeStringLiteral("Dennis Kane") + ")");
+         int64_t rowCount = samples::timePhase(samples::Phase::Execute, [&] {
+            return connection.executeCommand(
+               "DELETE FROM " + hyperapi::escapeName("Orders") + " WHERE " + hyperapi::escapeName("Customer ID") + " = ANY(SELECT " +
+               hyperapi::escapeName("Customer ID") + " FROM " + hyperapi::escapeName("Customer") + " WHERE " + hyperapi::escapeName("Customer Name") +
+               " = " + hyperapi::escapeStringLiteral("Dennis Kane") + ")");
+         });
          std::cout << "The number of deleted rows in table " << hyperapi::escapeName("Orders") << " is " << rowCount << "." << std::endl
                    << std::endl;
 
          std::cout << "Delete all rows from customer with the name 'Dennis Kane' from table " << hyperapi::escapeName("Customer") << "." << std::endl;
-         rowCount = connection.executeCommand(
-            "DELETE FROM " + hyperapi::escapeName("Customer") + " WHERE " + hyperapi::escapeName("Customer Name") + " =" +
-            hyperapi::escapeStringLiteral("Dennis Kane"));
+         rowCount = samples::timePhase(samples::Phase::Execute, [&] {
+            return connection.executeCommand(
+               "DELETE FROM " + hyperapi::escapeName("Customer") + " WHERE " + hyperapi::escapeName("Customer Name") + " =" +
+               hyperapi::escapeStringLiteral("Dennis Kane"));
+         });
 
          std::cout << "The number of deleted rows in table Customer is " << rowCount << "." << std::endl;
       }
       std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
    }
    std::cout << "The Hyper Process has been shut down." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
    try {
       runDeleteDataInExistingHyperFile();
    } catch (const hyperapi::HyperException& e) {
       std::cout << e.toString() << std::endl;
       return 1;
    }
+   samples::reportMetrics(metricsFormat);
    return 0;
 }
@@ -0,0 +1,171 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example denormalize_data_into_extract_table.cpp
+ *
+ * An example of how to build a denormalized "Extract" table from the normalized superstore tables with a single join
+ * inside Hyper, instead of joining the rows in client code, and how to refresh it incrementally when new orders
+ * arrive.
+ */
+
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <chrono>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// The table is called "Extract" and will be created in the "Extract" schema.
+// It has one row per line item with the columns of its order, customer, and product.
+using Column = hyperapi::TableDefinition::Column;
+static const hyperapi::TableDefinition extractTable{{"Extract", "Extract"},
+                                                    {
+                                                       Column{"Line Item ID", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Order ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Order Date", hyperapi::SqlType::date(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Ship Date", hyperapi::SqlType::date(), hyperapi::Nullability::Nullable},
+                                                       Column{"Ship Mode", hyperapi::SqlType::text(), hyperapi::Nullability::Nullable},
+                                                       Column{"Customer ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Customer Name", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Segment", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Product ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Product Name", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Category", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Sub-Category", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Sales", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Quantity", hyperapi::SqlType::smallInt(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Discount", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::Nullable},
+                                                       Column{"Profit", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable},
+                                                    }};
+
+/**
+ * Returns the query that joins every line item with its order, customer, and product, with the columns in the order
+ * of the "Extract" table.
+ */
+static std::string getDenormalizationQuery() {
+   auto column = [](const std::string& table, const std::string& name) { return table + "." + hyperapi::escapeName(name); };
+   return "SELECT " + column("l", "Line Item ID") + ", " + column("o", "Order ID") + ", " + column("o", "Order Date") + ", " + column("o", "Ship Date") +
+          ", " + column("o", "Ship Mode") + ", " + column("c", "Customer ID") + ", " + column("c", "Customer Name") + ", " + column("c", "Segment") + ", " +
+          column("p", "Product ID") + ", " + column("p", "Product Name") + ", " + column("p", "Category") + ", " + column("p", "Sub-Category") + ", " +
+          column("l", "Sales") + ", " + column("l", "Quantity") + ", " + column("l", "Discount") + ", " + column("l", "Profit") + " FROM " +
+          samples::lineItemsTable.getTableName().toString() + " l JOIN " + samples::ordersTable.getTableName().toString() + " o ON " +
+          column("l", "Order ID") + " = " + column("o", "Order ID") + " JOIN " + samples::customerTable.getTableName().toString() + " c ON " +
+          column("o", "Customer ID") + " = " + column("c", "Customer ID") + " JOIN " + samples::productTable.getTableName().toString() + " p ON " +
+          column("l", "Product ID") + " = " + column("p", "Product ID");
+}
+
+/**
+ * Inserts the joined rows of the line items that are not in the "Extract" table yet, or all of them if `incremental`
+ * is false. Prints and returns the number of inserted rows.
+ */
+static int64_t denormalize(hyperapi::Connection& connection, bool incremental) {
+   const std::string extract = extractTable.getTableName().toString();
+   // The anti-join only reads the "Line Item ID" column of the "Extract" table, so the refresh does not depend on the
+   // order in which the line items, orders, customers, and products arrive.
+   const std::string newLineItems = incremental ? " WHERE NOT EXISTS (SELECT 1 FROM " + extract + " e WHERE e." + hyperapi::escapeName("Line Item ID") +
+                                                     " = l." + hyperapi::escapeName("Line Item ID") + ")"
+                                                : "";
+   auto start = std::chrono::steady_clock::now();
+   int64_t rowCount =
+      samples::timePhase(samples::Phase::Execute, [&] { return connection.executeCommand("INSERT INTO " + extract + " " + getDenormalizationQuery() + newLineItems); });
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   std::cout << (incremental ? "Refreshed" : "Built") << " the table " << extract << " with " << rowCount << " rows in " << seconds << " s ("
+             << static_cast<int64_t>(rowCount / seconds) << " rows/s)." << std::endl;
+   return rowCount;
+}
+
+static void runDenormalizeDataIntoExtractTable() {
+   std::cout << "EXAMPLE - Build a denormalized extract from normalized tables and refresh it incrementally" << std::endl;
+   const std::string pathToDatabase = "data/superstore_denormalized.hyper";
+   const std::string orders = samples::ordersTable.getTableName().toString();
+   const std::string lineItems = samples::lineItemsTable.getTableName().toString();
+   const std::string newOrders = hyperapi::escapeName("New Orders");
+   const std::string newLineItems = hyperapi::escapeName("New Line Items");
+   const std::string recentOrder = hyperapi::escapeName("Order Date") + " >= DATE '2015-10-01'";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "superstore_denormalized.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         // The orders of the last quarter and their line items are held back, so they can arrive after the first build.
+         samples::timePhase(samples::Phase::Execute, [&] {
+            connection.executeCommand("CREATE TEMPORARY TABLE " + newOrders + " AS SELECT * FROM " + orders + " WHERE " + recentOrder);
+            connection.executeCommand(
+               "CREATE TEMPORARY TABLE " + newLineItems + " AS SELECT * FROM " + lineItems + " WHERE " + hyperapi::escapeName("Order ID") + " IN (SELECT " +
+               hyperapi::escapeName("Order ID") + " FROM " + newOrders + ")");
+            connection.executeCommand(
+               "DELETE FROM " + lineItems + " WHERE " + hyperapi::escapeName("Order ID") + " IN (SELECT " + hyperapi::escapeName("Order ID") + " FROM " +
+               newOrders + ")");
+            connection.executeCommand("DELETE FROM " + orders + " WHERE " + recentOrder);
+         });
+
+         samples::timePhase(samples::Phase::DDL, [&] {
+            connection.getCatalog().createSchema("Extract");
+            connection.getCatalog().createTable(extractTable);
+         });
+         int64_t builtRows = denormalize(connection, false);
+
+         // The new orders arrive, and only their line items are joined and inserted.
+         int64_t arrivedRows = samples::timePhase(samples::Phase::Execute, [&] {
+            connection.executeCommand("INSERT INTO " + orders + " SELECT * FROM " + newOrders);
+            return connection.executeCommand("INSERT INTO " + lineItems + " SELECT * FROM " + newLineItems);
+         });
+         std::cout << arrivedRows << " line items of new orders have arrived." << std::endl;
+         int64_t refreshedRows = denormalize(connection, true);
+
+         // The refreshed table must contain the same rows as a full build.
+         const std::string extract = extractTable.getTableName().toString();
+         int64_t differentRows = samples::timePhase(samples::Phase::Query, [&] {
+            return connection.executeScalarQuery<int64_t>(
+               "SELECT COUNT(*) FROM ((" + getDenormalizationQuery() + " EXCEPT ALL SELECT * FROM " + extract + ") UNION ALL (SELECT * FROM " + extract +
+               " EXCEPT ALL " + getDenormalizationQuery() + ")) AS differences");
+         });
+         if ((differentRows != 0) || (refreshedRows != arrivedRows)) {
+            throw std::runtime_error("The refreshed table " + extract + " does not match a full build.");
+         }
+         std::cout << "The table " << extract << " contains " << builtRows + refreshedRows << " rows." << std::endl;
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
+   try {
+      runDenormalizeDataIntoExtractTable();
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,282 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file dictionary_encoding.hpp
+ *
+ * A CSV loader that can dictionary-encode low-cardinality text columns on the client.
+ *
+ * Columns like "Segment" or "Ship Mode" have a handful of distinct values, but an `Inserter` sends the full text for
+ * every row. With dictionary encoding, a pre-pass over the CSV file collects the distinct values of every text column.
+ * The columns with few distinct values are sent as SMALLINT codes into a staging table, their values are sent once
+ * into a dictionary table per column, and the text is restored inside Hyper by joining the staging table with the
+ * dictionaries.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_DICTIONARY_ENCODING_HPP
+#define TABLEAU_HYPER_SAMPLES_DICTIONARY_ENCODING_HPP
+
+#include "csv_reader.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <hyperapi/hyperapi.hpp>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace samples {
+
+/** Dense SMALLINT codes for the distinct values of a column, in the order the values first appear. */
+class Dictionary {
+   public:
+   /** Adds `value` unless the dictionary already holds `maxSize` values. Returns false if the value did not fit. */
+   bool add(const std::string& value, size_t maxSize) {
+      if (codes.count(value)) {
+         return true;
+      }
+      if (values.size() >= maxSize) {
+         return false;
+      }
+      codes.emplace(value, static_cast<int16_t>(values.size()));
+      values.push_back(value);
+      return true;
+   }
+
+   /** The code of `value`, which must have been added. */
+   int16_t getCode(const std::string& value) const { return codes.at(value); }
+
+   const std::vector<std::string>& getValues() const { return values; }
+
+   private:
+   std::unordered_map<std::string, int16_t> codes;
+   std::vector<std::string> values;
+};
+
+/** Options of `loadCsv()`. */
+struct CsvLoadOptions {
+   /// Whether low-cardinality text columns are sent as dictionary codes.
+   bool dictionaryEncode = false;
+   /// Text columns with at most this many distinct values are dictionary-encoded.
+   size_t maxDistinctValues = 1024;
+};
+
+/** What `loadCsv()` did. */
+struct CsvLoadResult {
+   int64_t rowCount = 0;
+   /// The number of bytes sent to Hyper, estimated from the binary format the `Inserter` uses.
+   uint64_t bytesSent = 0;
+   /// The names of the dictionary-encoded columns.
+   std::vector<std::string> encodedColumns;
+};
+
+/**
+ * Returns the number of bytes `field` takes in the binary format the `Inserter` sends: nullable values are preceded by
+ * a null indicator byte, text values by their 4-byte length, and all other values have a fixed size.
+ */
+inline uint64_t getWireSize(const hyperapi::TableDefinition::Column& column, const std::string& field) {
+   uint64_t size = (column.getNullability() == hyperapi::Nullability::Nullable) ? 1 : 0;
+   if (field.empty() && size) {
+      return size;
+   }
+   switch (column.getType().getTag()) {
+      case hyperapi::TypeTag::Bool:
+         return size + 1;
+      case hyperapi::TypeTag::SmallInt:
+         return size + 2;
+      case hyperapi::TypeTag::Int:
+      case hyperapi::TypeTag::Date:
+         return size + 4;
+      case hyperapi::TypeTag::BigInt:
+      case hyperapi::TypeTag::Double:
+         return size + 8;
+      default:
+         return size + 4 + field.size();
+   }
+}
+
+namespace detail {
+/** Helper function returning whether a CSV field of `column` is NULL */
+inline bool isNullField(const hyperapi::TableDefinition::Column& column, const std::string& field) {
+   return field.empty() && (column.getNullability() == hyperapi::Nullability::Nullable);
+}
+
+/**
+ * The pre-pass: Reads the CSV file once and returns the dictionaries of the text columns of `table` that have at most
+ * `maxDistinctValues` distinct values and take fewer bytes as codes plus dictionary than as text, keyed by column index.
+ */
+inline std::map<size_t, Dictionary> buildDictionaries(const std::string& path, const hyperapi::TableDefinition& table, size_t maxDistinctValues) {
+   std::map<size_t, Dictionary> dictionaries;
+   std::map<size_t, uint64_t> textBytes;
+   for (size_t i = 0; i < table.getColumnCount(); ++i) {
+      if (table.getColumn(i).getType().getTag() == hyperapi::TypeTag::Text) {
+         dictionaries[i];
+      }
+   }
+   CsvReader reader(path);
+   std::vector<std::string> fields;
+   reader.readRecord(fields);
+   int64_t rowCount = 0;
+   while (!dictionaries.empty() && reader.readRecord(fields)) {
+      for (auto it = dictionaries.begin(); it != dictionaries.end();) {
+         const std::string& field = fields.at(it->first);
+         if (isNullField(table.getColumn(it->first), field)) {
+            ++it;
+         } else if (it->second.add(field, maxDistinctValues)) {
+            textBytes[it->first] += 4 + field.size();
+            ++it;
+         } else {
+            // Too many distinct values, the column is sent as text.
+            it = dictionaries.erase(it);
+         }
+      }
+      ++rowCount;
+   }
+
+   // A column of mostly unique values would send every value twice, once in the dictionary and once as a code.
+   for (auto it = dictionaries.begin(); it != dictionaries.end();) {
+      uint64_t encodedBytes = 2 * static_cast<uint64_t>(rowCount);
+      for (const std::string& value : it->second.getValues()) {
+         encodedBytes += 2 + 4 + value.size();
+      }
+      it = (encodedBytes < textBytes[it->first]) ? std::next(it) : dictionaries.erase(it);
+   }
+   return dictionaries;
+}
+}
+
+/**
+ * Loads the CSV file at `path`, which has a header and the columns of `table` in order, into the existing table
+ * `table`.
+ *
+ * With `options.dictionaryEncode`, the file is read twice: Once to build the dictionaries and once to insert the rows.
+ * That is worth it whenever the network or the `Inserter` is the bottleneck rather than parsing the CSV file.
+ */
+inline CsvLoadResult loadCsv(
+   hyperapi::Connection& connection, const std::string& path, const hyperapi::TableDefinition& table, const CsvLoadOptions& options = {}) {
+   CsvLoadResult result;
+   std::map<size_t, Dictionary> dictionaries;
+   if (options.dictionaryEncode) {
+      // The codes are SMALLINTs, which limits the size of a dictionary.
+      const size_t maxCodes = static_cast<size_t>(std::numeric_limits<int16_t>::max()) + 1;
+      dictionaries = detail::buildDictionaries(path, table, std::min(options.maxDistinctValues, maxCodes));
+   }
+
+   // The encoded columns are replaced by their codes in the staging table. Without encoded columns, the rows go
+   // directly into the target table.
+   const hyperapi::TableName& tableName = table.getTableName();
+   hyperapi::TableDefinition stagingTable(
+      hyperapi::TableName(tableName.getName().getUnescaped() + " Encoded"), std::vector<hyperapi::TableDefinition::Column>{},
+      hyperapi::Persistence::Temporary);
+   for (size_t i = 0; i < table.getColumnCount(); ++i) {
+      const hyperapi::TableDefinition::Column& column = table.getColumn(i);
+      if (dictionaries.count(i)) {
+         stagingTable.addColumn(hyperapi::TableDefinition::Column{column.getName(), hyperapi::SqlType::smallInt(), column.getNullability()});
+         result.encodedColumns.push_back(column.getName().getUnescaped());
+      } else {
+         stagingTable.addColumn(column);
+      }
+   }
+   const hyperapi::TableDefinition& insertTable = dictionaries.empty() ? table : stagingTable;
+   std::vector<hyperapi::TableDefinition> dictionaryTables;
+   {
+      PhaseTimer ddlTimer(Phase::DDL);
+      if (!dictionaries.empty()) {
+         connection.getCatalog().createTable(stagingTable);
+      }
+      for (const auto& dictionary : dictionaries) {
+         dictionaryTables.push_back(hyperapi::TableDefinition(
+            hyperapi::TableName(tableName.getName().getUnescaped() + " " + table.getColumn(dictionary.first).getName().getUnescaped() + " Dictionary"),
+            {hyperapi::TableDefinition::Column{"Code", hyperapi::SqlType::smallInt(), hyperapi::Nullability::NotNullable},
+             hyperapi::TableDefinition::Column{"Value", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable}},
+            hyperapi::Persistence::Temporary));
+         connection.getCatalog().createTable(dictionaryTables.back());
+      }
+   }
+
+   // Send each dictionary once.
+   size_t dictionaryIndex = 0;
+   for (const auto& dictionary : dictionaries) {
+      const hyperapi::TableDefinition& dictionaryTable = dictionaryTables[dictionaryIndex++];
+      PhaseTimer insertTimer(Phase::Insert);
+      hyperapi::Inserter inserter(connection, dictionaryTable);
+      const std::vector<std::string>& values = dictionary.second.getValues();
+      for (size_t code = 0; code < values.size(); ++code) {
+         inserter.addRow(static_cast<int16_t>(code), values[code]);
+         result.bytesSent += 2 + getWireSize(dictionaryTable.getColumn(1), values[code]);
+      }
+      insertTimer.stop();
+      timePhase(Phase::Execute, [&] { inserter.execute(); });
+   }
+
+   // Send the rows.
+   {
+      PhaseTimer insertTimer(Phase::Insert);
+      hyperapi::Inserter inserter(connection, insertTable);
+      CsvReader reader(path);
+      std::vector<std::string> fields;
+      reader.readRecord(fields);
+      while (reader.readRecord(fields)) {
+         for (size_t i = 0; i < table.getColumnCount(); ++i) {
+            const hyperapi::TableDefinition::Column& column = insertTable.getColumn(i);
+            const std::string& field = fields.at(i);
+            auto dictionary = dictionaries.find(i);
+            if ((dictionary == dictionaries.end()) || detail::isNullField(column, field)) {
+               addCsvValue(inserter, column, field);
+            } else {
+               inserter.add(dictionary->second.getCode(field));
+            }
+            result.bytesSent += getWireSize(column, field);
+         }
+         inserter.endRow();
+         ++result.rowCount;
+      }
+      insertTimer.stop();
+      timePhase(Phase::Execute, [&] { inserter.execute(); });
+   }
+   if (dictionaries.empty()) {
+      return result;
+   }
+
+   // Materialize the text columns inside Hyper. The joins are outer joins, so NULL codes stay NULL.
+   std::string selectList, joins;
+   dictionaryIndex = 0;
+   for (size_t i = 0; i < table.getColumnCount(); ++i) {
+      const std::string columnName = hyperapi::escapeName(table.getColumn(i).getName().getUnescaped());
+      selectList += selectList.empty() ? "" : ", ";
+      if (dictionaries.count(i)) {
+         const std::string alias = "d" + std::to_string(dictionaryIndex);
+         selectList += alias + "." + hyperapi::escapeName("Value");
+         joins += " LEFT JOIN " + dictionaryTables[dictionaryIndex].getTableName().toString() + " " + alias + " ON s." + columnName + " = " + alias + "." +
+                  hyperapi::escapeName("Code");
+         ++dictionaryIndex;
+      } else {
+         selectList += "s." + columnName;
+      }
+   }
+   const std::string insert = "INSERT INTO " + tableName.toString() + " SELECT " + selectList + " FROM " + stagingTable.getTableName().toString() + " s" + joins;
+   result.bytesSent += insert.size();
+   timePhase(Phase::Execute, [&] { connection.executeCommand(insert); });
+
+   PhaseTimer ddlTimer(Phase::DDL);
+   connection.executeCommand("DROP TABLE " + stagingTable.getTableName().toString());
+   for (const hyperapi::TableDefinition& dictionaryTable : dictionaryTables) {
+      connection.executeCommand("DROP TABLE " + dictionaryTable.getTableName().toString());
+   }
+   return result;
+}
+}
+
+#endif
@@ -0,0 +1,365 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file external_sort.hpp
+ *
+ * An external merge sort of CSV records by one column, and a loader that uses it to insert a CSV file clustered by
+ * that column.
+ *
+ * Hyper stores the rows of a table in the order they are inserted and keeps the minimum and maximum of every column
+ * per block of rows. If the rows are inserted sorted by a column, a range filter on that column only has to read the
+ * few blocks whose range overlaps the filter.
+ *
+ * Records are sorted in memory in runs of up to `ExternalSortOptions::memoryBudget` bytes. If the input is larger,
+ * the runs are sorted and written to temporary files by several threads while the next run is read, and the run
+ * files are merged while the records are inserted.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_EXTERNAL_SORT_HPP
+#define TABLEAU_HYPER_SAMPLES_EXTERNAL_SORT_HPP
+
+#include "csv_reader.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <hyperapi/hyperapi.hpp>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** Options of `sortCsvRecords()`. */
+struct ExternalSortOptions {
+   /// The size of the records that are sorted in memory at once. Larger inputs are sorted in several runs.
+   size_t memoryBudget = size_t{64} << 20;
+   /// The number of runs that are sorted and written concurrently, 0 for one per hardware thread. Each of them holds
+   /// up to `memoryBudget` bytes of records.
+   unsigned threadCount = 0;
+   /// The directory of the temporary run files.
+   std::string temporaryDirectory = "data";
+};
+
+/** What happened during `sortCsvRecords()`. */
+struct ExternalSortStatistics {
+   int64_t recordCount = 0;
+   /// The number of runs written to temporary files, 0 if all records fit into memory.
+   size_t runCount = 0;
+   /// The size of the run files.
+   uint64_t spilledBytes = 0;
+   /// Seconds spent reading the input and sorting and writing the runs.
+   double runSeconds = 0;
+   /// Seconds spent merging the runs and consuming the sorted records.
+   double mergeSeconds = 0;
+};
+
+namespace detail {
+/** A CSV record with the value it is sorted by. */
+struct SortRecord {
+   /// The sort key of numeric and date columns, -infinity for NULL.
+   double key = 0;
+   std::vector<std::string> fields;
+};
+
+/** Compares records by the value of the key column, which is either numeric or compared as text. */
+class SortRecordLess {
+   public:
+   SortRecordLess(size_t keyColumn, bool isNumeric) : keyColumn(keyColumn), isNumeric(isNumeric) {}
+
+   bool operator()(const SortRecord& left, const SortRecord& right) const {
+      return isNumeric ? (left.key < right.key) : (left.fields[keyColumn] < right.fields[keyColumn]);
+   }
+
+   private:
+   size_t keyColumn;
+   bool isNumeric;
+};
+
+/** Helper function returning whether values of `type` are sorted by their numeric key rather than as text */
+inline bool isNumericSortKey(const hyperapi::SqlType& type) {
+   switch (type.getTag()) {
+      case hyperapi::TypeTag::SmallInt:
+      case hyperapi::TypeTag::Int:
+      case hyperapi::TypeTag::BigInt:
+      case hyperapi::TypeTag::Double:
+      case hyperapi::TypeTag::Numeric:
+      case hyperapi::TypeTag::Date:
+         return true;
+      default:
+         return false;
+   }
+}
+
+/** Helper function returning the numeric sort key of `field`. Dates are mapped to YYYYMMDD. */
+inline double getSortKey(const hyperapi::SqlType& type, const std::string& field) {
+   if (field.empty()) {
+      return -std::numeric_limits<double>::infinity();
+   }
+   if (type.getTag() == hyperapi::TypeTag::Date) {
+      hyperapi::Date date = parseCsvDate(field);
+      return date.getYear() * 10000.0 + date.getMonth() * 100 + date.getDay();
+   }
+   return std::strtod(field.c_str(), nullptr);
+}
+
+/** Helper function returning the approximate memory used by `record` */
+inline size_t getRecordSize(const SortRecord& record) {
+   size_t size = sizeof(SortRecord);
+   for (const std::string& field : record.fields) {
+      size += sizeof(std::string) + field.size();
+   }
+   return size;
+}
+
+/** Writes `record` to a run file as its key followed by the length and the bytes of each field. */
+inline void writeSortRecord(std::ofstream& output, const SortRecord& record) {
+   uint32_t fieldCount = static_cast<uint32_t>(record.fields.size());
+   output.write(reinterpret_cast<const char*>(&record.key), sizeof(record.key));
+   output.write(reinterpret_cast<const char*>(&fieldCount), sizeof(fieldCount));
+   for (const std::string& field : record.fields) {
+      uint32_t size = static_cast<uint32_t>(field.size());
+      output.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      output.write(field.data(), static_cast<std::streamsize>(size));
+   }
+}
+
+/** Reads the next record written by `writeSortRecord()`. Returns false at the end of the run file. */
+inline bool readSortRecord(std::ifstream& input, SortRecord& record) {
+   uint32_t fieldCount = 0;
+   if (!input.read(reinterpret_cast<char*>(&record.key), sizeof(record.key)) || !input.read(reinterpret_cast<char*>(&fieldCount), sizeof(fieldCount))) {
+      return false;
+   }
+   record.fields.resize(fieldCount);
+   for (std::string& field : record.fields) {
+      uint32_t size = 0;
+      input.read(reinterpret_cast<char*>(&size), sizeof(size));
+      field.resize(size);
+      input.read(&field[0], static_cast<std::streamsize>(size));
+   }
+   if (!input) {
+      throw std::runtime_error("A run file of the external sort is truncated.");
+   }
+   return true;
+}
+
+/** Sorts `records` and writes them to the run file at `path`. */
+inline void writeRun(std::vector<SortRecord> records, const std::string& path, SortRecordLess less) {
+   std::stable_sort(records.begin(), records.end(), less);
+   std::ofstream output(path, std::ios::binary | std::ios::trunc);
+   for (const SortRecord& record : records) {
+      writeSortRecord(output, record);
+   }
+   output.close();
+   if (!output) {
+      throw std::runtime_error("Could not write the run file " + path);
+   }
+}
+
+/** A run that is sorted and written on a separate thread. */
+struct RunWriter {
+   std::string path;
+   std::exception_ptr error;
+   std::thread thread;
+};
+
+/** Removes the run files when the sort is done or has failed. */
+struct RunFiles {
+   std::vector<std::string> paths;
+
+   ~RunFiles() {
+      for (const std::string& path : paths) {
+         std::remove(path.c_str());
+      }
+   }
+};
+}
+
+/**
+ * Reads all records from `reader` and passes them to `consume(fields)` sorted by the field at `keyColumn`, which is
+ * compared as a value of `keyType`. Empty fields are NULL and come first. Records with equal keys keep their order.
+ */
+template <class Consume>
+ExternalSortStatistics sortCsvRecords(CsvReader& reader, size_t keyColumn, const hyperapi::SqlType& keyType, const ExternalSortOptions& options, Consume&& consume) {
+   typedef std::chrono::steady_clock Clock;
+   auto secondsSince = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+   const unsigned threadCount = (options.threadCount > 0) ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+   const bool isNumeric = detail::isNumericSortKey(keyType);
+   const detail::SortRecordLess less(keyColumn, isNumeric);
+
+   ExternalSortStatistics statistics;
+   auto start = Clock::now();
+   detail::RunFiles runFiles;
+   std::deque<std::unique_ptr<detail::RunWriter>> writers;
+   auto finishOldestRun = [&] {
+      detail::RunWriter& writer = *writers.front();
+      writer.thread.join();
+      std::exception_ptr error = writer.error;
+      writers.pop_front();
+      if (error) {
+         std::rethrow_exception(error);
+      }
+   };
+   std::vector<detail::SortRecord> records;
+   size_t runSize = 0;
+   auto writeRun = [&] {
+      // Each writer holds a whole run, so at most `threadCount` runs are in memory besides the one being read.
+      if (writers.size() == threadCount) {
+         finishOldestRun();
+      }
+      // The run files are named after the address of this sort, so concurrent sorts do not overwrite each other's runs.
+      std::unique_ptr<detail::RunWriter> writer(new detail::RunWriter());
+      writer->path = options.temporaryDirectory + "/external_sort_" + std::to_string(reinterpret_cast<uintptr_t>(&runFiles)) + "_" +
+                     std::to_string(runFiles.paths.size()) + ".run";
+      runFiles.paths.push_back(writer->path);
+      detail::RunWriter* target = writer.get();
+      writer->thread = std::thread(
+         [target, less](std::vector<detail::SortRecord>&& run) {
+            try {
+               detail::writeRun(std::move(run), target->path, less);
+            } catch (...) {
+               target->error = std::current_exception();
+            }
+         },
+         std::move(records));
+      writers.push_back(std::move(writer));
+      records.clear();
+      runSize = 0;
+   };
+
+   try {
+      detail::SortRecord record;
+      while (reader.readRecord(record.fields)) {
+         if (keyColumn >= record.fields.size()) {
+            throw std::runtime_error("A CSV record has no field " + std::to_string(keyColumn));
+         }
+         record.key = isNumeric ? detail::getSortKey(keyType, record.fields[keyColumn]) : 0;
+         runSize += detail::getRecordSize(record);
+         records.push_back(std::move(record));
+         record = detail::SortRecord();
+         ++statistics.recordCount;
+         if (runSize >= options.memoryBudget) {
+            writeRun();
+         }
+      }
+      if (!runFiles.paths.empty() && !records.empty()) {
+         writeRun();
+      }
+      while (!writers.empty()) {
+         finishOldestRun();
+      }
+   } catch (...) {
+      for (const std::unique_ptr<detail::RunWriter>& writer : writers) {
+         writer->thread.join();
+      }
+      throw;
+   }
+   statistics.runCount = runFiles.paths.size();
+   statistics.runSeconds = secondsSince(start);
+
+   start = Clock::now();
+   if (runFiles.paths.empty()) {
+      // All records fit into memory.
+      std::stable_sort(records.begin(), records.end(), less);
+      for (const detail::SortRecord& sorted : records) {
+         consume(sorted.fields);
+      }
+   } else {
+      // Merges the runs with a heap of the current record of every run. Ties are broken by the run number, so records
+      // with equal keys keep their order.
+      std::vector<std::unique_ptr<std::ifstream>> runs;
+      std::vector<detail::SortRecord> current(runFiles.paths.size());
+      auto greater = [&](size_t left, size_t right) {
+         return less(current[right], current[left]) || (!less(current[left], current[right]) && (left > right));
+      };
+      std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+      for (size_t run = 0; run < runFiles.paths.size(); ++run) {
+         runs.emplace_back(new std::ifstream(runFiles.paths[run], std::ios::binary));
+         statistics.spilledBytes += static_cast<uint64_t>(runs.back()->seekg(0, std::ios::end).tellg());
+         runs.back()->seekg(0);
+         if (detail::readSortRecord(*runs.back(), current[run])) {
+            heap.push(run);
+         }
+      }
+      while (!heap.empty()) {
+         size_t run = heap.top();
+         heap.pop();
+         consume(current[run].fields);
+         if (detail::readSortRecord(*runs[run], current[run])) {
+            heap.push(run);
+         }
+      }
+   }
+   statistics.mergeSeconds = secondsSince(start);
+   return statistics;
+}
+
+/** Options of `insertCsv()`. */
+struct CsvInsertOptions {
+   /// The column the rows are sorted by before they are inserted. If empty, the rows are inserted in the order of the
+   /// file.
+   std::string clusteringColumn;
+   ExternalSortOptions sort;
+};
+
+/**
+ * Inserts the records of the CSV file at `path`, which has a header line and the columns of `table` in the same
+ * order, into `table`. With a clustering column, the records are sorted by it with `sortCsvRecords()` first.
+ */
+inline ExternalSortStatistics insertCsv(hyperapi::Connection& connection, const hyperapi::TableDefinition& table, const std::string& path, const CsvInsertOptions& options) {
+   CsvReader reader(path);
+   reader.skipLine();
+   const std::vector<hyperapi::TableDefinition::Column>& columns = table.getColumns();
+   ExternalSortStatistics statistics;
+   PhaseTimer insertTimer(Phase::Insert);
+   hyperapi::Inserter inserter(connection, table);
+   auto insertRecord = [&](const std::vector<std::string>& fields) {
+      if (fields.size() != columns.size()) {
+         throw std::runtime_error("A record of " + path + " has " + std::to_string(fields.size()) + " fields instead of " + std::to_string(columns.size()));
+      }
+      for (size_t i = 0; i < columns.size(); ++i) {
+         addCsvValue(inserter, columns[i], fields[i]);
+      }
+      inserter.endRow();
+   };
+   if (options.clusteringColumn.empty()) {
+      std::vector<std::string> fields;
+      while (reader.readRecord(fields)) {
+         insertRecord(fields);
+         ++statistics.recordCount;
+      }
+   } else {
+      hyperapi::optional<size_t> keyColumn = table.getColumnPositionByName(options.clusteringColumn);
+      if (!keyColumn) {
+         throw std::invalid_argument("The table " + table.getTableName().toString() + " has no column " + options.clusteringColumn);
+      }
+      statistics = sortCsvRecords(reader, *keyColumn, columns[*keyColumn].getType(), options.sort, insertRecord);
+   }
+   insertTimer.stop();
+   timePhase(Phase::Execute, [&] { inserter.execute(); });
+   return statistics;
+}
+}
+
+#endif
@@ -0,0 +1,437 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file hyper_log.hpp
+ *
+ * A streaming reader for the event logs written by hyperd and a report of the slowest queries in them.
+ *
+ * hyperd writes one JSON object per line. Every object has a kind `k`, the session `sess` and a payload `v`. This
+ * reader only keeps the `query-end` events, which carry the elapsed time of a statement and its phases, and the
+ * events about spooling data to disk. Everything else is skipped, so arbitrarily large logs can be read line by line.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_HYPER_LOG_HPP
+#define TABLEAU_HYPER_SAMPLES_HYPER_LOG_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** A parsed JSON value. Objects keep their members in the order of the input. */
+struct JsonValue {
+   enum class Type { Null, Bool, Number, String, Array, Object };
+
+   Type type = Type::Null;
+   bool boolean = false;
+   double number = 0;
+   std::string string;
+   std::vector<JsonValue> elements;
+   std::vector<std::pair<std::string, JsonValue>> members;
+
+   /** Returns the member `name` or nullptr if this is not an object or has no such member. */
+   const JsonValue* find(const std::string& name) const {
+      for (const std::pair<std::string, JsonValue>& member : members) {
+         if (member.first == name) {
+            return &member.second;
+         }
+      }
+      return nullptr;
+   }
+};
+
+/** A minimal JSON parser for the lines of a hyperd log. Throws `std::runtime_error` on malformed input. */
+class JsonParser {
+   public:
+   static JsonValue parse(const std::string& text) {
+      JsonParser parser(text);
+      JsonValue value = parser.parseValue();
+      parser.skipWhitespace();
+      if (parser.position != text.size()) {
+         parser.fail("trailing characters");
+      }
+      return value;
+   }
+
+   private:
+   explicit JsonParser(const std::string& text) : text(text) {}
+
+   JsonValue parseValue() {
+      skipWhitespace();
+      if (position == text.size()) {
+         fail("unexpected end");
+      }
+      JsonValue value;
+      char c = text[position];
+      if (c == '{') {
+         value.type = JsonValue::Type::Object;
+         ++position;
+         if (!consume('}')) {
+            do {
+               skipWhitespace();
+               std::string name = parseString();
+               expect(':');
+               value.members.emplace_back(std::move(name), parseValue());
+            } while (consume(','));
+            expect('}');
+         }
+      } else if (c == '[') {
+         value.type = JsonValue::Type::Array;
+         ++position;
+         if (!consume(']')) {
+            do {
+               value.elements.push_back(parseValue());
+            } while (consume(','));
+            expect(']');
+         }
+      } else if (c == '"') {
+         value.type = JsonValue::Type::String;
+         value.string = parseString();
+      } else if (text.compare(position, 4, "true") == 0) {
+         value.type = JsonValue::Type::Bool;
+         value.boolean = true;
+         position += 4;
+      } else if (text.compare(position, 5, "false") == 0) {
+         value.type = JsonValue::Type::Bool;
+         position += 5;
+      } else if (text.compare(position, 4, "null") == 0) {
+         position += 4;
+      } else {
+         const char* begin = text.c_str() + position;
+         char* end;
+         value.type = JsonValue::Type::Number;
+         value.number = std::strtod(begin, &end);
+         if (end == begin) {
+            fail("unexpected character");
+         }
+         position += static_cast<size_t>(end - begin);
+      }
+      return value;
+   }
+
+   std::string parseString() {
+      expect('"');
+      std::string result;
+      while (true) {
+         if (position == text.size()) {
+            fail("unterminated string");
+         }
+         char c = text[position++];
+         if (c == '"') {
+            return result;
+         }
+         if (c != '\\') {
+            result += c;
+            continue;
+         }
+         if (position == text.size()) {
+            fail("unterminated escape");
+         }
+         c = text[position++];
+         switch (c) {
+            case 'n': result += '\n'; break;
+            case 't': result += '\t'; break;
+            case 'r': result += '\r'; break;
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'u': {
+               if (position + 4 > text.size()) {
+                  fail("invalid unicode escape");
+               }
+               unsigned long code = std::strtoul(text.substr(position, 4).c_str(), nullptr, 16);
+               position += 4;
+               // Encode as UTF-8. Surrogate pairs are passed through unpaired, which is good enough for a report.
+               if (code < 0x80) {
+                  result += static_cast<char>(code);
+               } else if (code < 0x800) {
+                  result += static_cast<char>(0xC0 | (code >> 6));
+                  result += static_cast<char>(0x80 | (code & 0x3F));
+               } else {
+                  result += static_cast<char>(0xE0 | (code >> 12));
+                  result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                  result += static_cast<char>(0x80 | (code & 0x3F));
+               }
+               break;
+            }
+            default: result += c; break;
+         }
+      }
+   }
+
+   void skipWhitespace() {
+      while ((position < text.size()) && ((text[position] == ' ') || (text[position] == '\t') || (text[position] == '\r') || (text[position] == '\n'))) {
+         ++position;
+      }
+   }
+
+   bool consume(char c) {
+      skipWhitespace();
+      if ((position < text.size()) && (text[position] == c)) {
+         ++position;
+         return true;
+      }
+      return false;
+   }
+
+   void expect(char c) {
+      if (!consume(c)) {
+         fail(std::string("expected '") + c + "'");
+      }
+   }
+
+   [[noreturn]] void fail(const std::string& message) const {
+      throw std::runtime_error("Invalid JSON at offset " + std::to_string(position) + ": " + message);
+   }
+
+   const std::string& text;
+   size_t position = 0;
+};
+
+/** A statement as recorded by a `query-end` event. */
+struct QueryLogEntry {
+   std::string timestamp;
+   std::string session;
+   /// The statement text. hyperd truncates long statements.
+   std::string text;
+   double elapsedSeconds = 0;
+   /// The `*-time` fields of the event in seconds, e.g., "parsing-time", "compilation-time" and "execution-time".
+   std::vector<std::pair<std::string, double>> phases;
+   /// The largest of the `*-memory-mb` fields of the event.
+   double peakMemoryMb = 0;
+   /// The number of spooling events of the session since its previous statement.
+   int64_t spillEvents = 0;
+   int64_t rows = -1;
+};
+
+/**
+ * Reads the `query-end` events of a hyperd log file.
+ * Lines that are no valid JSON, e.g., a line cut off by a crash, are counted and skipped.
+ */
+class HyperLogReader {
+   public:
+   explicit HyperLogReader(const std::string& path) : file(path) {
+      if (!file) {
+         throw std::runtime_error("Could not open " + path);
+      }
+   }
+
+   /** Reads the next statement. Returns false at the end of the file. */
+   bool next(QueryLogEntry& entry) {
+      std::string line;
+      while (std::getline(file, line)) {
+         if (line.empty() || (line[0] != '{')) {
+            continue;
+         }
+         JsonValue event;
+         try {
+            event = JsonParser::parse(line);
+         } catch (const std::runtime_error&) {
+            ++malformedLines;
+            continue;
+         }
+         const JsonValue* kind = event.find("k");
+         const JsonValue* payload = event.find("v");
+         if (!kind || (kind->type != JsonValue::Type::String)) {
+            continue;
+         }
+         std::string session = getString(event, "sess");
+         if (isSpillEvent(kind->string, payload)) {
+            ++pendingSpills[session];
+            continue;
+         }
+         if ((kind->string != "query-end") || !payload || (payload->type != JsonValue::Type::Object)) {
+            continue;
+         }
+
+         entry = QueryLogEntry();
+         entry.timestamp = getString(event, "ts");
+         entry.session = session;
+         entry.text = getString(*payload, "query");
+         if (entry.text.empty()) {
+            entry.text = getString(*payload, "text");
+         }
+         for (const std::pair<std::string, JsonValue>& member : payload->members) {
+            if (member.second.type != JsonValue::Type::Number) {
+               continue;
+            }
+            const std::string& name = member.first;
+            if (name == "elapsed") {
+               entry.elapsedSeconds = member.second.number;
+            } else if (name == "rows") {
+               entry.rows = static_cast<int64_t>(member.second.number);
+            } else if (endsWith(name, "-time")) {
+               entry.phases.emplace_back(name, member.second.number);
+            } else if (endsWith(name, "memory-mb")) {
+               entry.peakMemoryMb = std::max(entry.peakMemoryMb, member.second.number);
+            }
+         }
+         std::map<std::string, int64_t>::iterator spills = pendingSpills.find(session);
+         if (spills != pendingSpills.end()) {
+            entry.spillEvents = spills->second;
+            pendingSpills.erase(spills);
+         }
+         return true;
+      }
+      return false;
+   }
+
+   int64_t getMalformedLineCount() const { return malformedLines; }
+
+   private:
+   static bool endsWith(const std::string& value, const std::string& suffix) {
+      return (value.size() >= suffix.size()) && (value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0);
+   }
+
+   static std::string getString(const JsonValue& object, const std::string& name) {
+      const JsonValue* value = object.find(name);
+      return (value && (value->type == JsonValue::Type::String)) ? value->string : std::string();
+   }
+
+   /** Spooling shows up as events of its own and as fields of other events, depending on the hyperd version. */
+   static bool isSpillEvent(const std::string& kind, const JsonValue* payload) {
+      if ((kind.find("spool") != std::string::npos) || (kind.find("spill") != std::string::npos)) {
+         return true;
+      }
+      if (payload && (kind != "query-end")) {
+         for (const std::pair<std::string, JsonValue>& member : payload->members) {
+            if ((member.first.find("spool") != std::string::npos) && (member.second.type == JsonValue::Type::Bool) && member.second.boolean) {
+               return true;
+            }
+         }
+      }
+      return false;
+   }
+
+   std::ifstream file;
+   std::map<std::string, int64_t> pendingSpills;
+   int64_t malformedLines = 0;
+};
+
+/** Aggregates the statements of one or more log files and prints the slowest ones. */
+class QueryReport {
+   public:
+   explicit QueryReport(size_t slowestCount) : slowestCount(slowestCount) {}
+
+   /** Adds all statements of the log file at `path`. */
+   void addLogFile(const std::string& path) {
+      HyperLogReader reader(path);
+      QueryLogEntry entry;
+      while (reader.next(entry)) {
+         add(entry);
+      }
+      malformedLines += reader.getMalformedLineCount();
+   }
+
+   void add(const QueryLogEntry& entry) {
+      ++queryCount;
+      totalSeconds += entry.elapsedSeconds;
+      spillEvents += entry.spillEvents;
+      StatementStatistics& statistics = byStatement[getStatementKind(entry.text)];
+      ++statistics.count;
+      statistics.totalSeconds += entry.elapsedSeconds;
+      statistics.maxSeconds = std::max(statistics.maxSeconds, entry.elapsedSeconds);
+
+      // Keep only the slowest statements, ordered from slowest to fastest. A report of zero statements keeps none.
+      if (slowestCount == 0) {
+         return;
+      }
+      if ((slowest.size() < slowestCount) || (entry.elapsedSeconds > slowest.back().elapsedSeconds)) {
+         std::vector<QueryLogEntry>::iterator position = std::upper_bound(
+            slowest.begin(), slowest.end(), entry, [](const QueryLogEntry& a, const QueryLogEntry& b) { return a.elapsedSeconds > b.elapsedSeconds; });
+         slowest.insert(position, entry);
+         if (slowest.size() > slowestCount) {
+            slowest.pop_back();
+         }
+      }
+   }
+
+   int64_t getQueryCount() const { return queryCount; }
+
+   void print(std::ostream& out) const {
+      out << "Statements: " << queryCount << ", total elapsed: " << totalSeconds << " s, spill events: " << spillEvents
+          << ", malformed lines: " << malformedLines << std::endl;
+      out << std::endl << "By statement kind:" << std::endl;
+      for (const std::pair<const std::string, StatementStatistics>& statement : byStatement) {
+         out << "  " << std::left << std::setw(10) << statement.first << std::right << " count " << std::setw(6) << statement.second.count << "  total "
+             << statement.second.totalSeconds << " s  max " << statement.second.maxSeconds << " s" << std::endl;
+      }
+      out << std::endl << "Slowest statements:" << std::endl;
+      for (size_t i = 0; i < slowest.size(); ++i) {
+         const QueryLogEntry& entry = slowest[i];
+         out << "  " << (i + 1) << ". " << entry.elapsedSeconds << " s";
+         for (const std::pair<std::string, double>& phase : entry.phases) {
+            out << ", " << phase.first << " " << phase.second << " s";
+         }
+         if (entry.peakMemoryMb > 0) {
+            out << ", peak memory " << entry.peakMemoryMb << " MB";
+         }
+         if (entry.spillEvents > 0) {
+            out << ", " << entry.spillEvents << " spill events";
+         }
+         if (entry.rows >= 0) {
+            out << ", " << entry.rows << " rows";
+         }
+         out << std::endl << "     " << abbreviate(entry.text) << std::endl;
+      }
+   }
+
+   private:
+   struct StatementStatistics {
+      int64_t count = 0;
+      double totalSeconds = 0;
+      double maxSeconds = 0;
+   };
+
+   /** The first keyword of a statement, e.g., "SELECT" or "COPY". */
+   static std::string getStatementKind(const std::string& text) {
+      size_t begin = text.find_first_not_of(" \t\r\n(");
+      if (begin == std::string::npos) {
+         return "(unknown)";
+      }
+      size_t end = text.find_first_of(" \t\r\n(;", begin);
+      std::string kind = text.substr(begin, end - begin);
+      std::transform(kind.begin(), kind.end(), kind.begin(), [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+      return kind;
+   }
+
+   static std::string abbreviate(const std::string& text) {
+      std::string result;
+      for (char c : text) {
+         result += ((c == '\n') || (c == '\r') || (c == '\t')) ? ' ' : c;
+         if (result.size() == 117) {
+            return result + "...";
+         }
+      }
+      return result;
+   }
+
+   size_t slowestCount;
+   int64_t queryCount = 0;
+   double totalSeconds = 0;
+   int64_t spillEvents = 0;
+   int64_t malformedLines = 0;
+   std::map<std::string, StatementStatistics> byStatement;
+   std::vector<QueryLogEntry> slowest;
+};
+}
+
+#endif
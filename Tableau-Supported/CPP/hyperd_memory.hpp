@@ -0,0 +1,170 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file hyperd_memory.hpp
+ *
+ * Helpers to observe the resident memory of the hyperd process started by a `HyperProcess`.
+ *
+ * `HyperProcess` does not expose the process ID of hyperd, so it is looked up as the most recently started child
+ * process named "hyperd". The memory is read from `/proc`, so the helpers only work on Linux. On other platforms no
+ * process is found and all readings are zero.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_HYPERD_MEMORY_HPP
+#define TABLEAU_HYPER_SAMPLES_HYPERD_MEMORY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+namespace samples {
+
+/**
+ * Returns the process ID of the most recently started hyperd child process of this process, or -1 if there is none.
+ * Call it right after constructing the `HyperProcess` whose memory should be observed.
+ */
+inline int64_t findHyperdProcessId() {
+   int64_t result = -1;
+#if defined(__linux__)
+   const int64_t self = static_cast<int64_t>(::getpid());
+   uint64_t newestStart = 0;
+   DIR* proc = ::opendir("/proc");
+   if (!proc) {
+      return -1;
+   }
+   while (dirent* entry = ::readdir(proc)) {
+      char* end;
+      int64_t pid = std::strtoll(entry->d_name, &end, 10);
+      if ((*end != '\0') || (pid <= 0)) {
+         continue;
+      }
+      std::ifstream statFile("/proc/" + std::string(entry->d_name) + "/stat");
+      std::string stat;
+      if (!std::getline(statFile, stat)) {
+         continue;
+      }
+      // The format is "pid (comm) state ppid ...". The command name may contain spaces, so split at the last ')'.
+      size_t open = stat.find('('), close = stat.rfind(')');
+      if ((open == std::string::npos) || (close == std::string::npos) || (stat.compare(open + 1, close - open - 1, "hyperd") != 0)) {
+         continue;
+      }
+      std::istringstream fields(stat.substr(close + 2));
+      std::string state;
+      int64_t parent;
+      fields >> state >> parent;
+      if (parent != self) {
+         continue;
+      }
+      // State and parent are fields 3 and 4. Skip fields 5 to 21 to read field 22, the start time.
+      std::string field;
+      for (int i = 5; i < 22; ++i) {
+         fields >> field;
+      }
+      uint64_t start = 0;
+      fields >> start;
+      if ((result < 0) || (start >= newestStart)) {
+         result = pid;
+         newestStart = start;
+      }
+   }
+   ::closedir(proc);
+#endif
+   return result;
+}
+
+/**
+ * Returns a field of `/proc/<pid>/status` that is measured in kB, e.g., "VmRSS", in bytes. Returns 0 if the process
+ * or the field does not exist.
+ */
+inline uint64_t readProcessStatusBytes(int64_t pid, const std::string& field) {
+   if (pid < 0) {
+      return 0;
+   }
+   std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+   std::string line;
+   while (std::getline(status, line)) {
+      if ((line.compare(0, field.size(), field) == 0) && (line.size() > field.size()) && (line[field.size()] == ':')) {
+         return std::strtoull(line.c_str() + field.size() + 1, nullptr, 10) * 1024;
+      }
+   }
+   return 0;
+}
+
+/** The current resident memory of a process in bytes. */
+inline uint64_t getResidentBytes(int64_t pid) {
+   return readProcessStatusBytes(pid, "VmRSS");
+}
+
+/** The peak resident memory of a process since it was started, in bytes. */
+inline uint64_t getPeakResidentBytes(int64_t pid) {
+   return readProcessStatusBytes(pid, "VmHWM");
+}
+
+/**
+ * Samples the resident memory of a process in a background thread.
+ * The kernel only tracks the peak over the whole lifetime of the process, the monitor tracks the peak since the last
+ * call to `takePeak()`, so the peaks of the phases of a single process can be told apart.
+ */
+class MemoryMonitor {
+   public:
+   MemoryMonitor(int64_t pid, std::chrono::milliseconds interval) : pid(pid), interval(interval), thread([this] { run(); }) {}
+   MemoryMonitor(const MemoryMonitor&) = delete;
+   MemoryMonitor& operator=(const MemoryMonitor&) = delete;
+
+   ~MemoryMonitor() {
+      stopped.store(true);
+      thread.join();
+   }
+
+   /** The resident memory at the last sample. */
+   uint64_t getCurrent() const { return current.load(std::memory_order_relaxed); }
+
+   /** Returns the peak since the previous call and starts a new period. */
+   uint64_t takePeak() {
+      uint64_t now = getResidentBytes(pid);
+      current.store(now, std::memory_order_relaxed);
+      return std::max(peak.exchange(now, std::memory_order_relaxed), now);
+   }
+
+   private:
+   void run() {
+      while (!stopped.load()) {
+         uint64_t now = getResidentBytes(pid);
+         current.store(now, std::memory_order_relaxed);
+         uint64_t previous = peak.load(std::memory_order_relaxed);
+         while ((now > previous) && !peak.compare_exchange_weak(previous, now, std::memory_order_relaxed)) {
+         }
+         std::this_thread::sleep_for(interval);
+      }
+   }
+
+   const int64_t pid;
+   const std::chrono::milliseconds interval;
+   std::atomic<uint64_t> current{0};
+   std::atomic<uint64_t> peak{0};
+   std::atomic<bool> stopped{false};
+   std::thread thread;
+};
+}
+
+#endif
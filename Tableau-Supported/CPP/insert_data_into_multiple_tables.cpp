@@ -15,6 +15,8 @@
  * An example of how to create and insert into a multi-table Hyper file with different column types.
  */
 
+#include "instrumentation.hpp"
+
 #include <hyperapi/hyperapi.hpp>
 #include <iostream>
 #include <string>
@@ -60,67 +62,86 @@ static void runInsertDataIntoMultipleTables() {
    // Starts the Hyper Process with telemetry enabled to send data to Tableau.
    // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
    {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
       hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
       // Creates new Hyper file "superstore.hyper"
       // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
       {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
          hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
          const hyperapi::Catalog& catalog = connection.getCatalog();
 
          // Create multiple tables.
+         samples::PhaseTimer ddlTimer(samples::Phase::DDL);
          catalog.createTable(ordersTable);
          catalog.createTable(customerTable);
          catalog.createTable(productTable);
          catalog.createTable(lineItemsTable);
+         ddlTimer.stop();
 
          // Insert data into Orders table.
          {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
             hyperapi::Inserter inserter(connection, ordersTable);
             inserter.addRow(static_cast<int16_t>(399), "DK-13375", hyperapi::Date{2012, 9, 7}, "CA-2011-100006", hyperapi::Date{2012, 9, 13}, "Standard Class");
             inserter.addRow(static_cast<int16_t>(530), "EB-13705", hyperapi::Date{2012, 7, 8}, "CA-2011-100090", hyperapi::Date{2012, 7, 12}, "Standard Class");
-            inserter.execute();
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
          }
 
          // Insert data into Customer table.
          {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
             hyperapi::Inserter inserter(connection, customerTable);
             inserter.addRow("DK-13375", "Dennis Kane", 518, "Consumer");
             inserter.addRow("EB-13705", "Ed Braxton", 815, "Corporate");
-            inserter.execute();
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
          }
 
          // Insert individual row into Product table.
          {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
             hyperapi::Inserter inserter(connection, productTable);
             inserter.addRow("TEC-PH-10002075", "Technology", "Phones", "AT&T EL51110 DECT");
-            inserter.execute();
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
          }
 
          // Insert data into Line Items table.
          {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
             hyperapi::Inserter inserter(connection, lineItemsTable);
             inserter.addRow(2718, "CA-2011-100006", "TEC-PH-10002075", 377.97, int16_t{3}, 0.0, 109.6113);
             inserter.addRow(2719, "CA-2011-100090", "TEC-PH-10002075", 377.97, int16_t{3}, hyperapi::null, 109.6113);
-            inserter.execute();
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
          }
 
          for (auto& tableName : {ordersTable.getTableName(), customerTable.getTableName(), productTable.getTableName(), lineItemsTable.getTableName()}) {
             // `executeScalarQuery` is for executing a query that returns exactly one row with one column.
-            int64_t rowCount = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + tableName.toString());
+            int64_t rowCount =
+               samples::timePhase(samples::Phase::Query, [&] { return connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + tableName.toString()); });
             std::cout << "The number of rows in table " << tableName << " is " << rowCount << "." << std::endl;
          }
       }
       std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
    }
    std::cout << "The Hyper Process has been shut down." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
    try {
       runInsertDataIntoMultipleTables();
    } catch (const hyperapi::HyperException& e) {
       std::cout << e.toString() << std::endl;
       return 1;
    }
+   samples::reportMetrics(metricsFormat);
    return 0;
 }
@@ -0,0 +1,246 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example insert_data_with_checkpointed_commits.cpp
+ *
+ * An example of how to split a long load into transactions that commit every N rows or M seconds, together with
+ * a checkpoint from which the load can resume after a crash.
+ */
+
+#include "csv_reader.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <chrono>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** Stores how far the load of each source file has progressed. */
+static const hyperapi::TableDefinition checkpointsTable{
+   "Load Checkpoints",
+   {hyperapi::TableDefinition::Column{"Source", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Source Offset", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Rows Committed", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable}}};
+
+/** When to commit the rows inserted so far. A limit of zero disables that trigger. */
+struct CommitPolicy {
+   int64_t rowsPerCommit;
+   double secondsPerCommit;
+};
+
+/** The position in the source up to which all rows have been committed. */
+struct Checkpoint {
+   uint64_t sourceOffset;
+   int64_t rowsCommitted;
+};
+
+/** Thrown to simulate a crash of the loader in the middle of a transaction. */
+struct SimulatedCrash : std::runtime_error {
+   SimulatedCrash() : std::runtime_error("Simulated crash") {}
+};
+
+/**
+ * Returns the checkpoint of `source`, creating the checkpoint table and an initial checkpoint if necessary.
+ */
+static Checkpoint readCheckpoint(hyperapi::Connection& connection, const std::string& source) {
+   samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTableIfNotExists(checkpointsTable); });
+   {
+      samples::PhaseTimer queryTimer(samples::Phase::Query);
+      hyperapi::Result result = connection.executeQuery(
+         "SELECT " + hyperapi::escapeName("Source Offset") + ", " + hyperapi::escapeName("Rows Committed") + " FROM " +
+         checkpointsTable.getTableName().toString() + " WHERE " + hyperapi::escapeName("Source") + " = " + hyperapi::escapeStringLiteral(source));
+      for (const hyperapi::Row& row : result) {
+         return Checkpoint{static_cast<uint64_t>(row.get<int64_t>(0)), row.get<int64_t>(1)};
+      }
+   }
+   hyperapi::Inserter inserter(connection, checkpointsTable);
+   inserter.addRow(source, int64_t{0}, int64_t{0});
+   inserter.execute();
+   return Checkpoint{0, 0};
+}
+
+/**
+ * Loads the CSV file `source` into `table`, starting from the last checkpoint of a previous run.
+ *
+ * Every transaction inserts the rows read since the last commit and moves the checkpoint forward. Since the data and
+ * the checkpoint are committed together, a crash never loses committed rows and never inserts a row twice.
+ * If `crashAfterRows` is positive, the load simulates a crash after reading that many rows.
+ * Returns the number of commits.
+ */
+static int64_t loadWithCheckpoints(
+   hyperapi::Connection& connection, const hyperapi::TableDefinition& table, const std::string& source, const CommitPolicy& policy,
+   int64_t crashAfterRows = 0) {
+   samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTableIfNotExists(table); });
+   Checkpoint checkpoint = readCheckpoint(connection, source);
+
+   samples::CsvReader reader(source);
+   std::vector<std::string> fields;
+   if (checkpoint.sourceOffset == 0) {
+      reader.readRecord(fields); // Skip the header.
+   } else {
+      reader.seek(checkpoint.sourceOffset);
+   }
+   if (checkpoint.rowsCommitted > 0) {
+      std::cout << "Resuming " << source << " after " << checkpoint.rowsCommitted << " committed rows." << std::endl;
+   }
+
+   // Maps the fields of the CSV file to the columns of the table.
+   std::vector<std::string> header;
+   samples::CsvReader(source).readRecord(header);
+   std::vector<size_t> fieldOfColumn;
+   for (const hyperapi::TableDefinition::Column& column : table.getColumns()) {
+      size_t field = 0;
+      while ((field < header.size()) && (header[field] != column.getName().getUnescaped())) {
+         ++field;
+      }
+      if (field == header.size()) {
+         throw std::runtime_error("Column " + column.getName().toString() + " is missing in " + source);
+      }
+      fieldOfColumn.push_back(field);
+   }
+
+   int64_t commitCount = 0;
+   int64_t rowsRead = 0;
+   bool endOfSource = false;
+   while (!endOfSource) {
+      auto transactionStart = std::chrono::steady_clock::now();
+      int64_t rowsInTransaction = 0;
+      connection.executeCommand("BEGIN TRANSACTION");
+      {
+         samples::PhaseTimer insertTimer(samples::Phase::Insert);
+         hyperapi::Inserter inserter(connection, table);
+         while (true) {
+            if (!reader.readRecord(fields)) {
+               endOfSource = true;
+               break;
+            }
+            if ((crashAfterRows > 0) && (++rowsRead > crashAfterRows)) {
+               // The open transaction is rolled back by Hyper when the connection is closed.
+               throw SimulatedCrash();
+            }
+            for (size_t column = 0; column < fieldOfColumn.size(); ++column) {
+               samples::addCsvValue(inserter, table.getColumn(column), fields[fieldOfColumn[column]]);
+            }
+            inserter.endRow();
+            ++rowsInTransaction;
+
+            if ((policy.rowsPerCommit > 0) && (rowsInTransaction >= policy.rowsPerCommit)) {
+               break;
+            }
+            // Reading the clock is cheap, but not free, so the time limit is checked every 1024 rows only.
+            if ((policy.secondsPerCommit > 0) && (rowsInTransaction % 1024 == 0) &&
+                (std::chrono::duration<double>(std::chrono::steady_clock::now() - transactionStart).count() >= policy.secondsPerCommit)) {
+               break;
+            }
+         }
+         insertTimer.stop();
+         samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+      }
+      samples::PhaseTimer commitTimer(samples::Phase::Execute);
+      checkpoint.sourceOffset = reader.getOffset();
+      checkpoint.rowsCommitted += rowsInTransaction;
+      connection.executeCommand(
+         "UPDATE " + checkpointsTable.getTableName().toString() + " SET " + hyperapi::escapeName("Source Offset") + " = " +
+         std::to_string(checkpoint.sourceOffset) + ", " + hyperapi::escapeName("Rows Committed") + " = " + std::to_string(checkpoint.rowsCommitted) +
+         " WHERE " + hyperapi::escapeName("Source") + " = " + hyperapi::escapeStringLiteral(source));
+      connection.executeCommand("COMMIT");
+      commitTimer.stop();
+      ++commitCount;
+   }
+   return commitCount;
+}
+
+static void runInsertDataWithCheckpointedCommits() {
+   std::cout << "EXAMPLE - Load data in checkpointed transactions that can resume after a crash" << std::endl;
+   const std::string pathToCSV = "data/lineitems.csv";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Measure the throughput for different commit intervals. Every transaction has a fixed cost, so larger intervals
+      // are faster, while smaller intervals lose less work on a crash.
+      for (int64_t rowsPerCommit : {int64_t{500}, int64_t{2000}, int64_t{0}}) {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), "data/lineitems_checkpointed.hyper", hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         auto start = std::chrono::steady_clock::now();
+         int64_t commitCount = loadWithCheckpoints(connection, samples::lineItemsTable, pathToCSV, CommitPolicy{rowsPerCommit, 0});
+         double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         int64_t rowCount = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + samples::lineItemsTable.getTableName().toString());
+         std::cout << "Commit every " << (rowsPerCommit > 0 ? std::to_string(rowsPerCommit) + " rows" : std::string("load once")) << ": " << rowCount
+                   << " rows in " << commitCount << " commits, " << seconds << " s (" << static_cast<double>(rowCount) / seconds << " rows/s)."
+                   << std::endl;
+      }
+
+      // Crash in the middle of a load and resume it.
+      const std::string pathToDatabase = "data/lineitems_resumed.hyper";
+      const CommitPolicy policy{1000, 5.0};
+      try {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         loadWithCheckpoints(connection, samples::lineItemsTable, pathToCSV, policy, 4500);
+      } catch (const SimulatedCrash& e) {
+         std::cout << e.what() << " while loading " << pathToCSV << "." << std::endl;
+      }
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
+         loadWithCheckpoints(connection, samples::lineItemsTable, pathToCSV, policy);
+
+         int64_t rowCount = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + samples::lineItemsTable.getTableName().toString());
+         int64_t distinctCount = connection.executeScalarQuery<int64_t>(
+            "SELECT COUNT(DISTINCT " + hyperapi::escapeName("Line Item ID") + ") FROM " + samples::lineItemsTable.getTableName().toString());
+         std::cout << "The number of rows in table " << samples::lineItemsTable.getTableName() << " is " << rowCount << "." << std::endl;
+         if (rowCount != distinctCount) {
+            throw std::runtime_error("The resumed load inserted rows twice.");
+         }
+         // The resumed load must also not have skipped any row of the CSV file.
+         samples::CsvReader reader(pathToCSV);
+         std::vector<std::string> fields;
+         int64_t recordCount = -1; // Without the header.
+         while (reader.readRecord(fields)) {
+            ++recordCount;
+         }
+         if (rowCount != recordCount) {
+            throw std::runtime_error("The resumed load inserted " + std::to_string(rowCount) + " of the " + std::to_string(recordCount) + " rows.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
+   try {
+      runInsertDataWithCheckpointedCommits();
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,176 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example insert_data_with_column_batches.cpp
+ *
+ * An example of how to buffer rows column by column before handing them to the inserter, compared to building the
+ * text values of every row as `std::string`s.
+ */
+
+#include "column_batch.hpp"
+#include "instrumentation.hpp"
+#include "typed_table.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef samples::TypedTable<int64_t, std::string, std::string, double, int16_t, hyperapi::optional<double>, double> LineItemsTable;
+
+/**
+ * Helper function writing `prefix` followed by `number` into `buffer` without allocating
+ */
+static hyperapi::string_view formatId(char (&buffer)[32], const char* prefix, int64_t number) {
+   char digits[20];
+   size_t digitCount = 0;
+   do {
+      digits[digitCount++] = static_cast<char>('0' + number % 10);
+      number /= 10;
+   } while (number > 0);
+   size_t length = 0;
+   while (*prefix) {
+      buffer[length++] = *prefix++;
+   }
+   while (digitCount > 0) {
+      buffer[length++] = digits[--digitCount];
+   }
+   return hyperapi::string_view(buffer, length);
+}
+
+/**
+ * The way the rows are produced today: Every text value becomes a `std::string` that is passed to `addRow`.
+ */
+static void insertRowByRow(hyperapi::Connection& connection, const LineItemsTable& table, int64_t rowCount) {
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   hyperapi::Inserter inserter(connection, table.getDefinition());
+   char orderBuffer[32], productBuffer[32];
+   for (int64_t i = 0; i < rowCount; ++i) {
+      std::string orderId(formatId(orderBuffer, "CA-2011-", i / 4));
+      std::string productId(formatId(productBuffer, "TEC-PH-", 10000000 + i % 1800));
+      hyperapi::optional<double> discount;
+      if (i % 3 != 0) {
+         discount = 0.1 * static_cast<double>(i % 4);
+      }
+      inserter.addRow(i, orderId, productId, static_cast<double>(i % 1000) + 0.97, static_cast<int16_t>(1 + i % 9), discount, static_cast<double>(i % 97));
+   }
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+}
+
+/**
+ * The same rows appended to a column batch. The text values are views into a stack buffer that are copied into the
+ * batch's arena, so no row allocates.
+ */
+static void insertInColumnBatches(hyperapi::Connection& connection, const LineItemsTable& table, int64_t rowCount, size_t batchSize) {
+   samples::PhaseTimer insertTimer(samples::Phase::Insert);
+   hyperapi::Inserter inserter(connection, table.getDefinition());
+   samples::ColumnBatch<LineItemsTable> batch(batchSize);
+   char orderBuffer[32], productBuffer[32];
+   for (int64_t i = 0; i < rowCount; ++i) {
+      hyperapi::string_view orderId = formatId(orderBuffer, "CA-2011-", i / 4);
+      hyperapi::string_view productId = formatId(productBuffer, "TEC-PH-", 10000000 + i % 1800);
+      bool isFull = (i % 3 != 0) ? batch.addRow(i, orderId, productId, static_cast<double>(i % 1000) + 0.97, static_cast<int16_t>(1 + i % 9),
+                                                0.1 * static_cast<double>(i % 4), static_cast<double>(i % 97))
+                                 : batch.addRow(i, orderId, productId, static_cast<double>(i % 1000) + 0.97, static_cast<int16_t>(1 + i % 9),
+                                                hyperapi::null, static_cast<double>(i % 97));
+      if (isFull) {
+         batch.flush(inserter);
+      }
+   }
+   batch.flush(inserter);
+   insertTimer.stop();
+   samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+}
+
+/**
+ * Helper function returning the seconds elapsed since `start`
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void runInsertDataWithColumnBatches(int64_t rowCount, size_t batchSize) {
+   std::cout << "EXAMPLE - Insert data from struct-of-arrays batches" << std::endl;
+   const std::string pathToDatabase = "data/column_batches.hyper";
+   const char* const columnNames[] = {"Line Item ID", "Order ID", "Product ID", "Sales", "Quantity", "Discount", "Profit"};
+   const LineItemsTable rowByRowTable{"Line Items Row By Row", columnNames};
+   const LineItemsTable columnBatchTable{"Line Items Column Batches", columnNames};
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "column_batches.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         samples::PhaseTimer ddlTimer(samples::Phase::DDL);
+         connection.getCatalog().createTable(rowByRowTable.getDefinition());
+         connection.getCatalog().createTable(columnBatchTable.getDefinition());
+         ddlTimer.stop();
+
+         auto start = std::chrono::steady_clock::now();
+         insertRowByRow(connection, rowByRowTable, rowCount);
+         double rowByRowSeconds = secondsSince(start);
+
+         start = std::chrono::steady_clock::now();
+         insertInColumnBatches(connection, columnBatchTable, rowCount, batchSize);
+         double columnBatchSeconds = secondsSince(start);
+
+         std::cout << "Row by row:     " << static_cast<int64_t>(static_cast<double>(rowCount) / rowByRowSeconds) << " rows/s" << std::endl;
+         std::cout << "Column batches: " << static_cast<int64_t>(static_cast<double>(rowCount) / columnBatchSeconds) << " rows/s (" << batchSize
+                   << " rows per batch)" << std::endl;
+
+         // Both tables must contain the same rows.
+         int64_t differentRows = samples::timePhase(samples::Phase::Query, [&] {
+            return connection.executeScalarQuery<int64_t>(
+               "SELECT COUNT(*) FROM ((SELECT * FROM " + rowByRowTable.getTableName().toString() + " EXCEPT ALL SELECT * FROM " +
+               columnBatchTable.getTableName().toString() + ") UNION ALL (SELECT * FROM " + columnBatchTable.getTableName().toString() +
+               " EXCEPT ALL SELECT * FROM " + rowByRowTable.getTableName().toString() + ")) AS differences");
+         });
+         if (differentRows != 0) {
+            throw std::runtime_error("The column batches inserted different rows.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of rows and the rows per batch can be passed on the command line.
+   int64_t rowCount = (arguments.size() > 0) ? std::atoll(arguments[0].c_str()) : 1000000;
+   size_t batchSize = (arguments.size() > 1) ? std::strtoull(arguments[1].c_str(), nullptr, 10) : 65536;
+   try {
+      runInsertDataWithColumnBatches(rowCount, batchSize);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
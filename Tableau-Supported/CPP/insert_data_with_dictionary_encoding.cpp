@@ -0,0 +1,151 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example insert_data_with_dictionary_encoding.cpp
+ *
+ * An example of how to send low-cardinality text columns as dictionary codes and restore the text inside Hyper,
+ * compared to inserting the text of every row.
+ */
+
+#include "dictionary_encoding.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <chrono>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** A CSV file of the superstore dataset and the table it is loaded into. */
+struct CsvFile {
+   std::string path;
+   const hyperapi::TableDefinition* table;
+};
+
+/**
+ * Helper function returning `table` moved into `schema`
+ */
+static hyperapi::TableDefinition inSchema(const hyperapi::TableDefinition& table, const hyperapi::SchemaName& schema) {
+   hyperapi::TableDefinition copy(table);
+   copy.setTableName(hyperapi::TableName(schema, table.getTableName().getName()));
+   return copy;
+}
+
+/**
+ * Loads all files into tables in `schema` and returns the bytes sent to Hyper.
+ */
+static uint64_t loadFiles(hyperapi::Connection& connection, const std::vector<CsvFile>& files, const hyperapi::SchemaName& schema, bool dictionaryEncode) {
+   samples::CsvLoadOptions options;
+   options.dictionaryEncode = dictionaryEncode;
+   uint64_t bytesSent = 0;
+   for (const CsvFile& file : files) {
+      hyperapi::TableDefinition table = inSchema(*file.table, schema);
+      samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(table); });
+      samples::CsvLoadResult result = samples::loadCsv(connection, file.path, table, options);
+      bytesSent += result.bytesSent;
+
+      std::cout << "  " << table.getTableName() << ": " << result.rowCount << " rows, " << result.bytesSent << " bytes";
+      if (!result.encodedColumns.empty()) {
+         std::cout << ", encoded:";
+         for (const std::string& column : result.encodedColumns) {
+            std::cout << " \"" << column << "\"";
+         }
+      }
+      std::cout << std::endl;
+   }
+   return bytesSent;
+}
+
+/**
+ * Helper function returning the seconds elapsed since `start`
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void runInsertDataWithDictionaryEncoding() {
+   std::cout << "EXAMPLE - Insert low-cardinality text columns as dictionary codes" << std::endl;
+   const std::string pathToDatabase = "data/dictionary_encoding.hyper";
+   const std::vector<CsvFile> files = {
+      {"data/orders.csv", &samples::ordersTable}, {"data/customers.csv", &samples::customerTable}, {"data/products.csv", &samples::productTable}};
+   const hyperapi::SchemaName plainSchema("Plain");
+   const hyperapi::SchemaName encodedSchema("Encoded");
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "dictionary_encoding.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         samples::timePhase(samples::Phase::DDL, [&] {
+            connection.getCatalog().createSchema(plainSchema);
+            connection.getCatalog().createSchema(encodedSchema);
+         });
+
+         std::cout << "Plain text:" << std::endl;
+         auto start = std::chrono::steady_clock::now();
+         uint64_t plainBytes = loadFiles(connection, files, plainSchema, false);
+         double plainSeconds = secondsSince(start);
+
+         std::cout << "Dictionary-encoded:" << std::endl;
+         start = std::chrono::steady_clock::now();
+         uint64_t encodedBytes = loadFiles(connection, files, encodedSchema, true);
+         double encodedSeconds = secondsSince(start);
+
+         std::cout << "Plain text:         " << plainBytes << " bytes sent in " << plainSeconds << " s" << std::endl;
+         std::cout << "Dictionary-encoded: " << encodedBytes << " bytes sent in " << encodedSeconds << " s ("
+                   << 100.0 * static_cast<double>(encodedBytes) / static_cast<double>(plainBytes) << "% of the bytes)" << std::endl;
+
+         // Both schemas must contain the same rows.
+         for (const CsvFile& file : files) {
+            const std::string plain = inSchema(*file.table, plainSchema).getTableName().toString();
+            const std::string encoded = inSchema(*file.table, encodedSchema).getTableName().toString();
+            int64_t differentRows = samples::timePhase(samples::Phase::Query, [&] {
+               return connection.executeScalarQuery<int64_t>(
+                  "SELECT COUNT(*) FROM ((SELECT * FROM " + plain + " EXCEPT ALL SELECT * FROM " + encoded + ") UNION ALL (SELECT * FROM " + encoded +
+                  " EXCEPT ALL SELECT * FROM " + plain + ")) AS differences");
+            });
+            if (differentRows != 0) {
+               throw std::runtime_error("The dictionary-encoded load of " + file.path + " inserted different rows.");
+            }
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
+   try {
+      runInsertDataWithDictionaryEncoding();
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -15,6 +15,8 @@
  * An example of how to push down computations to Hyper during data insertion using expressions.
  */
 
+#include "instrumentation.hpp"
+
 #include <hyperapi/hyperapi.hpp>
 #include <iostream>
 #include <string>
@@ -36,16 +38,22 @@ static void runInsertDataWithExpressions() {
    // Starts the Hyper Process with telemetry enabled to send data to Tableau.
    // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
    {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
       hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
       // Creates new Hyper file "orders.hyper".
       // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
       {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
          hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
          const hyperapi::Catalog& catalog = connection.getCatalog();
 
          // Create the schema and the table.
+         samples::PhaseTimer ddlTimer(samples::Phase::DDL);
          catalog.createSchema("Extract");
          catalog.createTable(extractTable);
+         ddlTimer.stop();
 
          // Hyper API's Inserter allows users to transform data during insertion.
          // To make use of data transformation during insertion, the inserter requires the following inputs
@@ -87,28 +95,35 @@ static void runInsertDataWithExpressions() {
 
          // Insert data into the "Extract"."Extract" table using expressions.
          {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
             hyperapi::Inserter inserter(connection, extractTable, columnMappings, inserterDefinition);
             inserter.addRow(399, "2012-09-13 10:00:00", "Express Class", "Urgent");
             inserter.addRow(530, "2012-07-12 14:00:00", "Standard Class", "Low");
-            inserter.execute();
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
          }
 
          // Number of rows in the "Extract"."Extract" table.
          // `executeScalarQuery` is for executing a query that returns exactly one row with one column.
-         int64_t rowCount = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + extractTable.getTableName().toString());
+         int64_t rowCount = samples::timePhase(
+            samples::Phase::Query, [&] { return connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + extractTable.getTableName().toString()); });
          std::cout << "The number of rows in table " << extractTable.getTableName() << " is " << rowCount << "." << std::endl;
       }
       std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
    }
    std::cout << "The Hyper Process has been shut down." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
    try {
       runInsertDataWithExpressions();
    } catch (const hyperapi::HyperException& e) {
       std::cout << e.toString() << std::endl;
       return 1;
    }
+   samples::reportMetrics(metricsFormat);
    return 0;
 }
@@ -0,0 +1,321 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example insert_data_with_live_metrics.cpp
+ *
+ * An example of a multi-threaded loader that exports live metrics in the Prometheus text format, either to a file
+ * or on a local HTTP endpoint.
+ */
+
+#include "hyperd_memory.hpp"
+#include "instrumentation.hpp"
+#include "metrics_registry.hpp"
+#include "superstore_normalized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <signal.h>
+#endif
+
+/**
+ * The metrics the loader exports.
+ */
+struct LoaderMetrics {
+   explicit LoaderMetrics(samples::MetricsRegistry& registry)
+      : rowsInserted(registry.counter("hyper_rows_inserted_total", "Rows sent to Hyper with an inserter.")),
+        bytesSent(registry.counter("hyper_inserter_bytes_total", "Approximate payload bytes sent to Hyper with an inserter.")),
+        rowsCopied(registry.counter("hyper_rows_copied_total", "Rows loaded with COPY.")),
+        copyDuration(registry.histogram("hyper_copy_duration_seconds", "Duration of COPY commands.")),
+        connectionsOpen(registry.gauge("hyper_connections_open", "Connections currently held by loader threads.")),
+        hyperRestarts(registry.counter("hyper_process_restarts_total", "Number of times the Hyper process had to be restarted.")) {}
+
+   samples::Counter& rowsInserted;
+   samples::Counter& bytesSent;
+   samples::Counter& rowsCopied;
+   samples::Histogram& copyDuration;
+   samples::Gauge& connectionsOpen;
+   samples::Counter& hyperRestarts;
+};
+
+/**
+ * Keeps a Hyper process running for a loader. `ensureRunning()` checks that the process still answers queries and
+ * starts a new one if it does not, counting the restart.
+ */
+class HyperSupervisor {
+   public:
+   explicit HyperSupervisor(samples::Counter& restarts) : restarts(restarts) { start(); }
+
+   hyperapi::Endpoint getEndpoint() const { return process->getEndpoint(); }
+
+   /** Restarts the Hyper process if it does not answer. Returns whether it had to be restarted. */
+   bool ensureRunning() {
+      if (isResponding()) {
+         return false;
+      }
+      std::cout << "The Hyper process does not respond, starting a new one." << std::endl;
+      try {
+         process->close();
+      } catch (const hyperapi::HyperException& e) {
+         // The old process is gone either way, only report why it did not shut down cleanly.
+         std::cout << "The old Hyper process did not shut down cleanly: " << e.what() << std::endl;
+      }
+      start();
+      restarts.increment();
+      return true;
+   }
+
+   void close() { samples::timePhase(samples::Phase::Shutdown, [&] { process->close(); }); }
+
+   private:
+   void start() {
+      // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+      // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      process.reset(new hyperapi::HyperProcess(hyperapi::Telemetry::SendUsageDataToTableau));
+   }
+
+   bool isResponding() const {
+      try {
+         hyperapi::Connection connection(process->getEndpoint());
+         connection.executeScalarQuery<int32_t>("SELECT 1");
+         return true;
+      } catch (const hyperapi::HyperException&) {
+         return false;
+      }
+   }
+
+   samples::Counter& restarts;
+   std::unique_ptr<hyperapi::HyperProcess> process;
+};
+
+/**
+ * Kills the hyperd process of this process to simulate a crash and waits until it has exited. Returns whether there
+ * was one to kill, which is only the case on Linux.
+ */
+static bool simulateHyperCrash() {
+#if defined(__linux__)
+   int64_t hyperd = samples::findHyperdProcessId();
+   if ((hyperd < 0) || (::kill(static_cast<pid_t>(hyperd), SIGKILL) != 0)) {
+      return false;
+   }
+   // The killed process stays a zombie until `HyperProcess` reaps it, so wait for that state instead of its absence.
+   const std::string pathToStat = "/proc/" + std::to_string(hyperd) + "/stat";
+   while (true) {
+      std::ifstream statFile(pathToStat);
+      std::string stat;
+      if (!std::getline(statFile, stat) || (stat.compare(stat.rfind(')') + 2, 1, "Z") == 0)) {
+         break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+   std::cout << "Killed hyperd to simulate a crash." << std::endl;
+   return true;
+#else
+   return false;
+#endif
+}
+
+/** Counts a connection as open for as long as it lives. */
+class TrackedConnection {
+   public:
+   TrackedConnection(const hyperapi::Endpoint& endpoint, const std::string& database, samples::Gauge& connectionsOpen)
+      : connection(endpoint, database, hyperapi::CreateMode::None, samples::superstoreConnectionParameters()), connectionsOpen(connectionsOpen) {
+      connectionsOpen.add(1);
+   }
+   ~TrackedConnection() { connectionsOpen.add(-1); }
+
+   hyperapi::Connection connection;
+
+   private:
+   samples::Gauge& connectionsOpen;
+};
+
+/**
+ * Returns the name of the orders table a worker loads into
+ */
+static hyperapi::TableName getWorkerTable(int worker) {
+   return hyperapi::TableName("Orders " + std::to_string(worker));
+}
+
+/**
+ * Loads `data/orders.csv` once with COPY and then inserts `rowCount` synthetic orders with an inserter.
+ */
+static void runWorker(const hyperapi::Endpoint& endpoint, const std::string& pathToDatabase, int worker, int64_t rowCount, LoaderMetrics& metrics) {
+   TrackedConnection tracked(endpoint, pathToDatabase, metrics.connectionsOpen);
+   hyperapi::Connection& connection = tracked.connection;
+   const std::string table = getWorkerTable(worker).toString();
+
+   {
+      samples::PhaseTimer executeTimer(samples::Phase::Execute);
+      auto start = std::chrono::steady_clock::now();
+      int64_t copiedRows = connection.executeCommand(
+         "COPY " + table + " from " + hyperapi::escapeStringLiteral("data/orders.csv") + " with (format csv, delimiter ',', header)");
+      metrics.copyDuration.record(
+         static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+      metrics.rowsCopied.increment(static_cast<uint64_t>(copiedRows));
+   }
+
+   // Send the rows in batches, so the counters advance while the load is running.
+   const int64_t batchSize = 10000;
+   const std::string shipMode = "Standard Class";
+   for (int64_t batchStart = 0; batchStart < rowCount; batchStart += batchSize) {
+      samples::PhaseTimer insertTimer(samples::Phase::Insert);
+      hyperapi::Inserter inserter(connection, getWorkerTable(worker));
+      uint64_t bytes = 0;
+      int64_t batchEnd = std::min(batchStart + batchSize, rowCount);
+      for (int64_t i = batchStart; i < batchEnd; ++i) {
+         std::string customerId = "CU-" + std::to_string(i % 1000);
+         std::string orderId = "W" + std::to_string(worker) + "-" + std::to_string(i);
+         inserter.addRow(static_cast<int16_t>(i % 100), customerId, hyperapi::Date{2024, 1, 1}, orderId, hyperapi::Date{2024, 1, 3}, shipMode);
+         // Fixed-size values count with their binary size, text values with their length.
+         bytes += sizeof(int16_t) + 2 * sizeof(uint32_t) + customerId.size() + orderId.size() + shipMode.size();
+      }
+      insertTimer.stop();
+      samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+      metrics.rowsInserted.increment(static_cast<uint64_t>(batchEnd - batchStart));
+      metrics.bytesSent.increment(bytes);
+   }
+}
+
+/**
+ * Runs the load with `workerCount` threads, each with its own connection and table.
+ * If `metricsPort` is not zero, the metrics are also served on `http://127.0.0.1:<metricsPort>/metrics` (POSIX only).
+ */
+static void runInsertDataWithLiveMetrics(int workerCount, int64_t rowsPerWorker, uint16_t metricsPort) {
+   std::cout << "EXAMPLE - Export live metrics of a multi-threaded loader" << std::endl;
+   const std::string pathToDatabase = "data/live_metrics.hyper";
+   const std::string pathToMetrics = "data/live_metrics.prom";
+
+   samples::MetricsRegistry registry;
+   LoaderMetrics metrics(registry);
+   samples::addPhaseMetrics(registry);
+
+#if !defined(_WIN32)
+   std::unique_ptr<samples::MetricsHttpServer> server;
+   if (metricsPort != 0) {
+      server.reset(new samples::MetricsHttpServer(registry, metricsPort));
+      std::cout << "Serving metrics on http://127.0.0.1:" << server->getPort() << "/metrics" << std::endl;
+   }
+#else
+   if (metricsPort != 0) {
+      std::cout << "The metrics endpoint is not available on Windows, the metrics are only written to " << pathToMetrics << std::endl;
+   }
+#endif
+
+   {
+      // Write the metrics every second while the load is running, the way a textfile collector expects them.
+      samples::MetricsFileWriter fileWriter(registry, pathToMetrics, std::chrono::milliseconds(1000));
+
+      // The supervisor starts the Hyper process and starts a new one whenever the old one stopped answering. The
+      // sample kills the first process once to show the restart in "hyper_process_restarts_total".
+      {
+         HyperSupervisor hyper(metrics.hyperRestarts);
+         bool crashed = simulateHyperCrash();
+         hyper.ensureRunning();
+
+         // Creates new Hyper file "live_metrics.hyper" with one table per worker. The tables are created upfront, so
+         // the workers do not change the catalog concurrently.
+         {
+            samples::PhaseTimer connectTimer(samples::Phase::Connect);
+            hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+            connectTimer.stop();
+            samples::PhaseTimer ddlTimer(samples::Phase::DDL);
+            for (int worker = 0; worker < workerCount; ++worker) {
+               connection.getCatalog().createTable(
+                  hyperapi::TableDefinition(getWorkerTable(worker), samples::ordersTable.getColumns(), hyperapi::Persistence::Permanent));
+            }
+         }
+
+         // Run the workers. An exception of a worker is rethrown after all workers have finished.
+         std::vector<std::thread> workers;
+         std::vector<std::exception_ptr> errors(static_cast<size_t>(workerCount));
+         for (int worker = 0; worker < workerCount; ++worker) {
+            workers.emplace_back([&, worker] {
+               try {
+                  runWorker(hyper.getEndpoint(), pathToDatabase, worker, rowsPerWorker, metrics);
+               } catch (...) {
+                  errors[static_cast<size_t>(worker)] = std::current_exception();
+               }
+            });
+         }
+         for (std::thread& worker : workers) {
+            worker.join();
+         }
+         for (const std::exception_ptr& error : errors) {
+            if (error) {
+               std::rethrow_exception(error);
+            }
+         }
+
+         // The counters must agree with the contents of the Hyper file.
+         {
+            hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+            int64_t rowCount = 0;
+            for (int worker = 0; worker < workerCount; ++worker) {
+               rowCount += samples::timePhase(
+                  samples::Phase::Query, [&] { return connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + getWorkerTable(worker).toString()); });
+            }
+            std::cout << "The number of rows in all tables is " << rowCount << "." << std::endl;
+            if (static_cast<uint64_t>(rowCount) != metrics.rowsInserted.getValue() + metrics.rowsCopied.getValue()) {
+               throw std::runtime_error("The row counters do not match the number of rows in the Hyper file.");
+            }
+            if (metrics.connectionsOpen.getValue() != 0) {
+               throw std::runtime_error("The connection gauge did not return to zero.");
+            }
+            if (metrics.hyperRestarts.getValue() != (crashed ? 1u : 0u)) {
+               throw std::runtime_error("The restart counter does not match the number of restarts.");
+            }
+         }
+         std::cout << "The connection to the Hyper file has been closed." << std::endl;
+         hyper.close();
+      }
+      std::cout << "The Hyper Process has been shut down." << std::endl;
+   }
+
+   std::cout << "Inserted " << metrics.rowsInserted.getValue() << " rows (" << metrics.bytesSent.getValue() << " bytes) and copied "
+             << metrics.rowsCopied.getValue() << " rows in " << metrics.copyDuration.getCount() << " COPY commands. The Hyper process was restarted "
+             << metrics.hyperRestarts.getValue() << " times." << std::endl;
+   std::cout << "The final metrics have been written to " << pathToMetrics << "." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of worker threads, the rows per worker and a port for the metrics endpoint can be passed
+   // on the command line.
+   int workerCount = (arguments.size() > 0) ? std::atoi(arguments[0].c_str()) : 4;
+   int64_t rowsPerWorker = (arguments.size() > 1) ? std::atoll(arguments[1].c_str()) : 100000;
+   uint16_t metricsPort = (arguments.size() > 2) ? static_cast<uint16_t>(std::atoi(arguments[2].c_str())) : 0;
+   try {
+      runInsertDataWithLiveMetrics(workerCount, rowsPerWorker, metricsPort);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -0,0 +1,252 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example insert_data_with_memory_budget.cpp
+ *
+ * An example of a loader that keeps the resident memory of hyperd below a budget by throttling the inserter and by
+ * splitting COPY commands into smaller batches when the memory gets close to the budget.
+ */
+
+#include "csv_chunks.hpp"
+#include "hyperd_memory.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** The line items with the columns in the order of "lineitems.csv", so they can be copied without a column list. */
+static const hyperapi::TableDefinition lineItemsTable{
+   "Line Items",
+   {hyperapi::TableDefinition::Column{"Discount", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::Nullable},
+    hyperapi::TableDefinition::Column{"Line Item ID", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Order ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Product ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Profit", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Quantity", hyperapi::SqlType::smallInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Sales", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable}}};
+
+/**
+ * Decides how much work the loader may hand to hyperd at once, based on hyperd's resident memory.
+ *
+ * Batches start at the smallest size and double while the memory stays below 60% of the budget. Above 80% of the
+ * budget, the loader flushes what it has, waits for the memory to drop below 60% of the budget and halves its batch
+ * size. hyperd does not always return freed memory to the operating system right away, so the wait is bounded by
+ * `maxWait` and the loader then continues with the smaller batch size.
+ */
+class MemoryGovernor {
+   public:
+   MemoryGovernor(samples::MemoryMonitor& monitor, uint64_t budgetBytes)
+      : monitor(monitor), throttleBytes(static_cast<uint64_t>(0.8 * static_cast<double>(budgetBytes))),
+        resumeBytes(static_cast<uint64_t>(0.6 * static_cast<double>(budgetBytes))) {}
+
+   bool isAboveThrottle() const { return monitor.getCurrent() > throttleBytes; }
+
+   /** Adjusts a batch size to the peak memory of the previous batch and waits if the memory is above the throttle. */
+   int64_t adjustBatchSize(int64_t batchSize, int64_t minBatchSize, int64_t maxBatchSize, uint64_t previousPeak) {
+      if (previousPeak > throttleBytes) {
+         ++throttleCount;
+         waitForResume();
+         return std::max(minBatchSize, batchSize / 2);
+      }
+      if (previousPeak < resumeBytes) {
+         return std::min(maxBatchSize, batchSize * 2);
+      }
+      return batchSize;
+   }
+
+   void waitForResume() {
+      auto start = std::chrono::steady_clock::now();
+      while ((monitor.getCurrent() > resumeBytes) && (std::chrono::steady_clock::now() - start < maxWait)) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+      waitedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   int64_t getThrottleCount() const { return throttleCount; }
+   double getWaitedSeconds() const { return waitedSeconds; }
+
+   private:
+   const std::chrono::seconds maxWait{5};
+   samples::MemoryMonitor& monitor;
+   const uint64_t throttleBytes;
+   const uint64_t resumeBytes;
+   int64_t throttleCount = 0;
+   double waitedSeconds = 0;
+};
+
+/** Removes a file when it goes out of scope, also if an exception is thrown. */
+struct RemoveFileOnExit {
+   explicit RemoveFileOnExit(std::string path) : path(std::move(path)) {}
+   RemoveFileOnExit(const RemoveFileOnExit&) = delete;
+   RemoveFileOnExit& operator=(const RemoveFileOnExit&) = delete;
+   ~RemoveFileOnExit() { std::remove(path.c_str()); }
+   const std::string path;
+};
+
+/**
+ * Copies `pathToCSV` into `table` in batches of small chunks. The first COPY loads a single chunk, and the number of
+ * chunks per COPY follows the memory governor from there. Returns the number of copied rows.
+ */
+static int64_t copyWithinBudget(
+   hyperapi::Connection& connection, const hyperapi::TableDefinition& table, const std::string& pathToCSV, samples::MemoryMonitor& monitor,
+   MemoryGovernor& governor) {
+   uint64_t fileSize;
+   std::vector<samples::CsvChunk> chunks = samples::splitCsvIntoChunks(pathToCSV, 64 * 1024, fileSize);
+   // The batch file is removed also if a COPY fails.
+   RemoveFileOnExit batchFile(pathToCSV + ".batch");
+   const std::string& pathToBatch = batchFile.path;
+   const int64_t maxChunksPerCopy = static_cast<int64_t>(chunks.size());
+   int64_t chunksPerCopy = 1;
+   int64_t rowCount = 0;
+   int copyCount = 0;
+   monitor.takePeak();
+   for (size_t next = 0; next < chunks.size(); ++copyCount) {
+      size_t last = std::min(chunks.size(), next + static_cast<size_t>(chunksPerCopy)) - 1;
+      samples::copyFileRange(pathToCSV, samples::CsvChunk(chunks[next].first, chunks[last].second), pathToBatch);
+      {
+         samples::PhaseTimer executeTimer(samples::Phase::Execute);
+         rowCount += connection.executeCommand(
+            "COPY " + table.getTableName().toString() + " from " + hyperapi::escapeStringLiteral(pathToBatch) + " with (format csv, delimiter ',')");
+      }
+      next = last + 1;
+      chunksPerCopy = governor.adjustBatchSize(chunksPerCopy, 1, maxChunksPerCopy, monitor.takePeak());
+   }
+   std::cout << "Copied " << rowCount << " rows from " << pathToCSV << " with " << copyCount << " COPY commands." << std::endl;
+   return rowCount;
+}
+
+/**
+ * Inserts `rowCount` synthetic rows into `table`. Every batch is sent with its own inserter, and a batch is cut short
+ * as soon as hyperd's memory crosses the throttle. Returns the number of inserted rows.
+ */
+static int64_t insertWithinBudget(
+   hyperapi::Connection& connection, const hyperapi::TableDefinition& table, int64_t rowCount, samples::MemoryMonitor& monitor, MemoryGovernor& governor) {
+   const int64_t minRowsPerBatch = 10000, maxRowsPerBatch = 1000000;
+   int64_t rowsPerBatch = minRowsPerBatch;
+   int64_t insertedRows = 0;
+   int batchCount = 0;
+   monitor.takePeak();
+   while (insertedRows < rowCount) {
+      {
+         samples::PhaseTimer insertTimer(samples::Phase::Insert);
+         hyperapi::Inserter inserter(connection, table);
+         int64_t batchEnd = std::min(rowCount, insertedRows + rowsPerBatch);
+         for (int64_t i = insertedRows; i < batchEnd; ++i) {
+            inserter.addRow(
+               0.1 * static_cast<double>(i % 4), 1000000 + i, "ORD-" + std::to_string(i / 4), "PRD-" + std::to_string(i % 1800),
+               static_cast<double>(i % 97) - 20.0, static_cast<int16_t>(1 + i % 9), static_cast<double>(i % 1000) + 0.5);
+            ++insertedRows;
+            // Checking the memory is a relaxed atomic load, but there is no need to do it for every row.
+            if ((insertedRows % 4096 == 0) && governor.isAboveThrottle()) {
+               break;
+            }
+         }
+         insertTimer.stop();
+         samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+      }
+      ++batchCount;
+      rowsPerBatch = governor.adjustBatchSize(rowsPerBatch, minRowsPerBatch, maxRowsPerBatch, monitor.takePeak());
+   }
+   std::cout << "Inserted " << insertedRows << " rows with " << batchCount << " inserters." << std::endl;
+   return insertedRows;
+}
+
+/**
+ * Formats a number of bytes in MB
+ */
+static std::string formatMegabytes(uint64_t bytes) {
+   return std::to_string(bytes / (1024 * 1024)) + " MB";
+}
+
+static void runInsertDataWithMemoryBudget(uint64_t budgetMegabytes, int64_t insertedRows) {
+   std::cout << "EXAMPLE - Load data while keeping hyperd within a memory budget" << std::endl;
+   const std::string pathToDatabase = "data/memory_budget.hyper";
+   const uint64_t budgetBytes = budgetMegabytes * 1024 * 1024;
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      // Hyper's own memory limit makes queries that would exceed the budget fail instead of the process being killed
+      // by the operating system. The governor below keeps the loader from getting there in the first place.
+      std::unordered_map<std::string, std::string> processParameters = {{"memory_limit", std::to_string(budgetMegabytes) + "M"}};
+
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau, "example", processParameters);
+      startupTimer.stop();
+      samples::MemoryMonitor monitor(samples::findHyperdProcessId(), std::chrono::milliseconds(10));
+      MemoryGovernor governor(monitor, budgetBytes);
+      std::vector<std::pair<std::string, uint64_t>> peaks;
+
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(lineItemsTable); });
+         peaks.emplace_back("startup", monitor.takePeak());
+
+         int64_t expectedRows = copyWithinBudget(connection, lineItemsTable, "data/lineitems.csv", monitor, governor);
+         peaks.emplace_back("copy", monitor.takePeak());
+         expectedRows += insertWithinBudget(connection, lineItemsTable, insertedRows, monitor, governor);
+         peaks.emplace_back("insert", monitor.takePeak());
+
+         int64_t rowCount = samples::timePhase(
+            samples::Phase::Query, [&] { return connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + lineItemsTable.getTableName().toString()); });
+         peaks.emplace_back("query", monitor.takePeak());
+         std::cout << "The number of rows in table " << lineItemsTable.getTableName() << " is " << rowCount << "." << std::endl;
+         if (rowCount != expectedRows) {
+            throw std::runtime_error("The table does not contain all loaded rows.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+
+      if (samples::getResidentBytes(samples::findHyperdProcessId()) == 0) {
+         std::cout << "The memory of hyperd cannot be observed on this platform, so the loader was not throttled." << std::endl;
+      } else {
+         std::cout << "Memory budget " << formatMegabytes(budgetBytes) << ", throttled " << governor.getThrottleCount() << " times for "
+                   << governor.getWaitedSeconds() << " s." << std::endl;
+         for (const std::pair<std::string, uint64_t>& peak : peaks) {
+            std::cout << "Peak hyperd memory during " << peak.first << ": " << formatMegabytes(peak.second) << std::endl;
+         }
+      }
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the memory budget in MB and the number of inserted rows can be passed on the command line.
+   uint64_t budgetMegabytes = (arguments.size() > 0) ? std::strtoull(arguments[0].c_str(), nullptr, 10) : 1024;
+   int64_t insertedRows = (arguments.size() > 1) ? std::atoll(arguments[1].c_str()) : 2000000;
+   try {
+      runInsertDataWithMemoryBudget(budgetMegabytes, insertedRows);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
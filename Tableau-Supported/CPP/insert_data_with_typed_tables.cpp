@@ -0,0 +1,137 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example insert_data_with_typed_tables.cpp
+ *
+ * An example of how to declare tables as lists of C++ types, so that the rows inserted into them are type-checked at
+ * compile time.
+ */
+
+#include "instrumentation.hpp"
+#include "typed_table.hpp"
+
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <string>
+#include <tuple>
+
+/** The tables of "insert_data_into_multiple_tables.cpp", declared by their column types. */
+typedef samples::TypedTable<int16_t, std::string, hyperapi::Date, std::string, hyperapi::optional<hyperapi::Date>, hyperapi::optional<std::string>> OrdersTable;
+typedef samples::TypedTable<std::string, std::string, int64_t, std::string> CustomerTable;
+typedef samples::TypedTable<int64_t, std::string, std::string, double, int16_t, hyperapi::optional<double>, double> LineItemsTable;
+
+static const OrdersTable ordersTable{"Orders", {"Address ID", "Customer ID", "Order Date", "Order ID", "Ship Date", "Ship Mode"}};
+static const CustomerTable customerTable{"Customer", {"Customer ID", "Customer Name", "Loyalty Reward Points", "Segment"}};
+static const LineItemsTable lineItemsTable{"Line Items", {"Line Item ID", "Order ID", "Product ID", "Sales", "Quantity", "Discount", "Profit"}};
+
+/** A row struct of the "Line Items" table. `tie()` lets the typed inserter read its members without copying them. */
+struct LineItem {
+   int64_t lineItemId;
+   std::string orderId;
+   std::string productId;
+   double sales;
+   int16_t quantity;
+   hyperapi::optional<double> discount;
+   double profit;
+
+   auto tie() const -> decltype(std::tie(lineItemId, orderId, productId, sales, quantity, discount, profit)) {
+      return std::tie(lineItemId, orderId, productId, sales, quantity, discount, profit);
+   }
+};
+
+static void runInsertDataWithTypedTables() {
+   std::cout << "EXAMPLE - Insert data into tables declared as C++ types" << std::endl;
+   const std::string pathToDatabase = "data/superstore_typed.hyper";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "superstore_typed.hyper".
+      // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+
+         // The table definitions are generated from the column types.
+         samples::PhaseTimer ddlTimer(samples::Phase::DDL);
+         connection.getCatalog().createTable(ordersTable.getDefinition());
+         connection.getCatalog().createTable(customerTable.getDefinition());
+         connection.getCatalog().createTable(lineItemsTable.getDefinition());
+         ddlTimer.stop();
+
+         // Rows can be given as tuples made with `makeRow()`. Passing, e.g., `399` instead of `int16_t{399}` for
+         // "Address ID" or leaving out a column does not compile.
+         {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
+            samples::TypedInserter<OrdersTable> inserter(connection, ordersTable);
+            inserter.addRow(OrdersTable::makeRow(
+               int16_t{399}, "DK-13375", hyperapi::Date{2012, 9, 7}, "CA-2011-100006", hyperapi::Date{2012, 9, 13}, std::string("Standard Class")));
+            inserter.addRow(OrdersTable::makeRow(
+               int16_t{530}, "EB-13705", hyperapi::Date{2012, 7, 8}, "CA-2011-100090", hyperapi::optional<hyperapi::Date>(),
+               hyperapi::optional<std::string>()));
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+         }
+         {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
+            samples::TypedInserter<CustomerTable> inserter(connection, customerTable);
+            inserter.addRow(CustomerTable::makeRow("DK-13375", "Dennis Kane", int64_t{518}, "Consumer"));
+            inserter.addRow(CustomerTable::makeRow("EB-13705", "Ed Braxton", int64_t{815}, "Corporate"));
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+         }
+
+         // Or as structs with a `tie()` member.
+         {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
+            samples::TypedInserter<LineItemsTable> inserter(connection, lineItemsTable);
+            inserter.addRow(LineItem{2718, "CA-2011-100006", "TEC-PH-10002075", 377.97, 3, 0.0, 109.6113});
+            inserter.addRow(LineItem{2719, "CA-2011-100090", "TEC-PH-10002075", 377.97, 3, {}, 109.6113});
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+         }
+
+         // Read the line items back as typed rows.
+         {
+            samples::PhaseTimer queryTimer(samples::Phase::Query);
+            hyperapi::Result result = connection.executeQuery("SELECT * FROM " + lineItemsTable.getTableName().toString());
+            for (const hyperapi::Row& row : result) {
+               LineItemsTable::Row lineItem = lineItemsTable.readRow(row);
+               const hyperapi::optional<double>& discount = std::get<5>(lineItem);
+               std::cout << std::get<0>(lineItem) << " " << std::get<1>(lineItem) << " sales " << std::get<3>(lineItem) << " discount "
+                         << (discount.has_value() ? std::to_string(*discount) : "NULL") << std::endl;
+            }
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
+   try {
+      runInsertDataWithTypedTables();
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
@@ -15,6 +15,8 @@
  * An example of how to insert spatial data into a single-table Hyper file.
  */
 
+#include "instrumentation.hpp"
+
 #include <hyperapi/hyperapi.hpp>
 #include <iostream>
 #include <string>
@@ -34,16 +36,22 @@ static void runInsertSpatialDataToAHyperFile() {
    // Starts the Hyper Process with telemetry enabled to send data to Tableau.
    // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
    {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
       hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
       // Creates new Hyper file "spatial_data.hyper".
       // Replaces existing file with hyperapi::CreateMode::CreateAndReplace if it already exists.
       {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
          hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
          const hyperapi::Catalog& catalog = connection.getCatalog();
 
          // Create the schema and the table.
+         samples::PhaseTimer ddlTimer(samples::Phase::DDL);
          catalog.createSchema("Extract");
          catalog.createTable(extractTable);
+         ddlTimer.stop();
 
          // Hyper API's Inserter allows users to transform data during insertion.
          // To make use of data transformation during insertion, the inserter requires the following inputs
@@ -77,28 +85,35 @@ static void runInsertSpatialDataToAHyperFile() {
 
          // Insert spatial data into the "Extract"."Extract" table using CAST expression.
          {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
             hyperapi::Inserter inserter(connection, extractTable, columnMappings, inserterDefinition);
             inserter.addRow("Seattle", "point(-122.338083 47.647528)");
             inserter.addRow("Munich", "point(11.584329 48.139257)");
-            inserter.execute();
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
          }
 
          // Number of rows in the "Extract"."Extract" table.
          // `executeScalarQuery` is for executing a query that returns exactly one row with one column.
-         int64_t rowCount = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + extractTable.getTableName().toString());
+         int64_t rowCount = samples::timePhase(
+            samples::Phase::Query, [&] { return connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + extractTable.getTableName().toString()); });
          std::cout << "The number of rows in table " << extractTable.getTableName() << " is " << rowCount << "." << std::endl;
       }
       std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
    }
    std::cout << "The Hyper Process has been shut down." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
    try {
       runInsertSpatialDataToAHyperFile();
    } catch (const hyperapi::HyperException& e) {
       std::cout << e.toString() << std::endl;
       return 1;
    }
+   samples::reportMetrics(metricsFormat);
    return 0;
 }
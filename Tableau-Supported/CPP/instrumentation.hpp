@@ -0,0 +1,241 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file instrumentation.hpp
+ *
+ * Lightweight per-phase timers for the samples.
+ *
+ * Every sample records how long it spends starting Hyper, connecting, running DDL, inserting, executing commands,
+ * querying and shutting down. The durations are aggregated into histograms that can be printed at exit with
+ * `--metrics=text` or `--metrics=json`. Recording a duration costs two clock reads and a few relaxed atomic
+ * increments, so the timers can stay enabled in production loaders as long as they wrap whole operations (e.g., an
+ * entire insert loop) rather than single rows.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_INSTRUMENTATION_HPP
+#define TABLEAU_HYPER_SAMPLES_INSTRUMENTATION_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace samples {
+
+/** The phases the samples are timed in. */
+enum class Phase { Startup, Connect, DDL, Insert, Execute, Query, Shutdown };
+static const size_t phaseCount = 7;
+
+inline const char* getPhaseName(Phase phase) {
+   static const char* const names[phaseCount] = {"startup", "connect", "ddl", "insert", "execute", "query", "shutdown"};
+   return names[static_cast<size_t>(phase)];
+}
+
+/**
+ * A histogram of durations in nanoseconds with one bucket per power of two.
+ * Bucket `i` counts the durations in [2^(i-1), 2^i), bucket 0 counts durations of zero.
+ * All members can be updated concurrently from several threads.
+ */
+class Histogram {
+   public:
+   static const size_t bucketCount = 64;
+
+   Histogram() {
+      for (std::atomic<uint64_t>& bucket : buckets) {
+         bucket.store(0, std::memory_order_relaxed);
+      }
+   }
+
+   void record(uint64_t nanoseconds) {
+      buckets[getBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+      count.fetch_add(1, std::memory_order_relaxed);
+      sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+      uint64_t current = min.load(std::memory_order_relaxed);
+      while ((nanoseconds < current) && !min.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+      }
+      current = max.load(std::memory_order_relaxed);
+      while ((nanoseconds > current) && !max.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+      }
+   }
+
+   uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+   uint64_t getSum() const { return sum.load(std::memory_order_relaxed); }
+   uint64_t getMin() const { return getCount() ? min.load(std::memory_order_relaxed) : 0; }
+   uint64_t getMax() const { return max.load(std::memory_order_relaxed); }
+   uint64_t getBucketCount(size_t bucket) const { return buckets[bucket].load(std::memory_order_relaxed); }
+
+   /** The exclusive upper bound of the durations counted in `bucket`. */
+   static uint64_t getBucketUpperBound(size_t bucket) { return (bucket >= 63) ? std::numeric_limits<uint64_t>::max() : (uint64_t{1} << bucket); }
+
+   /** An upper bound of the `q`-quantile of the recorded durations, with 0 <= q <= 1. */
+   uint64_t getQuantile(double q) const {
+      uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(getCount()));
+      uint64_t seen = 0;
+      for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+         seen += getBucketCount(bucket);
+         if (seen > rank) {
+            return std::min(getBucketUpperBound(bucket), getMax());
+         }
+      }
+      return getMax();
+   }
+
+   static size_t getBucket(uint64_t value) {
+      if (value == 0) {
+         return 0;
+      }
+#if defined(__GNUC__) || defined(__clang__)
+      size_t bucket = static_cast<size_t>(64 - __builtin_clzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+      unsigned long index;
+      _BitScanReverse64(&index, value);
+      size_t bucket = static_cast<size_t>(index + 1);
+#else
+      size_t bucket = 0;
+      for (uint64_t remaining = value; remaining; remaining >>= 1) {
+         ++bucket;
+      }
+#endif
+      // Durations of 2^63 ns and more share the last bucket.
+      return (bucket < bucketCount) ? bucket : bucketCount - 1;
+   }
+
+   private:
+   std::array<std::atomic<uint64_t>, bucketCount> buckets;
+   std::atomic<uint64_t> count{0};
+   std::atomic<uint64_t> sum{0};
+   std::atomic<uint64_t> min{std::numeric_limits<uint64_t>::max()};
+   std::atomic<uint64_t> max{0};
+};
+
+/** The histograms of all phases of the process. */
+class PhaseMetrics {
+   public:
+   static PhaseMetrics& instance() {
+      static PhaseMetrics metrics;
+      return metrics;
+   }
+
+   Histogram& get(Phase phase) { return histograms[static_cast<size_t>(phase)]; }
+   const Histogram& get(Phase phase) const { return histograms[static_cast<size_t>(phase)]; }
+
+   private:
+   PhaseMetrics() = default;
+   std::array<Histogram, phaseCount> histograms;
+};
+
+/**
+ * Records the time from its construction until `stop()` is called or it is destroyed, whichever comes first.
+ */
+class PhaseTimer {
+   public:
+   explicit PhaseTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+   ~PhaseTimer() { stop(); }
+   PhaseTimer(const PhaseTimer&) = delete;
+   PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+   void stop() {
+      if (running) {
+         running = false;
+         auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+         PhaseMetrics::instance().get(phase).record(static_cast<uint64_t>(elapsed.count()));
+      }
+   }
+
+   private:
+   Phase phase;
+   std::chrono::steady_clock::time_point start;
+   bool running = true;
+};
+
+/**
+ * Calls `function` and records its duration for `phase`. Returns the result of `function`.
+ */
+template <class Function>
+auto timePhase(Phase phase, Function&& function) -> decltype(function()) {
+   PhaseTimer timer(phase);
+   return function();
+}
+
+/** How the metrics are reported at the end of a sample. */
+enum class MetricsFormat { None, Text, Json };
+
+/**
+ * Removes the `--metrics=text` or `--metrics=json` option from the command line arguments.
+ * Returns the remaining arguments without the program name.
+ */
+inline std::vector<std::string> parseMetricsOption(int argc, char* argv[], MetricsFormat& format) {
+   format = MetricsFormat::None;
+   std::vector<std::string> arguments;
+   for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--metrics=text") == 0) {
+         format = MetricsFormat::Text;
+      } else if (std::strcmp(argv[i], "--metrics=json") == 0) {
+         format = MetricsFormat::Json;
+      } else {
+         arguments.push_back(argv[i]);
+      }
+   }
+   return arguments;
+}
+
+/**
+ * Writes the recorded metrics. They are written to `std::cerr` by default, so they do not mix with the sample output.
+ */
+inline void reportMetrics(MetricsFormat format, std::ostream& out = std::cerr) {
+   const PhaseMetrics& metrics = PhaseMetrics::instance();
+   if (format == MetricsFormat::Text) {
+      out << "phase\tcount\ttotal_ms\tmin_us\tp50_us\tp99_us\tmax_us\n";
+      for (size_t i = 0; i < phaseCount; ++i) {
+         const Histogram& histogram = metrics.get(static_cast<Phase>(i));
+         if (histogram.getCount() == 0) {
+            continue;
+         }
+         out << getPhaseName(static_cast<Phase>(i)) << '\t' << histogram.getCount() << '\t' << static_cast<double>(histogram.getSum()) / 1e6 << '\t'
+             << static_cast<double>(histogram.getMin()) / 1e3 << '\t' << static_cast<double>(histogram.getQuantile(0.5)) / 1e3 << '\t'
+             << static_cast<double>(histogram.getQuantile(0.99)) / 1e3 << '\t' << static_cast<double>(histogram.getMax()) / 1e3 << '\n';
+      }
+   } else if (format == MetricsFormat::Json) {
+      out << "{\"phases\":{";
+      const char* separator = "";
+      for (size_t i = 0; i < phaseCount; ++i) {
+         const Histogram& histogram = metrics.get(static_cast<Phase>(i));
+         out << separator << '"' << getPhaseName(static_cast<Phase>(i)) << "\":{\"count\":" << histogram.getCount() << ",\"sum_ns\":" << histogram.getSum()
+             << ",\"min_ns\":" << histogram.getMin() << ",\"p50_ns\":" << histogram.getQuantile(0.5) << ",\"p99_ns\":" << histogram.getQuantile(0.99)
+             << ",\"max_ns\":" << histogram.getMax() << ",\"buckets\":[";
+         const char* bucketSeparator = "";
+         for (size_t bucket = 0; bucket < Histogram::bucketCount; ++bucket) {
+            if (histogram.getBucketCount(bucket)) {
+               out << bucketSeparator << "{\"lt_ns\":" << Histogram::getBucketUpperBound(bucket) << ",\"count\":" << histogram.getBucketCount(bucket) << '}';
+               bucketSeparator = ",";
+            }
+         }
+         out << "]}";
+         separator = ",";
+      }
+      out << "}}\n";
+   }
+   out.flush();
+}
+}
+
+#endif
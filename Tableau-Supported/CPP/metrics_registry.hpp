@@ -0,0 +1,443 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file metrics_registry.hpp
+ *
+ * A registry of counters, gauges and histograms for long-running loaders, exported in the Prometheus text format.
+ *
+ * The metrics can be written to a file, e.g., for the textfile collector of the Prometheus node exporter, or served
+ * on a local HTTP endpoint (POSIX only). Counters are sharded per thread, so loader threads incrementing the same
+ * counter never write to the same cache line.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_METRICS_REGISTRY_HPP
+#define TABLEAU_HYPER_SAMPLES_METRICS_REGISTRY_HPP
+
+#include "instrumentation.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace samples {
+
+/** The labels of a time series, e.g., `{{"table", "Orders"}}`. */
+typedef std::vector<std::pair<std::string, std::string>> MetricLabels;
+
+/**
+ * A monotonically increasing counter.
+ * Every thread increments its own shard, the shards are only summed up when the counter is exported.
+ */
+class Counter {
+   public:
+   static const size_t shardCount = 64;
+
+   Counter() {
+      for (Shard& shard : shards) {
+         shard.value.store(0, std::memory_order_relaxed);
+      }
+   }
+   Counter(const Counter&) = delete;
+   Counter& operator=(const Counter&) = delete;
+
+   void increment(uint64_t amount = 1) { shards[getThreadShard()].value.fetch_add(amount, std::memory_order_relaxed); }
+
+   uint64_t getValue() const {
+      uint64_t value = 0;
+      for (const Shard& shard : shards) {
+         value += shard.value.load(std::memory_order_relaxed);
+      }
+      return value;
+   }
+
+   private:
+   /// Padded to two cache lines. Counters are allocated with `new`, which does not align them to a cache line in
+   /// C++11, so with 64 bytes a shard would straddle two lines and share one with its neighbour. With 128 bytes, the
+   /// values of adjacent shards are always in different cache lines, wherever the counter starts.
+   struct Shard {
+      std::atomic<uint64_t> value;
+      char padding[128 - sizeof(std::atomic<uint64_t>)];
+   };
+
+   /** The shard of the calling thread. Threads are assigned round-robin the first time they increment a counter. */
+   static size_t getThreadShard() {
+      static std::atomic<size_t> nextShard{0};
+      static thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % shardCount;
+      return shard;
+   }
+
+   std::array<Shard, shardCount> shards;
+};
+
+/** A value that can go up and down, e.g., the number of open connections. */
+class Gauge {
+   public:
+   Gauge(const Gauge&) = delete;
+   Gauge& operator=(const Gauge&) = delete;
+   Gauge() = default;
+
+   void set(int64_t value) { this->value.store(value, std::memory_order_relaxed); }
+   void add(int64_t amount) { value.fetch_add(amount, std::memory_order_relaxed); }
+   int64_t getValue() const { return value.load(std::memory_order_relaxed); }
+
+   private:
+   std::atomic<int64_t> value{0};
+};
+
+/**
+ * The registry of all metrics of a process.
+ *
+ * Registering a metric takes a lock and returns a reference that stays valid as long as the registry, so metrics
+ * should be registered once at startup and then updated without going through the registry. Histograms record
+ * durations in nanoseconds and are exported in seconds.
+ */
+class MetricsRegistry {
+   public:
+   Counter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+      std::unique_ptr<Counter> counter(new Counter());
+      Counter& result = *counter;
+      addSeries(name, help, "counter", labels, Series{result, std::move(counter)});
+      return result;
+   }
+
+   Gauge& gauge(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+      std::unique_ptr<Gauge> gauge(new Gauge());
+      Gauge& result = *gauge;
+      addSeries(name, help, "gauge", labels, Series{result, std::move(gauge)});
+      return result;
+   }
+
+   Histogram& histogram(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+      std::unique_ptr<Histogram> histogram(new Histogram());
+      Histogram& result = *histogram;
+      addSeries(name, help, "histogram", labels, Series{result, std::move(histogram)});
+      return result;
+   }
+
+   /** Exports a histogram owned by someone else, e.g., a phase histogram of `PhaseMetrics`. */
+   void addHistogram(const std::string& name, const std::string& help, const MetricLabels& labels, const Histogram& histogram) {
+      addSeries(name, help, "histogram", labels, Series{histogram});
+   }
+
+   /** Writes all metrics in the Prometheus text exposition format. */
+   void write(std::ostream& out) const {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const std::pair<const std::string, Family>& entry : families) {
+         const std::string& name = entry.first;
+         const Family& family = entry.second;
+         out << "# HELP " << name << ' ' << family.help << '\n';
+         out << "# TYPE " << name << ' ' << family.type << '\n';
+         for (const Series& series : family.series) {
+            if (series.counter) {
+               out << name << formatLabels(series.labels) << ' ' << series.counter->getValue() << '\n';
+            } else if (series.gauge) {
+               out << name << formatLabels(series.labels) << ' ' << series.gauge->getValue() << '\n';
+            } else {
+               writeHistogram(out, name, series.labels, *series.histogram);
+            }
+         }
+      }
+   }
+
+   std::string toString() const {
+      std::ostringstream out;
+      write(out);
+      return out.str();
+   }
+
+   private:
+   struct Series {
+      explicit Series(Counter& counter, std::unique_ptr<Counter> owned) : counter(&counter), ownedCounter(std::move(owned)) {}
+      explicit Series(Gauge& gauge, std::unique_ptr<Gauge> owned) : gauge(&gauge), ownedGauge(std::move(owned)) {}
+      explicit Series(const Histogram& histogram, std::unique_ptr<Histogram> owned = nullptr) : histogram(&histogram), ownedHistogram(std::move(owned)) {}
+
+      MetricLabels labels;
+      const Counter* counter = nullptr;
+      const Gauge* gauge = nullptr;
+      const Histogram* histogram = nullptr;
+      std::unique_ptr<Counter> ownedCounter;
+      std::unique_ptr<Gauge> ownedGauge;
+      std::unique_ptr<Histogram> ownedHistogram;
+   };
+
+   struct Family {
+      std::string help;
+      std::string type;
+      std::vector<Series> series;
+   };
+
+   void addSeries(const std::string& name, const std::string& help, const std::string& type, const MetricLabels& labels, Series series) {
+      std::lock_guard<std::mutex> lock(mutex);
+      Family& family = families[name];
+      if (family.type.empty()) {
+         family.help = help;
+         family.type = type;
+      } else if (family.type != type) {
+         throw std::invalid_argument("The metric " + name + " is already registered as a " + family.type);
+      }
+      for (const Series& existing : family.series) {
+         if (existing.labels == labels) {
+            throw std::invalid_argument("The metric " + name + formatLabels(labels) + " is already registered");
+         }
+      }
+      series.labels = labels;
+      family.series.push_back(std::move(series));
+   }
+
+   static std::string formatLabels(const MetricLabels& labels, const std::string& extraLabel = "") {
+      if (labels.empty() && extraLabel.empty()) {
+         return "";
+      }
+      std::string result = "{";
+      for (const std::pair<std::string, std::string>& label : labels) {
+         result += label.first + "=\"";
+         for (char c : label.second) {
+            if (c == '\\' || c == '"') {
+               result += '\\';
+               result += c;
+            } else if (c == '\n') {
+               result += "\\n";
+            } else {
+               result += c;
+            }
+         }
+         result += "\",";
+      }
+      result += extraLabel;
+      if (result.back() == ',') {
+         result.pop_back();
+      }
+      return result + "}";
+   }
+
+   /**
+    * Writes the cumulative buckets from 1 microsecond to about 18 minutes. The bucket boundaries are fixed, so
+    * consecutive scrapes always report the same series.
+    */
+   static void writeHistogram(std::ostream& out, const std::string& name, const MetricLabels& labels, const Histogram& histogram) {
+      const size_t firstBucket = 10, lastBucket = 40;
+      uint64_t cumulative = 0;
+      for (size_t bucket = 0; bucket <= lastBucket; ++bucket) {
+         cumulative += histogram.getBucketCount(bucket);
+         if (bucket >= firstBucket) {
+            std::ostringstream bound;
+            bound << static_cast<double>(Histogram::getBucketUpperBound(bucket)) / 1e9;
+            out << name << "_bucket" << formatLabels(labels, "le=\"" + bound.str() + "\"") << ' ' << cumulative << '\n';
+         }
+      }
+      // Read the count once, so the +Inf bucket and the count always agree.
+      uint64_t count = histogram.getCount();
+      out << name << "_bucket" << formatLabels(labels, "le=\"+Inf\"") << ' ' << count << '\n';
+      out << name << "_sum" << formatLabels(labels) << ' ' << static_cast<double>(histogram.getSum()) / 1e9 << '\n';
+      out << name << "_count" << formatLabels(labels) << ' ' << count << '\n';
+   }
+
+   mutable std::mutex mutex;
+   std::map<std::string, Family> families;
+};
+
+/** Exports the phase histograms of the sample instrumentation as `hyper_sample_phase_duration_seconds`. */
+inline void addPhaseMetrics(MetricsRegistry& registry) {
+   for (size_t i = 0; i < phaseCount; ++i) {
+      Phase phase = static_cast<Phase>(i);
+      registry.addHistogram(
+         "hyper_sample_phase_duration_seconds", "Time spent in each phase of the loader.", {{"phase", getPhaseName(phase)}},
+         PhaseMetrics::instance().get(phase));
+   }
+}
+
+/**
+ * Writes the metrics to `path`. The metrics are written to a temporary file first, which then replaces `path`, so
+ * a collector never reads a partially written file.
+ */
+inline void writeMetricsFile(const MetricsRegistry& registry, const std::string& path) {
+   const std::string temporaryPath = path + ".tmp";
+   {
+      std::ofstream file(temporaryPath, std::ios::trunc);
+      registry.write(file);
+      if (!file.flush()) {
+         throw std::runtime_error("Could not write " + temporaryPath);
+      }
+   }
+#if defined(_WIN32)
+   std::remove(path.c_str());
+#endif
+   if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+      throw std::runtime_error("Could not replace " + path);
+   }
+}
+
+/** Writes the metrics to a file in a background thread every `interval` and once more when it is destroyed. */
+class MetricsFileWriter {
+   public:
+   MetricsFileWriter(const MetricsRegistry& registry, std::string path, std::chrono::milliseconds interval)
+      : registry(registry), path(std::move(path)), interval(interval), thread([this] { run(); }) {}
+   MetricsFileWriter(const MetricsFileWriter&) = delete;
+   MetricsFileWriter& operator=(const MetricsFileWriter&) = delete;
+
+   ~MetricsFileWriter() {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         stopped = true;
+      }
+      stoppedChanged.notify_one();
+      thread.join();
+   }
+
+   private:
+   void run() {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+         bool stop = stoppedChanged.wait_for(lock, interval, [this] { return stopped; });
+         try {
+            writeMetricsFile(registry, path);
+         } catch (const std::exception& e) {
+            // Exporting metrics must never bring down the loader.
+            std::cerr << e.what() << std::endl;
+         }
+         if (stop) {
+            return;
+         }
+      }
+   }
+
+   const MetricsRegistry& registry;
+   const std::string path;
+   const std::chrono::milliseconds interval;
+   std::mutex mutex;
+   std::condition_variable stoppedChanged;
+   bool stopped = false;
+   std::thread thread;
+};
+
+#if !defined(_WIN32)
+/**
+ * Serves the metrics on `http://127.0.0.1:<port>/metrics` from a background thread.
+ * Pass port 0 to let the operating system choose a free port, see `getPort()`.
+ */
+class MetricsHttpServer {
+   public:
+   MetricsHttpServer(const MetricsRegistry& registry, uint16_t port) : registry(registry) {
+      listener = ::socket(AF_INET, SOCK_STREAM, 0);
+      if (listener < 0) {
+         throw std::runtime_error("Could not create the metrics socket");
+      }
+      int reuse = 1;
+      ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+      sockaddr_in address{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.sin_port = htons(port);
+      socklen_t addressLength = sizeof(address);
+      if ((::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) || (::listen(listener, 16) != 0) ||
+          (::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0)) {
+         ::close(listener);
+         throw std::runtime_error("Could not listen on port " + std::to_string(port));
+      }
+      this->port = ntohs(address.sin_port);
+      thread = std::thread([this] { run(); });
+   }
+   MetricsHttpServer(const MetricsHttpServer&) = delete;
+   MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+
+   ~MetricsHttpServer() {
+      stopped.store(true);
+      thread.join();
+      ::close(listener);
+   }
+
+   uint16_t getPort() const { return port; }
+
+   private:
+   void run() {
+      while (!stopped.load()) {
+         // Wake up regularly to check whether the server has been stopped.
+         pollfd descriptor{listener, POLLIN, 0};
+         if (::poll(&descriptor, 1, 100) <= 0) {
+            continue;
+         }
+         int client = ::accept(listener, nullptr, nullptr);
+         if (client < 0) {
+            continue;
+         }
+         respond(client);
+         ::close(client);
+      }
+   }
+
+   /** Answers a single request and closes the connection. Requests are served one at a time. */
+   void respond(int client) {
+      std::string request;
+      char buffer[1024];
+      while (request.find("\r\n\r\n") == std::string::npos) {
+         pollfd descriptor{client, POLLIN, 0};
+         if (::poll(&descriptor, 1, 1000) <= 0) {
+            return;
+         }
+         ssize_t received = ::recv(client, buffer, sizeof(buffer), 0);
+         if (received <= 0) {
+            return;
+         }
+         request.append(buffer, static_cast<size_t>(received));
+         if (request.size() > 16 * 1024) {
+            return;
+         }
+      }
+
+      std::string status = "200 OK", body;
+      if ((request.compare(0, 13, "GET /metrics ") == 0) || (request.compare(0, 6, "GET / ") == 0)) {
+         body = registry.toString();
+      } else {
+         status = "404 Not Found";
+         body = "Not found\n";
+      }
+      std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) +
+                             "\r\nConnection: close\r\n\r\n" + body;
+      for (size_t sent = 0; sent < response.size();) {
+         ssize_t written = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+         if (written <= 0) {
+            return;
+         }
+         sent += static_cast<size_t>(written);
+      }
+   }
+
+   const MetricsRegistry& registry;
+   int listener = -1;
+   uint16_t port = 0;
+   std::atomic<bool> stopped{false};
+   std::thread thread;
+};
+#endif
+}
+
+#endif
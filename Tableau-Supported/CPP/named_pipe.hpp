@@ -0,0 +1,342 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file named_pipe.hpp
+ *
+ * Streams the output of a producer into COPY through a named pipe (FIFO), without a temporary file. POSIX only.
+ *
+ * Hyper reads the FIFO like a file while a relay thread moves the producer's output into it. Pipes have a fixed
+ * capacity, so a producer that is faster than Hyper blocks in `write()`, and Hyper waits for a producer that is
+ * slower: the backpressure reaches from Hyper back to the producer, and the data in flight is bounded by the pipe
+ * buffers. The relay measures how long it waited on either side, which tells whether the load was bound by Hyper or
+ * by the producer.
+ *
+ * The Hyper Process opens the FIFO itself, so it must run on the same machine. The path is resolved like the path of
+ * any other COPY source.
+ *
+ * The COPY helpers set SIGPIPE to be ignored for the whole process, so a write to a pipe whose reader has gone away
+ * fails with EPIPE instead of ending the program. The setting stays in place after they return. Commands started by
+ * `copyFromCommand()` get the default SIGPIPE handling back.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_NAMED_PIPE_HPP
+#define TABLEAU_HYPER_SAMPLES_NAMED_PIPE_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <hyperapi/hyperapi.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace samples {
+
+/** What happened during a COPY from a named pipe. */
+struct NamedPipeCopyStatistics {
+   /// The number of rows COPY inserted.
+   int64_t rowCount = 0;
+   /// The number of bytes the producer wrote.
+   int64_t byteCount = 0;
+   double seconds = 0;
+   /// How long the relay waited for the producer to write more data.
+   double producerWaitSeconds = 0;
+   /// How long the relay waited for Hyper to read more data, i.e., how long the producer was held back.
+   double hyperWaitSeconds = 0;
+   /// The exit code of a producer command, 0 for producers in this process.
+   int producerExitCode = 0;
+
+   /** Returns whether Hyper mostly waited for the producer, rather than the other way around. */
+   bool isProducerBound() const { return producerWaitSeconds > hyperWaitSeconds; }
+};
+
+/** A FIFO that exists as long as this object. */
+class NamedPipe {
+   public:
+   explicit NamedPipe(std::string path) : path(std::move(path)) {
+      // A FIFO left over from an earlier run that did not clean up is replaced, other files are not touched.
+      struct stat status;
+      if ((::stat(this->path.c_str(), &status) == 0) && S_ISFIFO(status.st_mode)) {
+         ::unlink(this->path.c_str());
+      }
+      if (::mkfifo(this->path.c_str(), 0600) != 0) {
+         throw std::runtime_error("Could not create the named pipe " + this->path + ": " + std::strerror(errno));
+      }
+   }
+   NamedPipe(const NamedPipe&) = delete;
+   NamedPipe& operator=(const NamedPipe&) = delete;
+   ~NamedPipe() { ::unlink(path.c_str()); }
+
+   const std::string& getPath() const { return path; }
+
+   private:
+   std::string path;
+};
+
+/**
+ * Writes `size` bytes of `data` to the file descriptor `output`, blocking while the pipe is full. Throws if the
+ * reader has gone away, e.g., because the COPY failed.
+ */
+inline void writeToPipe(int output, const char* data, size_t size) {
+   while (size > 0) {
+      ssize_t written = ::write(output, data, size);
+      if (written < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         throw std::runtime_error(std::string("Could not write to the pipe: ") + std::strerror(errno));
+      }
+      data += written;
+      size -= static_cast<size_t>(written);
+   }
+}
+
+namespace detail {
+/** Helper function returning the seconds elapsed since `start` */
+inline double getSecondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Helper function creating a pipe whose ends are not inherited by other processes */
+inline void createPipe(int (&ends)[2]) {
+   if (::pipe(ends) != 0) {
+      throw std::runtime_error(std::string("Could not create a pipe: ") + std::strerror(errno));
+   }
+   ::fcntl(ends[0], F_SETFD, FD_CLOEXEC);
+   ::fcntl(ends[1], F_SETFD, FD_CLOEXEC);
+}
+
+/**
+ * Moves everything the producer writes to `input` into the FIFO at `path`, on a separate thread.
+ */
+class NamedPipeRelay {
+   public:
+   NamedPipeRelay(int input, std::string path, NamedPipeCopyStatistics& statistics)
+       : input(input), path(std::move(path)), statistics(statistics), thread([this] { run(); }) {}
+   NamedPipeRelay(const NamedPipeRelay&) = delete;
+   NamedPipeRelay& operator=(const NamedPipeRelay&) = delete;
+   ~NamedPipeRelay() { finish(); }
+
+   /**
+    * Waits for the relay to finish. If the COPY failed before it opened the FIFO, the relay would wait forever for a
+    * reader, so `isCopyDone` stops it.
+    */
+   void finish() {
+      isCopyDone = true;
+      if (thread.joinable()) {
+         thread.join();
+      }
+      if (error) {
+         std::exception_ptr relayError = error;
+         error = nullptr;
+         std::rethrow_exception(relayError);
+      }
+   }
+
+   private:
+   void run() {
+      try {
+         // Opening a FIFO for writing blocks until a reader opens it, so it is opened without blocking until Hyper
+         // does. Then the writes block again, which is what holds the producer back.
+         int output = -1;
+         while ((output = ::open(path.c_str(), O_WRONLY | O_NONBLOCK)) < 0) {
+            if (errno != ENXIO) {
+               throw std::runtime_error("Could not open the named pipe " + path + ": " + std::strerror(errno));
+            }
+            if (isCopyDone) {
+               return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         }
+         ::fcntl(output, F_SETFL, ::fcntl(output, F_GETFL) & ~O_NONBLOCK);
+
+         std::vector<char> buffer(64 * 1024);
+         bool isReaderGone = false;
+         while (!isReaderGone) {
+            auto start = std::chrono::steady_clock::now();
+            ssize_t size = ::read(input, buffer.data(), buffer.size());
+            statistics.producerWaitSeconds += getSecondsSince(start);
+            if (size == 0) {
+               break;
+            }
+            if (size < 0) {
+               if (errno == EINTR) {
+                  continue;
+               }
+               ::close(output);
+               throw std::runtime_error(std::string("Could not read from the producer: ") + std::strerror(errno));
+            }
+            start = std::chrono::steady_clock::now();
+            try {
+               writeToPipe(output, buffer.data(), static_cast<size_t>(size));
+            } catch (const std::runtime_error&) {
+               // Hyper closed the FIFO, the COPY reports why.
+               isReaderGone = true;
+            }
+            statistics.hyperWaitSeconds += getSecondsSince(start);
+            statistics.byteCount += size;
+         }
+         // Closing the FIFO is the end of the input for COPY.
+         ::close(output);
+      } catch (...) {
+         error = std::current_exception();
+      }
+   }
+
+   int input;
+   std::string path;
+   NamedPipeCopyStatistics& statistics;
+   std::atomic<bool> isCopyDone{false};
+   std::exception_ptr error;
+   std::thread thread;
+};
+
+/**
+ * Runs `COPY <table> FROM <pipe> WITH (<options>)` while relaying what the producer writes to `input`. `stopProducer`
+ * is called if the COPY fails, so the relay does not keep waiting for a producer that has nothing to write yet.
+ */
+template <class StopProducer>
+NamedPipeCopyStatistics copyThroughNamedPipe(
+   hyperapi::Connection& connection, const hyperapi::TableName& table, const std::string& options, const std::string& pathToPipe, int input,
+   StopProducer&& stopProducer) {
+   // A write to a pipe without a reader raises SIGPIPE, which would end the program instead of failing the write.
+   std::signal(SIGPIPE, SIG_IGN);
+   NamedPipe pipe(pathToPipe);
+   NamedPipeCopyStatistics statistics;
+   auto start = std::chrono::steady_clock::now();
+   {
+      NamedPipeRelay relay(input, pipe.getPath(), statistics);
+      try {
+         statistics.rowCount = connection.executeCommand(
+            "COPY " + table.toString() + " from " + hyperapi::escapeStringLiteral(pipe.getPath()) + " with (" + options + ")");
+      } catch (...) {
+         stopProducer();
+         try {
+            relay.finish();
+         } catch (...) {
+            // The error of the COPY is the one that matters.
+         }
+         throw;
+      }
+      relay.finish();
+   }
+   statistics.seconds = getSecondsSince(start);
+   return statistics;
+}
+}
+
+/**
+ * Runs `command` with the shell and loads what it writes to its standard output into `table` with
+ * `COPY <table> FROM <pathToPipe> WITH (<options>)`. The standard error of the command is not redirected.
+ * Sets SIGPIPE to be ignored in this process. The command runs with the default SIGPIPE handling.
+ */
+inline NamedPipeCopyStatistics copyFromCommand(
+   hyperapi::Connection& connection, const hyperapi::TableName& table, const std::string& command, const std::string& options,
+   const std::string& pathToPipe) {
+   int ends[2];
+   detail::createPipe(ends);
+   posix_spawn_file_actions_t actions;
+   posix_spawn_file_actions_init(&actions);
+   posix_spawn_file_actions_adddup2(&actions, ends[1], STDOUT_FILENO);
+   // An ignored SIGPIPE is inherited by the command, which would then keep running after the COPY stopped reading.
+   posix_spawnattr_t attributes;
+   posix_spawnattr_init(&attributes);
+   sigset_t defaultSignals;
+   sigemptyset(&defaultSignals);
+   sigaddset(&defaultSignals, SIGPIPE);
+   posix_spawnattr_setsigdefault(&attributes, &defaultSignals);
+   posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF);
+   const char* arguments[] = {"sh", "-c", command.c_str(), nullptr};
+   pid_t producer;
+   int spawnError = ::posix_spawn(&producer, "/bin/sh", &actions, &attributes, const_cast<char* const*>(arguments), environ);
+   posix_spawnattr_destroy(&attributes);
+   posix_spawn_file_actions_destroy(&actions);
+   ::close(ends[1]);
+   if (spawnError != 0) {
+      ::close(ends[0]);
+      throw std::runtime_error("Could not run " + command + ": " + std::strerror(spawnError));
+   }
+
+   auto waitForProducer = [&] {
+      int status = 0;
+      while ((::waitpid(producer, &status, 0) < 0) && (errno == EINTR)) {
+      }
+      return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+   };
+   NamedPipeCopyStatistics statistics;
+   try {
+      statistics = detail::copyThroughNamedPipe(connection, table, options, pathToPipe, ends[0], [&] { ::kill(producer, SIGTERM); });
+   } catch (...) {
+      ::close(ends[0]);
+      waitForProducer();
+      throw;
+   }
+   ::close(ends[0]);
+   statistics.producerExitCode = waitForProducer();
+   return statistics;
+}
+
+/**
+ * Like `copyFromCommand()`, for a producer in this process. `produce(output)` is called on a separate thread and
+ * writes the data to the file descriptor `output`, e.g., with `writeToPipe()`, which blocks while Hyper is behind.
+ * Sets SIGPIPE to be ignored in this process, so a write after the COPY failed throws instead of ending the program.
+ */
+template <class Produce>
+NamedPipeCopyStatistics copyFromProducer(
+   hyperapi::Connection& connection, const hyperapi::TableName& table, Produce&& produce, const std::string& options, const std::string& pathToPipe) {
+   int ends[2];
+   detail::createPipe(ends);
+   std::exception_ptr producerError;
+   std::thread producer([&] {
+      try {
+         produce(ends[1]);
+      } catch (...) {
+         producerError = std::current_exception();
+      }
+      // Closing the pipe is the end of the data.
+      ::close(ends[1]);
+   });
+
+   NamedPipeCopyStatistics statistics;
+   try {
+      // If the COPY fails, closing the read end after the relay stopped makes the next write of the producer fail.
+      statistics = detail::copyThroughNamedPipe(connection, table, options, pathToPipe, ends[0], [] {});
+   } catch (...) {
+      ::close(ends[0]);
+      producer.join();
+      throw;
+   }
+   ::close(ends[0]);
+   producer.join();
+   if (producerError) {
+      std::rethrow_exception(producerError);
+   }
+   return statistics;
+}
+}
+
+#endif
@@ -0,0 +1,502 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file parquet_metadata.hpp
+ *
+ * A reader for the metadata of Parquet files that maps their schemas to `TableDefinition`s.
+ *
+ * The metadata is stored in the footer of a Parquet file, serialized with the Thrift compact protocol. Only the parts
+ * needed to create a table are decoded: the columns with their physical types and annotations, and the row groups.
+ * Reading the metadata does not need a Parquet library and only reads the footer, however large the file is.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_PARQUET_METADATA_HPP
+#define TABLEAU_HYPER_SAMPLES_PARQUET_METADATA_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <hyperapi/hyperapi.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace samples {
+
+/** The physical types of Parquet, with the values they have in the metadata. */
+enum class ParquetType { Boolean = 0, Int32 = 1, Int64 = 2, Int96 = 3, Float = 4, Double = 5, ByteArray = 6, FixedLenByteArray = 7 };
+
+/** What the values of a physical type mean. Parquet has two ways to say that, both are mapped to this. */
+enum class ParquetAnnotation { None, String, Enum, Json, Bson, Uuid, Decimal, Date, Time, Timestamp, Integer, Float16, Other };
+
+enum class ParquetTimeUnit { Millis, Micros, Nanos };
+
+/** A column of a Parquet file. */
+struct ParquetColumn {
+   std::string name;
+   ParquetType type = ParquetType::ByteArray;
+   ParquetAnnotation annotation = ParquetAnnotation::None;
+   bool isOptional = true;
+   /// For decimals.
+   int32_t precision = 0;
+   int32_t scale = 0;
+   /// For times and timestamps.
+   ParquetTimeUnit timeUnit = ParquetTimeUnit::Micros;
+   bool isAdjustedToUtc = false;
+   /// For integers.
+   int bitWidth = 0;
+   bool isSigned = true;
+};
+
+/** A row group of a Parquet file, the unit Parquet files are written and read in. */
+struct ParquetRowGroup {
+   int64_t rowCount = 0;
+   /// The size of the row group's data before compression.
+   int64_t byteSize = 0;
+};
+
+/** The result of `readParquetMetadata()`. */
+struct ParquetMetadata {
+   int64_t rowCount = 0;
+   std::vector<ParquetColumn> columns;
+   std::vector<ParquetRowGroup> rowGroups;
+   /// The application that wrote the file.
+   std::string createdBy;
+};
+
+namespace detail {
+/** Decodes values serialized with the Thrift compact protocol. */
+class ThriftCompactReader {
+   public:
+   enum Type : uint8_t { Stop = 0, True = 1, False = 2, Byte = 3, I16 = 4, I32 = 5, I64 = 6, Double = 7, Binary = 8, List = 9, Set = 10, Map = 11, Struct = 12 };
+
+   ThriftCompactReader(const char* data, size_t size) : data(reinterpret_cast<const uint8_t*>(data)), size(size) {}
+
+   /** Reads a single byte, which is stored as is. */
+   int8_t readByte() { return static_cast<int8_t>(readRawByte()); }
+
+   /** Reads an integer of 16 bits or more. Those are stored as zigzag-encoded varints. */
+   int64_t readInteger() {
+      uint64_t value = readVarint();
+      return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+   }
+
+   std::string readBinary() {
+      uint64_t length = readVarint();
+      if (length > size - position) {
+         throw truncated();
+      }
+      std::string value(reinterpret_cast<const char*>(data + position), static_cast<size_t>(length));
+      position += static_cast<size_t>(length);
+      return value;
+   }
+
+   /** Starts reading the fields of a struct. */
+   void beginStruct() { lastFieldIds.push_back(0); }
+
+   /**
+    * Reads the header of the next field of the current struct. Returns false at the end of the struct. The value of
+    * a bool field is stored in its type, as `True` or `False`.
+    */
+   bool readFieldHeader(int16_t& fieldId, uint8_t& type) {
+      uint8_t header = readRawByte();
+      if (header == Stop) {
+         lastFieldIds.pop_back();
+         return false;
+      }
+      type = header & 0x0F;
+      // The field id is stored as the difference to the previous one if that fits into the upper four bits.
+      fieldId = (header >> 4) ? static_cast<int16_t>(lastFieldIds.back() + (header >> 4)) : static_cast<int16_t>(readInteger());
+      lastFieldIds.back() = fieldId;
+      return true;
+   }
+
+   /** Reads the header of a list and returns its number of elements. */
+   uint64_t readListHeader(uint8_t& elementType) {
+      uint8_t header = readRawByte();
+      elementType = header & 0x0F;
+      return ((header >> 4) == 15) ? readVarint() : (header >> 4);
+   }
+
+   /** Skips a value of `type`. Within lists, sets, and maps, bools take a byte of their own. */
+   void skip(uint8_t type, bool isElement = false) {
+      switch (type) {
+         case True:
+         case False:
+            if (isElement) {
+               readByte();
+            }
+            break;
+         case Byte:
+            readByte();
+            break;
+         case I16:
+         case I32:
+         case I64:
+            readVarint();
+            break;
+         case Double:
+            for (int i = 0; i < 8; ++i) {
+               readByte();
+            }
+            break;
+         case Binary:
+            readBinary();
+            break;
+         case List:
+         case Set: {
+            uint8_t elementType;
+            for (uint64_t i = readListHeader(elementType); i > 0; --i) {
+               skip(elementType, true);
+            }
+            break;
+         }
+         case Map: {
+            uint64_t count = readVarint();
+            uint8_t types = (count > 0) ? readRawByte() : 0;
+            for (uint64_t i = 0; i < count; ++i) {
+               skip(types >> 4, true);
+               skip(types & 0x0F, true);
+            }
+            break;
+         }
+         case Struct: {
+            beginStruct();
+            int16_t fieldId;
+            uint8_t fieldType;
+            while (readFieldHeader(fieldId, fieldType)) {
+               skip(fieldType);
+            }
+            break;
+         }
+         default:
+            throw std::runtime_error("The Parquet metadata is corrupt");
+      }
+   }
+
+   private:
+   uint8_t readRawByte() {
+      if (position == size) {
+         throw truncated();
+      }
+      return data[position++];
+   }
+
+   uint64_t readVarint() {
+      uint64_t value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+         uint8_t byte = readRawByte();
+         value |= uint64_t{byte & 0x7Fu} << shift;
+         if (!(byte & 0x80)) {
+            return value;
+         }
+      }
+      throw std::runtime_error("The Parquet metadata is corrupt");
+   }
+
+   static std::runtime_error truncated() { return std::runtime_error("The Parquet metadata is truncated"); }
+
+   const uint8_t* data;
+   size_t size;
+   size_t position = 0;
+   std::vector<int16_t> lastFieldIds;
+};
+
+/** An element of the flattened schema tree of a Parquet file. */
+struct ParquetSchemaElement {
+   ParquetColumn column;
+   /// 0 for required, 1 for optional, 2 for repeated.
+   int repetition = 0;
+   int64_t childCount = 0;
+};
+
+/** Maps a converted type, the older way of annotating a column, to `annotation`. */
+inline void applyConvertedType(int64_t convertedType, ParquetColumn& column) {
+   static const ParquetAnnotation annotations[] = {
+      ParquetAnnotation::String,  ParquetAnnotation::Other,   ParquetAnnotation::Other,   ParquetAnnotation::Other,     ParquetAnnotation::Enum,
+      ParquetAnnotation::Decimal, ParquetAnnotation::Date,    ParquetAnnotation::Time,    ParquetAnnotation::Time,      ParquetAnnotation::Timestamp,
+      ParquetAnnotation::Timestamp, ParquetAnnotation::Integer, ParquetAnnotation::Integer, ParquetAnnotation::Integer, ParquetAnnotation::Integer,
+      ParquetAnnotation::Integer, ParquetAnnotation::Integer, ParquetAnnotation::Integer, ParquetAnnotation::Integer,   ParquetAnnotation::Json,
+      ParquetAnnotation::Bson,    ParquetAnnotation::Other};
+   if ((convertedType < 0) || (convertedType >= static_cast<int64_t>(sizeof(annotations) / sizeof(annotations[0])))) {
+      column.annotation = ParquetAnnotation::Other;
+      return;
+   }
+   column.annotation = annotations[convertedType];
+   // TIME_MILLIS, TIME_MICROS, TIMESTAMP_MILLIS, TIMESTAMP_MICROS
+   if ((convertedType >= 7) && (convertedType <= 10)) {
+      column.timeUnit = (convertedType % 2) ? ParquetTimeUnit::Millis : ParquetTimeUnit::Micros;
+      column.isAdjustedToUtc = true;
+   }
+   // UINT_8 to UINT_64, then INT_8 to INT_64
+   if ((convertedType >= 11) && (convertedType <= 18)) {
+      column.bitWidth = 8 << ((convertedType - 11) % 4);
+      column.isSigned = (convertedType >= 15);
+   }
+}
+
+/** Reads a LogicalType union, the newer way of annotating a column, into `column`. */
+inline void readLogicalType(ThriftCompactReader& reader, ParquetColumn& column) {
+   static const ParquetAnnotation annotations[] = {
+      ParquetAnnotation::Other,     ParquetAnnotation::String,  ParquetAnnotation::Other, ParquetAnnotation::Other, ParquetAnnotation::Enum,
+      ParquetAnnotation::Decimal,   ParquetAnnotation::Date,    ParquetAnnotation::Time,  ParquetAnnotation::Timestamp, ParquetAnnotation::Other,
+      ParquetAnnotation::Integer,   ParquetAnnotation::Other,   ParquetAnnotation::Json,  ParquetAnnotation::Bson,  ParquetAnnotation::Uuid,
+      ParquetAnnotation::Float16};
+   reader.beginStruct();
+   int16_t kind;
+   uint8_t kindType;
+   while (reader.readFieldHeader(kind, kindType)) {
+      column.annotation = ((kind > 0) && (kind < static_cast<int16_t>(sizeof(annotations) / sizeof(annotations[0])))) ? annotations[kind] : ParquetAnnotation::Other;
+      reader.beginStruct();
+      int16_t fieldId;
+      uint8_t type;
+      while (reader.readFieldHeader(fieldId, type)) {
+         if ((column.annotation == ParquetAnnotation::Decimal) && (fieldId <= 2) && (type == ThriftCompactReader::I32)) {
+            (fieldId == 1 ? column.scale : column.precision) = static_cast<int32_t>(reader.readInteger());
+         } else if (((column.annotation == ParquetAnnotation::Time) || (column.annotation == ParquetAnnotation::Timestamp)) && (fieldId == 1)) {
+            column.isAdjustedToUtc = (type == ThriftCompactReader::True);
+         } else if (((column.annotation == ParquetAnnotation::Time) || (column.annotation == ParquetAnnotation::Timestamp)) && (fieldId == 2)) {
+            // The unit is a union of empty structs.
+            reader.beginStruct();
+            int16_t unit;
+            uint8_t unitType;
+            while (reader.readFieldHeader(unit, unitType)) {
+               column.timeUnit = (unit == 1) ? ParquetTimeUnit::Millis : ((unit == 2) ? ParquetTimeUnit::Micros : ParquetTimeUnit::Nanos);
+               reader.skip(unitType);
+            }
+         } else if ((column.annotation == ParquetAnnotation::Integer) && (fieldId == 1) && (type == ThriftCompactReader::Byte)) {
+            column.bitWidth = reader.readByte();
+         } else if ((column.annotation == ParquetAnnotation::Integer) && (fieldId == 2)) {
+            column.isSigned = (type == ThriftCompactReader::True);
+         } else {
+            reader.skip(type);
+         }
+      }
+   }
+}
+
+/** Reads a SchemaElement struct. */
+inline ParquetSchemaElement readSchemaElement(ThriftCompactReader& reader) {
+   ParquetSchemaElement element;
+   ParquetColumn& column = element.column;
+   int64_t convertedType = -1;
+   bool hasLogicalType = false;
+   reader.beginStruct();
+   int16_t fieldId;
+   uint8_t type;
+   while (reader.readFieldHeader(fieldId, type)) {
+      switch (fieldId) {
+         case 1:
+            column.type = static_cast<ParquetType>(reader.readInteger());
+            break;
+         case 3:
+            element.repetition = static_cast<int>(reader.readInteger());
+            break;
+         case 4:
+            column.name = reader.readBinary();
+            break;
+         case 5:
+            element.childCount = reader.readInteger();
+            break;
+         case 6:
+            convertedType = reader.readInteger();
+            break;
+         case 7:
+            column.scale = static_cast<int32_t>(reader.readInteger());
+            break;
+         case 8:
+            column.precision = static_cast<int32_t>(reader.readInteger());
+            break;
+         case 10:
+            readLogicalType(reader, column);
+            hasLogicalType = true;
+            break;
+         default:
+            reader.skip(type);
+      }
+   }
+   // Writers set both for compatibility, the logical type is the more precise one.
+   if (!hasLogicalType && (convertedType >= 0)) {
+      applyConvertedType(convertedType, column);
+   }
+   column.isOptional = (element.repetition == 1);
+   return element;
+}
+
+/** Reads a RowGroup struct. */
+inline ParquetRowGroup readRowGroup(ThriftCompactReader& reader) {
+   ParquetRowGroup rowGroup;
+   reader.beginStruct();
+   int16_t fieldId;
+   uint8_t type;
+   while (reader.readFieldHeader(fieldId, type)) {
+      if (fieldId == 2) {
+         rowGroup.byteSize = reader.readInteger();
+      } else if (fieldId == 3) {
+         rowGroup.rowCount = reader.readInteger();
+      } else {
+         reader.skip(type);
+      }
+   }
+   return rowGroup;
+}
+}
+
+/**
+ * Reads the metadata of the Parquet file at `path`.
+ *
+ * Throws if the file is not a Parquet file, if its footer is encrypted, or if it has nested or repeated columns, as
+ * those cannot be mapped to the columns of a table.
+ */
+inline ParquetMetadata readParquetMetadata(const std::string& path) {
+   std::ifstream file(path, std::ios::binary | std::ios::ate);
+   if (!file) {
+      throw std::runtime_error("Could not open " + path);
+   }
+   // A Parquet file starts with "PAR1" and ends with the length of the metadata followed by "PAR1".
+   const int64_t fileSize = static_cast<int64_t>(file.tellg());
+   char head[4] = {}, tail[8] = {};
+   file.seekg(0);
+   file.read(head, sizeof(head));
+   file.seekg(fileSize - static_cast<int64_t>(sizeof(tail)));
+   file.read(tail, sizeof(tail));
+   if (!file || (fileSize < 12) || std::memcmp(head, "PAR1", 4)) {
+      throw std::runtime_error(path + " is not a Parquet file");
+   }
+   if (!std::memcmp(tail + 4, "PARE", 4)) {
+      throw std::runtime_error(path + " has an encrypted footer, which is not supported");
+   }
+   const uint32_t footerSize = static_cast<uint32_t>(static_cast<uint8_t>(tail[0])) | (static_cast<uint32_t>(static_cast<uint8_t>(tail[1])) << 8) |
+                               (static_cast<uint32_t>(static_cast<uint8_t>(tail[2])) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(tail[3])) << 24);
+   if (std::memcmp(tail + 4, "PAR1", 4) || (footerSize > fileSize - 12)) {
+      throw std::runtime_error(path + " is not a Parquet file");
+   }
+   std::vector<char> footer(footerSize);
+   file.seekg(fileSize - 8 - footerSize);
+   file.read(footer.data(), footerSize);
+   if (!file) {
+      throw std::runtime_error("Could not read " + path);
+   }
+
+   ParquetMetadata metadata;
+   std::vector<detail::ParquetSchemaElement> schema;
+   detail::ThriftCompactReader reader(footer.data(), footer.size());
+   reader.beginStruct();
+   int16_t fieldId;
+   uint8_t type;
+   while (reader.readFieldHeader(fieldId, type)) {
+      uint8_t elementType;
+      switch (fieldId) {
+         case 2:
+            for (uint64_t i = reader.readListHeader(elementType); i > 0; --i) {
+               schema.push_back(detail::readSchemaElement(reader));
+            }
+            break;
+         case 3:
+            metadata.rowCount = reader.readInteger();
+            break;
+         case 4:
+            for (uint64_t i = reader.readListHeader(elementType); i > 0; --i) {
+               metadata.rowGroups.push_back(detail::readRowGroup(reader));
+            }
+            break;
+         case 6:
+            metadata.createdBy = reader.readBinary();
+            break;
+         default:
+            reader.skip(type);
+      }
+   }
+
+   // The schema is a tree flattened in depth-first order. The first element is the root, and a flat schema has the
+   // columns as its direct children.
+   for (size_t i = 1; i < schema.size(); ++i) {
+      if ((schema[i].childCount > 0) || (schema[i].repetition == 2)) {
+         throw std::runtime_error(path + ": The column \"" + schema[i].column.name + "\" is nested or repeated, which cannot be mapped to a table column");
+      }
+      metadata.columns.push_back(schema[i].column);
+   }
+   return metadata;
+}
+
+/**
+ * Returns the SQL type the values of `column` are stored as in Hyper.
+ */
+inline hyperapi::SqlType getSqlType(const ParquetColumn& column) {
+   if (column.annotation == ParquetAnnotation::Decimal) {
+      return hyperapi::SqlType::numeric(static_cast<uint16_t>(column.precision), static_cast<uint16_t>(column.scale));
+   }
+   switch (column.type) {
+      case ParquetType::Boolean:
+         return hyperapi::SqlType::boolean();
+      case ParquetType::Int32:
+         if (column.annotation == ParquetAnnotation::Date) {
+            return hyperapi::SqlType::date();
+         }
+         if (column.annotation == ParquetAnnotation::Time) {
+            return hyperapi::SqlType::time();
+         }
+         // Hyper has no 8-bit integers, and unsigned integers need the next larger type.
+         if (column.annotation == ParquetAnnotation::Integer) {
+            if (column.bitWidth <= (column.isSigned ? 16 : 8)) {
+               return hyperapi::SqlType::smallInt();
+            }
+            if (!column.isSigned && (column.bitWidth == 32)) {
+               return hyperapi::SqlType::bigInt();
+            }
+         }
+         return hyperapi::SqlType::integer();
+      case ParquetType::Int64:
+         if (column.annotation == ParquetAnnotation::Timestamp) {
+            return column.isAdjustedToUtc ? hyperapi::SqlType::timestampTZ() : hyperapi::SqlType::timestamp();
+         }
+         if (column.annotation == ParquetAnnotation::Time) {
+            return hyperapi::SqlType::time();
+         }
+         if ((column.annotation == ParquetAnnotation::Integer) && !column.isSigned) {
+            return hyperapi::SqlType::numeric(20, 0);
+         }
+         return hyperapi::SqlType::bigInt();
+      case ParquetType::Int96:
+         // The legacy timestamp format of Impala and Spark.
+         return hyperapi::SqlType::timestamp();
+      case ParquetType::Float:
+      case ParquetType::Double:
+         return hyperapi::SqlType::doublePrecision();
+      case ParquetType::ByteArray:
+      case ParquetType::FixedLenByteArray:
+         if ((column.annotation == ParquetAnnotation::String) || (column.annotation == ParquetAnnotation::Enum) ||
+             (column.annotation == ParquetAnnotation::Json)) {
+            return hyperapi::SqlType::text();
+         }
+         if (column.annotation == ParquetAnnotation::Float16) {
+            return hyperapi::SqlType::doublePrecision();
+         }
+         return hyperapi::SqlType::bytes();
+   }
+   throw std::runtime_error("The column \"" + column.name + "\" has an unknown Parquet type");
+}
+
+/**
+ * Returns the definition of a table `tableName` with the columns of the Parquet file described by `metadata`.
+ */
+inline hyperapi::TableDefinition getTableDefinition(const ParquetMetadata& metadata, const hyperapi::TableName& tableName) {
+   hyperapi::TableDefinition table(tableName);
+   for (const ParquetColumn& column : metadata.columns) {
+      table.addColumn(hyperapi::TableDefinition::Column{
+         column.name, getSqlType(column), column.isOptional ? hyperapi::Nullability::Nullable : hyperapi::Nullability::NotNullable});
+   }
+   return table;
+}
+}
+
+#endif
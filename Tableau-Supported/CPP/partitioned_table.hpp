@@ -0,0 +1,285 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file partitioned_table.hpp
+ *
+ * A table that is stored as one table per day or month of a date or timestamp column, with a view over all of them.
+ *
+ * A refresh only creates the partitions of the new data, so its cost is proportional to the new data rather than to
+ * the whole table, and expired data is removed by dropping its partitions instead of deleting rows. Readers query the
+ * view, which has the name and the columns of the table.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_PARTITIONED_TABLE_HPP
+#define TABLEAU_HYPER_SAMPLES_PARTITIONED_TABLE_HPP
+
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <hyperapi/hyperapi.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** The range of the values of the partition column that are stored in one partition. */
+enum class PartitionGranularity { Day, Month };
+
+/** The partitions touched by `PartitionedTable::load()`. */
+struct PartitionLoadResult {
+   /// The keys of the partitions that were created.
+   std::vector<std::string> createdPartitions;
+   /// The keys of the partitions that already existed and were replaced.
+   std::vector<std::string> replacedPartitions;
+   /// The keys of the partitions that already existed and were kept as they are.
+   std::vector<std::string> skippedPartitions;
+   /// The number of rows inserted into the created and replaced partitions.
+   int64_t insertedRows = 0;
+   double seconds = 0;
+};
+
+namespace detail {
+/** Helper function formatting the key of the partition that contains `date` */
+inline std::string getPartitionKey(const hyperapi::Date& date, PartitionGranularity granularity) {
+   char key[16];
+   if (granularity == PartitionGranularity::Month) {
+      std::snprintf(key, sizeof(key), "%04d-%02d", static_cast<int>(date.getYear()), static_cast<int>(date.getMonth()));
+   } else {
+      std::snprintf(key, sizeof(key), "%04d-%02d-%02d", static_cast<int>(date.getYear()), static_cast<int>(date.getMonth()), static_cast<int>(date.getDay()));
+   }
+   return key;
+}
+
+/** Helper function returning whether `suffix` of a table name is the key of a partition, e.g., "2015-03" for months */
+inline bool isPartitionKey(const std::string& suffix, PartitionGranularity granularity) {
+   const std::string pattern = (granularity == PartitionGranularity::Month) ? "0000-00" : "0000-00-00";
+   if (suffix.size() != pattern.size()) {
+      return false;
+   }
+   for (size_t i = 0; i < suffix.size(); ++i) {
+      if ((pattern[i] == '0') ? ((suffix[i] < '0') || (suffix[i] > '9')) : (suffix[i] != pattern[i])) {
+         return false;
+      }
+   }
+   return true;
+}
+
+/**
+ * Helper function returning the first day after the partition with `key` as "YYYY-MM-DD" for monthly partitions.
+ * Daily partitions are compared by their key.
+ */
+inline std::string getFirstDayAfterMonth(const std::string& key) {
+   int year = std::stoi(key.substr(0, 4));
+   int month = std::stoi(key.substr(5, 2));
+   char day[16];
+   std::snprintf(day, sizeof(day), "%04d-%02d-01", (month == 12) ? year + 1 : year, (month == 12) ? 1 : month + 1);
+   return day;
+}
+}
+
+/**
+ * A table stored as one table per day or month of `partitionColumn`, named like the table followed by the key of the
+ * partition, e.g., "Orders 2015-03" for monthly partitions of "Orders". The view over all partitions has the name of
+ * the table.
+ *
+ * The partition column must be a NOT NULL column of type DATE or TIMESTAMP, since rows without a value belong to no
+ * partition.
+ */
+class PartitionedTable {
+   public:
+   PartitionedTable(hyperapi::TableDefinition definition, std::string partitionColumn, PartitionGranularity granularity)
+       : definition(std::move(definition)), partitionColumn(std::move(partitionColumn)), granularity(granularity) {
+      const hyperapi::TableDefinition::Column* column = this->definition.getColumnByName(this->partitionColumn);
+      if (!column) {
+         throw std::invalid_argument("The table " + this->definition.getTableName().toString() + " has no column " + this->partitionColumn);
+      }
+      if ((column->getNullability() != hyperapi::Nullability::NotNullable) ||
+          ((column->getType().getTag() != hyperapi::TypeTag::Date) && (column->getType().getTag() != hyperapi::TypeTag::Timestamp))) {
+         throw std::invalid_argument("The partition column " + this->partitionColumn + " must be a NOT NULL column of type DATE or TIMESTAMP.");
+      }
+   }
+
+   /** Returns the name of the view over all partitions. */
+   const hyperapi::TableName& getTableName() const { return definition.getTableName(); }
+
+   /** Returns the name of the table that stores the partition with `key`. */
+   hyperapi::TableName getPartitionTableName(const std::string& key) const {
+      return hyperapi::TableName(getSchemaName(), definition.getTableName().getName().getUnescaped() + " " + key);
+   }
+
+   /** Returns the keys of the existing partitions in ascending order. */
+   std::vector<std::string> getPartitions(hyperapi::Connection& connection) const {
+      const std::string prefix = definition.getTableName().getName().getUnescaped() + " ";
+      std::vector<std::string> keys;
+      for (const hyperapi::TableName& table : connection.getCatalog().getTableNames(getSchemaName())) {
+         const std::string& name = table.getName().getUnescaped();
+         if ((name.compare(0, prefix.size(), prefix) == 0) && detail::isPartitionKey(name.substr(prefix.size()), granularity)) {
+            keys.push_back(name.substr(prefix.size()));
+         }
+      }
+      std::sort(keys.begin(), keys.end());
+      return keys;
+   }
+
+   /**
+    * Loads the rows of `sourceQuery`, which must return the columns of the table, into their partitions. Partitions
+    * that do not exist yet are created. Existing partitions are replaced if `replaceExisting` is set and skipped
+    * otherwise, e.g., to reload the latest partition, which was still incomplete at the last refresh.
+    *
+    * The source query is evaluated once into a temporary table, from which the partitions are filled, so the cost of
+    * a load grows with the loaded rows and not with the number of partitions times the cost of the source query. All
+    * partitions and the view are changed within one transaction, so readers either see the old or the new data.
+    */
+   PartitionLoadResult load(hyperapi::Connection& connection, const std::string& sourceQuery, bool replaceExisting = false) const {
+      auto start = std::chrono::steady_clock::now();
+      PartitionLoadResult result;
+      const std::string unit = (granularity == PartitionGranularity::Month) ? "month" : "day";
+      const std::string staging = hyperapi::escapeName(definition.getTableName().getName().getUnescaped() + " Load");
+      std::vector<std::string> partitions = getPartitions(connection);
+      std::string columns;
+      for (const hyperapi::TableDefinition::Column& column : definition.getColumns()) {
+         columns += (columns.empty() ? "" : ", ") + column.getName().toString();
+      }
+
+      PhaseTimer executeTimer(Phase::Execute);
+      connection.executeCommand("BEGIN TRANSACTION");
+      try {
+         // Sorting by the partition column stores the rows of a partition together, so the filter of each partition
+         // reads few blocks of the temporary table.
+         connection.executeCommand(
+            "CREATE TEMPORARY TABLE " + staging + " AS SELECT " + columns + " FROM (" + sourceQuery + ") AS source ORDER BY " +
+            hyperapi::escapeName(partitionColumn));
+         std::vector<std::string> sourceKeys;
+         hyperapi::Result keys = connection.executeQuery(
+            "SELECT DISTINCT CAST(date_trunc('" + unit + "', " + hyperapi::escapeName(partitionColumn) + ") AS DATE) FROM " + staging + " ORDER BY 1");
+         for (const hyperapi::Row& row : keys) {
+            sourceKeys.push_back(detail::getPartitionKey(row.get<hyperapi::Date>(0), granularity));
+         }
+         keys.close();
+
+         connection.executeCommand("DROP VIEW IF EXISTS " + getTableName().toString());
+         for (const std::string& key : sourceKeys) {
+            const hyperapi::TableName partition = getPartitionTableName(key);
+            if (std::binary_search(partitions.begin(), partitions.end(), key)) {
+               if (!replaceExisting) {
+                  result.skippedPartitions.push_back(key);
+                  continue;
+               }
+               connection.executeCommand("DROP TABLE " + partition.toString());
+               result.replacedPartitions.push_back(key);
+            } else {
+               result.createdPartitions.push_back(key);
+            }
+            hyperapi::TableDefinition partitionTable = definition;
+            partitionTable.setTableName(partition);
+            connection.getCatalog().createTable(partitionTable);
+            result.insertedRows += connection.executeCommand(
+               "INSERT INTO " + partition.toString() + " (" + columns + ") SELECT " + columns + " FROM " + staging + " WHERE " + getPartitionFilter(key));
+         }
+         connection.executeCommand("DROP TABLE " + staging);
+         partitions.insert(partitions.end(), result.createdPartitions.begin(), result.createdPartitions.end());
+         std::sort(partitions.begin(), partitions.end());
+         createView(connection, partitions);
+         connection.executeCommand("COMMIT");
+      } catch (...) {
+         // A failing ROLLBACK must not hide the exception that aborted the transaction.
+         try {
+            connection.executeCommand("ROLLBACK");
+            connection.executeCommand("DROP TABLE IF EXISTS " + staging);
+         } catch (const hyperapi::HyperException&) {
+         }
+         throw;
+      }
+      executeTimer.stop();
+      result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return result;
+   }
+
+   /**
+    * Drops all partitions whose values are all before `cutoff`, within one transaction. Returns the keys of the dropped
+    * partitions.
+    */
+   std::vector<std::string> dropPartitionsBefore(hyperapi::Connection& connection, const hyperapi::Date& cutoff) const {
+      const std::string cutoffDay = detail::getPartitionKey(cutoff, PartitionGranularity::Day);
+      std::vector<std::string> kept, dropped;
+      for (const std::string& key : getPartitions(connection)) {
+         bool isExpired = (granularity == PartitionGranularity::Month) ? (detail::getFirstDayAfterMonth(key) <= cutoffDay) : (key < cutoffDay);
+         (isExpired ? dropped : kept).push_back(key);
+      }
+      if (dropped.empty()) {
+         return dropped;
+      }
+
+      PhaseTimer ddlTimer(Phase::DDL);
+      connection.executeCommand("BEGIN TRANSACTION");
+      try {
+         connection.executeCommand("DROP VIEW IF EXISTS " + getTableName().toString());
+         for (const std::string& key : dropped) {
+            connection.executeCommand("DROP TABLE " + getPartitionTableName(key).toString());
+         }
+         createView(connection, kept);
+         connection.executeCommand("COMMIT");
+      } catch (...) {
+         // A failing ROLLBACK must not hide the exception that aborted the transaction.
+         try {
+            connection.executeCommand("ROLLBACK");
+         } catch (const hyperapi::HyperException&) {
+         }
+         throw;
+      }
+      return dropped;
+   }
+
+   private:
+   /** Returns the schema of the table, "public" if its name is not qualified. */
+   hyperapi::SchemaName getSchemaName() const {
+      const hyperapi::optional<hyperapi::SchemaName>& schema = definition.getTableName().getSchemaName();
+      return schema ? *schema : hyperapi::SchemaName("public");
+   }
+
+   /** Returns the condition on the partition column that selects the rows of the partition with `key`. */
+   std::string getPartitionFilter(const std::string& key) const {
+      const std::string firstDay = (granularity == PartitionGranularity::Month) ? key + "-01" : key;
+      const std::string column = hyperapi::escapeName(partitionColumn);
+      return column + " >= DATE " + hyperapi::escapeStringLiteral(firstDay) + " AND " + column + " < DATE " + hyperapi::escapeStringLiteral(firstDay) +
+             " + INTERVAL " + hyperapi::escapeStringLiteral((granularity == PartitionGranularity::Month) ? "1 month" : "1 day");
+   }
+
+   /**
+    * Creates the view over `partitions`. Without partitions, the view returns no rows but still has the columns of the
+    * table, so readers do not fail.
+    */
+   void createView(hyperapi::Connection& connection, const std::vector<std::string>& partitions) const {
+      std::string query;
+      for (const std::string& key : partitions) {
+         query += (query.empty() ? "" : " UNION ALL ") + ("SELECT * FROM " + getPartitionTableName(key).toString());
+      }
+      if (query.empty()) {
+         for (const hyperapi::TableDefinition::Column& column : definition.getColumns()) {
+            query += (query.empty() ? "SELECT " : ", ") + ("CAST(NULL AS " + column.getType().toString() + ") AS " + column.getName().toString());
+         }
+         query += " WHERE false";
+      }
+      connection.executeCommand("CREATE VIEW " + getTableName().toString() + " AS " + query);
+   }
+
+   hyperapi::TableDefinition definition;
+   std::string partitionColumn;
+   PartitionGranularity granularity;
+};
+}
+
+#endif
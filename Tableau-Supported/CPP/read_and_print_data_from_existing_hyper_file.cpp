@@ -15,6 +15,8 @@
  * An example of how to read and print data from an existing Hyper file.
  */
 
+#include "instrumentation.hpp"
+
 #include <fstream>
 #include <hyperapi/hyperapi.hpp>
 #include <iostream>
@@ -46,14 +48,19 @@ static void runReadAndPrintDataFromExistingHyperFile() {
    // Starts the Hyper Process with telemetry enabled to send data to Tableau.
    // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
    {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
       hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
 
       // Connect to existing Hyper file "superstore_sample_denormalized_read.hyper".
       {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
          hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
          const hyperapi::Catalog& catalog = connection.getCatalog();
 
          // The table names in the "Extract" schema.
+         samples::PhaseTimer catalogTimer(samples::Phase::Query);
          std::unordered_set<hyperapi::TableName> tableNames = catalog.getTableNames("Extract");
          for (auto& tableName : tableNames) {
             hyperapi::TableDefinition tableDefinition = catalog.getTableDefinition(tableName);
@@ -64,11 +71,13 @@ static void runReadAndPrintDataFromExistingHyperFile() {
             }
             std::cout << std::endl;
          }
+         catalogTimer.stop();
 
          // Print all rows from the "Extract"."Extract" table.
          hyperapi::TableName extractTable("Extract", "Extract");
          std::cout << "These are all rows in the table " << extractTable.toString() << ":" << std::endl;
 
+         samples::PhaseTimer queryTimer(samples::Phase::Query);
          hyperapi::Result rowsInTable = connection.executeQuery("SELECT * FROM " + extractTable.toString());
          for (const hyperapi::Row& row : rowsInTable) {
             for (const hyperapi::Value& value : row) {
@@ -76,18 +85,23 @@ static void runReadAndPrintDataFromExistingHyperFile() {
             }
             std::cout << '\n';
          }
+         queryTimer.stop();
       }
       std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
    }
    std::cout << "The Hyper Process has been shut down." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
    try {
       runReadAndPrintDataFromExistingHyperFile();
    } catch (const hyperapi::HyperException& e) {
       std::cout << e.toString() << std::endl;
       return 1;
    }
+   samples::reportMetrics(metricsFormat);
    return 0;
 }
@@ -0,0 +1,133 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example refresh_partitioned_data_in_existing_hyper_file.cpp
+ *
+ * An example of how to store the orders as one table per month of their order date, so a refresh only loads the
+ * months of the new orders and expired months are dropped instead of deleted. Readers query a view over all months.
+ */
+
+#include "instrumentation.hpp"
+#include "partitioned_table.hpp"
+#include "superstore_normalized.hpp"
+
+#include <chrono>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Helper function printing what `load()` did with the partitions
+ */
+static void printLoadResult(const std::string& name, const samples::PartitionLoadResult& result) {
+   std::cout << name << ": created " << result.createdPartitions.size() << ", replaced " << result.replacedPartitions.size() << " and skipped "
+             << result.skippedPartitions.size() << " partitions, inserted " << result.insertedRows << " rows in " << result.seconds << " s." << std::endl;
+}
+
+static void runRefreshPartitionedDataInExistingHyperFile() {
+   std::cout << "EXAMPLE - Refresh the monthly partitions of a table and drop the expired ones" << std::endl;
+   const std::string pathToDatabase = "data/superstore_partitioned.hyper";
+
+   hyperapi::TableDefinition ordersByMonth = samples::ordersTable;
+   ordersByMonth.setTableName(hyperapi::TableName("Orders By Month"));
+   const samples::PartitionedTable partitionedOrders(ordersByMonth, "Order Date", samples::PartitionGranularity::Month);
+   const std::string orders = samples::ordersTable.getTableName().toString();
+   const std::string orderDate = hyperapi::escapeName("Order Date");
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "superstore_partitioned.hyper" with the orders up to 2014, one table per month.
+      // The "Orders" table stands in for the source system.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         samples::PartitionLoadResult result =
+            partitionedOrders.load(connection, "SELECT * FROM " + orders + " WHERE " + orderDate + " < DATE '2015-01-01'");
+         printLoadResult("Initial load", result);
+      }
+
+      // Connect to the existing Hyper file "superstore_partitioned.hyper" and refresh it.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
+
+         // The refresh loads the orders since December 2014. December existed already but might have been incomplete
+         // when it was loaded, so existing partitions are replaced. All other months are not touched.
+         samples::PartitionLoadResult result =
+            partitionedOrders.load(connection, "SELECT * FROM " + orders + " WHERE " + orderDate + " >= DATE '2014-12-01'", true);
+         printLoadResult("Refresh", result);
+         if ((result.replacedPartitions.size() != 1) || !result.skippedPartitions.empty()) {
+            throw std::runtime_error("The refresh was expected to replace only the partition of December 2014.");
+         }
+
+         // Only the last two years are kept. For comparison, the same rows are deleted from an unpartitioned copy.
+         const hyperapi::Date cutoff(2014, 1, 1);
+         const std::string unpartitioned = hyperapi::escapeName("Orders Unpartitioned");
+         samples::timePhase(samples::Phase::DDL, [&] { connection.executeCommand("CREATE TABLE " + unpartitioned + " AS SELECT * FROM " + orders); });
+         auto start = std::chrono::steady_clock::now();
+         int64_t deletedRows = samples::timePhase(samples::Phase::Execute, [&] {
+            return connection.executeCommand("DELETE FROM " + unpartitioned + " WHERE " + orderDate + " < DATE '2014-01-01'");
+         });
+         double deleteSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         start = std::chrono::steady_clock::now();
+         std::vector<std::string> dropped = partitionedOrders.dropPartitionsBefore(connection, cutoff);
+         double dropSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         std::cout << "Retention: dropped " << dropped.size() << " partitions in " << dropSeconds << " s, deleting the " << deletedRows
+                   << " rows from the unpartitioned table took " << deleteSeconds << " s." << std::endl;
+
+         // The view must return the same orders as the source since the cutoff.
+         int64_t differentRows = samples::timePhase(samples::Phase::Query, [&] {
+            return connection.executeScalarQuery<int64_t>(
+               "SELECT COUNT(*) FROM ((SELECT * FROM " + unpartitioned + " EXCEPT ALL SELECT * FROM " + partitionedOrders.getTableName().toString() +
+               ") UNION ALL (SELECT * FROM " + partitionedOrders.getTableName().toString() + " EXCEPT ALL SELECT * FROM " + unpartitioned +
+               ")) AS differences");
+         });
+         if (differentRows != 0) {
+            throw std::runtime_error("The view over the partitions does not return the orders since the cutoff.");
+         }
+         std::vector<std::string> partitions = partitionedOrders.getPartitions(connection);
+         std::cout << "The view " << partitionedOrders.getTableName() << " reads " << partitions.size() << " partitions from "
+                   << partitions.front() << " to " << partitions.back() << "." << std::endl;
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
+   try {
+      runRefreshPartitionedDataInExistingHyperFile();
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
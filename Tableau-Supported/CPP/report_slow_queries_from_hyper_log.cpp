@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example report_slow_queries_from_hyper_log.cpp
+ *
+ * An example of how to find the slowest statements of a load in the event log of hyperd.
+ */
+
+#include "hyper_log.hpp"
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Loads the superstore tables and runs a few reporting queries, so the event log has something to report on.
+ * The Hyper Process writes its event log into `logDirectory`.
+ */
+static void runWorkload(const std::string& logDirectory) {
+   const std::string pathToDatabase = "data/superstore_log_report.hyper";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      // Writes the event log to "hyperd.log" in `logDirectory` and keeps a single file, so the report only covers this run.
+      std::unordered_map<std::string, std::string> processParameters = {{"log_dir", logDirectory}, {"log_file_max_count", "1"}};
+
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau, "example", processParameters);
+      startupTimer.stop();
+
+      // Creates new Hyper file "superstore_log_report.hyper".
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(
+            hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, samples::superstoreConnectionParameters());
+         connectTimer.stop();
+         samples::loadSuperstoreTables(connection);
+
+         samples::PhaseTimer queryTimer(samples::Phase::Query);
+         const std::string orders = samples::ordersTable.getTableName().toString();
+         const std::string lineItems = samples::lineItemsTable.getTableName().toString();
+         const std::string products = samples::productTable.getTableName().toString();
+         connection.executeScalarQuery<double>(
+            "SELECT SUM(" + hyperapi::escapeName("Sales") + ") FROM " + lineItems + " JOIN " + orders + " USING (" + hyperapi::escapeName("Order ID") +
+            ")");
+         hyperapi::Result result = connection.executeQuery(
+            "SELECT " + hyperapi::escapeName("Category") + ", SUM(" + hyperapi::escapeName("Profit") + ") FROM " + lineItems + " JOIN " + products +
+            " USING (" + hyperapi::escapeName("Product ID") + ") GROUP BY 1 ORDER BY 2 DESC");
+         for (const hyperapi::Row& row : result) {
+            std::cout << row.get<std::string>(0) << ": " << row.get<double>(1) << std::endl;
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+/**
+ * Prints the `slowestCount` slowest statements of the given log files. Without log files, runs a workload first and
+ * reports on its log.
+ */
+static void runReportSlowQueriesFromHyperLog(std::vector<std::string> logFiles, size_t slowestCount) {
+   std::cout << "EXAMPLE - Report the slowest statements from the event log of hyperd" << std::endl;
+
+   if (logFiles.empty()) {
+      runWorkload("data");
+      logFiles.push_back("data/hyperd.log");
+   }
+
+   // The log files are streamed line by line, so they can be much larger than the available memory.
+   samples::QueryReport report(slowestCount);
+   for (const std::string& logFile : logFiles) {
+      report.addLogFile(logFile);
+   }
+   report.print(std::cout);
+   if (report.getQueryCount() == 0) {
+      throw std::runtime_error("No statements were found in the event log.");
+   }
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the log files to report on can be passed on the command line.
+   try {
+      runReportSlowQueriesFromHyperLog(arguments, 10);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
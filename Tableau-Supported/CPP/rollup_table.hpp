@@ -0,0 +1,268 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file rollup_table.hpp
+ *
+ * Pre-aggregated rollup tables for queries that repeatedly aggregate the same joins, e.g., the sales per day and
+ * category of a dashboard.
+ *
+ * A rollup table is built with one `CREATE TABLE ... AS SELECT ... GROUP BY`. When rows are appended to its source, it
+ * is refreshed incrementally: only the appended rows are aggregated, and their aggregates are merged into the groups
+ * of the rollup table. This requires measures that can be merged, which is why the rollup functions are limited to
+ * SUM, COUNT, MIN, and MAX; an average is the sum divided by the count.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_ROLLUP_TABLE_HPP
+#define TABLEAU_HYPER_SAMPLES_ROLLUP_TABLE_HPP
+
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <hyperapi/hyperapi.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** The aggregate functions of rollup measures. */
+enum class RollupFunction { Sum, Count, Min, Max };
+
+/** A column of a rollup table: a group-by expression or an aggregate over the source. */
+struct RollupColumn {
+   RollupColumn(std::string name, std::string expression, RollupFunction function = RollupFunction::Sum)
+       : name(std::move(name)), expression(std::move(expression)), function(function) {}
+
+   std::string name;
+   /// The SQL expression over the source, e.g., `p."Category"`, or `*` for `COUNT(*)`.
+   std::string expression;
+   /// The aggregate function of a measure. Ignored for group-by columns.
+   RollupFunction function;
+};
+
+/** A rollup table and the query it pre-aggregates. */
+struct RollupDefinition {
+   hyperapi::TableName tableName;
+   /// The FROM clause of the aggregated query, e.g., a join of a fact table with its dimension tables.
+   std::string source;
+   /// A positive integer expression over the source that increases with every appended row, e.g., the ID of the fact
+   /// table rows. Incremental refreshes aggregate the rows above the highest value seen by the previous build or refresh.
+   std::string watermark;
+   std::vector<RollupColumn> groupBy;
+   std::vector<RollupColumn> measures;
+};
+
+/** What a build or refresh of a rollup table did. */
+struct RollupRefreshResult {
+   hyperapi::TableName tableName{"Rollup"};
+   /// The number of aggregated source rows.
+   int64_t sourceRows = 0;
+   /// The number of groups that were created or changed.
+   int64_t changedGroups = 0;
+   /// The watermark up to which the source has been aggregated.
+   int64_t watermark = 0;
+   double seconds = 0;
+};
+
+namespace detail {
+/** Helper function returning the SQL of the aggregate `function` over `expression` */
+inline std::string getRollupAggregate(RollupFunction function, const std::string& expression) {
+   switch (function) {
+      case RollupFunction::Sum:
+         return "SUM(" + expression + ")";
+      case RollupFunction::Count:
+         return "COUNT(" + expression + ")";
+      case RollupFunction::Min:
+         return "MIN(" + expression + ")";
+      case RollupFunction::Max:
+         return "MAX(" + expression + ")";
+   }
+   return std::string();
+}
+
+/** Helper function returning the aggregate that merges partial aggregates of `function` in `column` */
+inline std::string getRollupMerge(RollupFunction function, const std::string& column) {
+   return getRollupAggregate((function == RollupFunction::Count) ? RollupFunction::Sum : function, column);
+}
+}
+
+/**
+ * Builds and refreshes rollup tables. The watermarks of the rollup tables are kept in the table "Rollup Watermarks",
+ * so refreshes can continue in later connections.
+ */
+class RollupBuilder {
+   public:
+   /** Adds a rollup table that is built and refreshed by this builder. */
+   void addRollup(RollupDefinition definition) { definitions.push_back(std::move(definition)); }
+
+   /**
+    * Returns the query that aggregates the source of `definition` directly, optionally restricted to the rows whose
+    * watermark satisfies `watermarkCondition`, e.g., `> 42`.
+    */
+   static std::string getAggregateQuery(const RollupDefinition& definition, const std::string& watermarkCondition = std::string()) {
+      std::string select, groupBy;
+      for (const RollupColumn& column : definition.groupBy) {
+         select += (select.empty() ? "" : ", ") + column.expression + " AS " + hyperapi::escapeName(column.name);
+         groupBy += (groupBy.empty() ? "" : ", ") + column.expression;
+      }
+      for (const RollupColumn& column : definition.measures) {
+         select += (select.empty() ? "" : ", ") + detail::getRollupAggregate(column.function, column.expression) + " AS " + hyperapi::escapeName(column.name);
+      }
+      return "SELECT " + select + " FROM " + definition.source + (watermarkCondition.empty() ? "" : " WHERE " + definition.watermark + " " + watermarkCondition) +
+             (groupBy.empty() ? "" : " GROUP BY " + groupBy);
+   }
+
+   /** Builds all rollup tables from scratch, replacing existing ones. */
+   std::vector<RollupRefreshResult> build(hyperapi::Connection& connection) const {
+      createWatermarkTable(connection);
+      std::vector<RollupRefreshResult> results;
+      for (const RollupDefinition& definition : definitions) {
+         auto start = std::chrono::steady_clock::now();
+         RollupRefreshResult result;
+         result.tableName = definition.tableName;
+         PhaseTimer executeTimer(Phase::Execute);
+         connection.executeCommand("BEGIN TRANSACTION");
+         try {
+            // The watermark is read first, so rows appended concurrently are left for the next refresh.
+            result.watermark = getMaximumWatermark(connection, definition, std::string());
+            result.sourceRows = countSourceRows(connection, definition, "<= " + std::to_string(result.watermark));
+            connection.executeCommand("DROP TABLE IF EXISTS " + definition.tableName.toString());
+            connection.executeCommand(
+               "CREATE TABLE " + definition.tableName.toString() + " AS " + getAggregateQuery(definition, "<= " + std::to_string(result.watermark)));
+            result.changedGroups = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + definition.tableName.toString());
+            setWatermark(connection, definition, result.watermark);
+            connection.executeCommand("COMMIT");
+         } catch (...) {
+            // A failing ROLLBACK must not hide the exception that aborted the transaction.
+            try {
+               connection.executeCommand("ROLLBACK");
+            } catch (const hyperapi::HyperException&) {
+            }
+            throw;
+         }
+         executeTimer.stop();
+         result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         results.push_back(result);
+      }
+      return results;
+   }
+
+   /**
+    * Aggregates the source rows appended since the last build or refresh and merges them into the rollup tables, each
+    * within one transaction. The groups without appended rows are not touched.
+    */
+   std::vector<RollupRefreshResult> refresh(hyperapi::Connection& connection) const {
+      std::vector<RollupRefreshResult> results;
+      for (const RollupDefinition& definition : definitions) {
+         auto start = std::chrono::steady_clock::now();
+         RollupRefreshResult result;
+         result.tableName = definition.tableName;
+         const std::string rollup = definition.tableName.toString();
+         const std::string delta = hyperapi::escapeName(definition.tableName.getName().getUnescaped() + " Delta");
+         const std::string merged = hyperapi::escapeName(definition.tableName.getName().getUnescaped() + " Merged");
+         PhaseTimer executeTimer(Phase::Execute);
+         connection.executeCommand("BEGIN TRANSACTION");
+         try {
+            const int64_t previousWatermark = getWatermark(connection, definition);
+            const std::string previous = "> " + std::to_string(previousWatermark);
+            result.watermark = std::max(previousWatermark, getMaximumWatermark(connection, definition, previous));
+            const std::string appended = previous + " AND " + definition.watermark + " <= " + std::to_string(result.watermark);
+            result.sourceRows = countSourceRows(connection, definition, appended);
+            if (result.sourceRows > 0) {
+               std::string groupBy, sameGroup, merge;
+               for (const RollupColumn& column : definition.groupBy) {
+                  const std::string name = hyperapi::escapeName(column.name);
+                  groupBy += (groupBy.empty() ? "" : ", ") + name;
+                  sameGroup += (sameGroup.empty() ? "" : " AND ") + ("d." + name + " IS NOT DISTINCT FROM " + rollup + "." + name);
+               }
+               for (const RollupColumn& column : definition.measures) {
+                  merge += ", " + detail::getRollupMerge(column.function, hyperapi::escapeName(column.name)) + " AS " + hyperapi::escapeName(column.name);
+               }
+               // The appended rows are aggregated into the delta, which is merged with the groups it changes. Those
+               // groups are then replaced by the merged ones, which leaves all other groups as they are.
+               connection.executeCommand("CREATE TEMPORARY TABLE " + delta + " AS " + getAggregateQuery(definition, appended));
+               const std::string changed = sameGroup.empty() ? "" : " WHERE EXISTS (SELECT 1 FROM " + delta + " d WHERE " + sameGroup + ")";
+               connection.executeCommand(
+                  "CREATE TEMPORARY TABLE " + merged + " AS SELECT " + (groupBy.empty() ? merge.substr(2) : groupBy + merge) + " FROM (SELECT * FROM " +
+                  rollup + changed + " UNION ALL SELECT * FROM " + delta + ") AS groups" + (groupBy.empty() ? "" : " GROUP BY " + groupBy));
+               connection.executeCommand("DELETE FROM " + rollup + changed);
+               result.changedGroups = connection.executeCommand("INSERT INTO " + rollup + " SELECT * FROM " + merged);
+               connection.executeCommand("DROP TABLE " + delta);
+               connection.executeCommand("DROP TABLE " + merged);
+               setWatermark(connection, definition, result.watermark);
+            }
+            connection.executeCommand("COMMIT");
+         } catch (...) {
+            // A failing ROLLBACK must not hide the exception that aborted the transaction. The temporary tables are
+            // dropped as well, so a later refresh on this connection can create them again.
+            try {
+               connection.executeCommand("ROLLBACK");
+               connection.executeCommand("DROP TABLE IF EXISTS " + delta);
+               connection.executeCommand("DROP TABLE IF EXISTS " + merged);
+            } catch (const hyperapi::HyperException&) {
+            }
+            throw;
+         }
+         executeTimer.stop();
+         result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         results.push_back(result);
+      }
+      return results;
+   }
+
+   private:
+   /** The table that keeps the watermark of every rollup table. */
+   static hyperapi::TableDefinition getWatermarkTable() {
+      return hyperapi::TableDefinition(
+         "Rollup Watermarks", {hyperapi::TableDefinition::Column{"Rollup", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                               hyperapi::TableDefinition::Column{"Watermark", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable}});
+   }
+
+   static void createWatermarkTable(hyperapi::Connection& connection) {
+      timePhase(Phase::DDL, [&] { connection.getCatalog().createTableIfNotExists(getWatermarkTable()); });
+   }
+
+   /** Returns the highest watermark of the source rows that satisfy `condition`, 0 if there are none. */
+   static int64_t getMaximumWatermark(hyperapi::Connection& connection, const RollupDefinition& definition, const std::string& condition) {
+      return connection.executeScalarQuery<int64_t>(
+         "SELECT COALESCE(MAX(" + definition.watermark + "), 0) FROM " + definition.source +
+         (condition.empty() ? "" : " WHERE " + definition.watermark + " " + condition));
+   }
+
+   static int64_t countSourceRows(hyperapi::Connection& connection, const RollupDefinition& definition, const std::string& condition) {
+      return connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + definition.source + " WHERE " + definition.watermark + " " + condition);
+   }
+
+   static int64_t getWatermark(hyperapi::Connection& connection, const RollupDefinition& definition) {
+      hyperapi::optional<int64_t> watermark = connection.executeScalarQuery<hyperapi::optional<int64_t>>(
+         "SELECT MAX(" + hyperapi::escapeName("Watermark") + ") FROM " + getWatermarkTable().getTableName().toString() + " WHERE " +
+         hyperapi::escapeName("Rollup") + " = " + hyperapi::escapeStringLiteral(definition.tableName.toString()));
+      if (!watermark) {
+         throw std::runtime_error("The rollup table " + definition.tableName.toString() + " has to be built before it can be refreshed.");
+      }
+      return *watermark;
+   }
+
+   static void setWatermark(hyperapi::Connection& connection, const RollupDefinition& definition, int64_t watermark) {
+      const std::string watermarks = getWatermarkTable().getTableName().toString();
+      const std::string rollup = hyperapi::escapeStringLiteral(definition.tableName.toString());
+      connection.executeCommand("DELETE FROM " + watermarks + " WHERE " + hyperapi::escapeName("Rollup") + " = " + rollup);
+      connection.executeCommand("INSERT INTO " + watermarks + " VALUES (" + rollup + ", " + std::to_string(watermark) + ")");
+   }
+
+   std::vector<RollupDefinition> definitions;
+};
+}
+
+#endif
@@ -0,0 +1,124 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file string_arena.hpp
+ *
+ * A bump allocator for text values that are only needed for one batch of rows.
+ *
+ * Copying a text value into the arena costs a bounds check and a `memcpy`, the memory is allocated in blocks and
+ * `reset()` makes all blocks available again without returning them to the heap. A loader that resets the arena per
+ * batch therefore stops allocating once the arena has grown to the size of its largest batch.
+ *
+ * Reads avoid the copy altogether: `readChunks()` hands out a result chunk by chunk, and `getTextView()` reads a text
+ * value as a view into the current chunk. Only values that have to outlive their chunk need to be stored in an arena.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_STRING_ARENA_HPP
+#define TABLEAU_HYPER_SAMPLES_STRING_ARENA_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <hyperapi/hyperapi.hpp>
+#include <memory>
+#include <vector>
+
+namespace samples {
+
+class StringArena {
+   public:
+   explicit StringArena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+   StringArena(const StringArena&) = delete;
+   StringArena& operator=(const StringArena&) = delete;
+   StringArena(StringArena&&) = default;
+   StringArena& operator=(StringArena&&) = default;
+
+   /** Copies `value` into the arena. The returned view stays valid until the next `reset()`. */
+   hyperapi::string_view store(hyperapi::string_view value) {
+      if (value.size() == 0) {
+         return hyperapi::string_view("", 0);
+      }
+      if ((currentBlock == blocks.size()) || (blocks[currentBlock].size - used < value.size())) {
+         nextBlock(value.size());
+      }
+      char* destination = blocks[currentBlock].data.get() + used;
+      std::memcpy(destination, value.data(), value.size());
+      used += value.size();
+      return hyperapi::string_view(destination, value.size());
+   }
+
+   /** Invalidates all stored values and keeps the blocks for reuse. */
+   void reset() {
+      currentBlock = 0;
+      used = 0;
+   }
+
+   /** The number of bytes allocated from the heap. */
+   size_t getCapacity() const {
+      size_t capacity = 0;
+      for (const Block& block : blocks) {
+         capacity += block.size;
+      }
+      return capacity;
+   }
+
+   private:
+   struct Block {
+      std::unique_ptr<char[]> data;
+      size_t size;
+   };
+
+   /** Moves on to the next block that can hold `size` bytes, allocating it if there is none. */
+   void nextBlock(size_t size) {
+      if (currentBlock < blocks.size()) {
+         ++currentBlock;
+      }
+      while ((currentBlock < blocks.size()) && (blocks[currentBlock].size < size)) {
+         ++currentBlock;
+      }
+      if (currentBlock == blocks.size()) {
+         // Values larger than a block get a block of their own.
+         size_t newSize = std::max(blockSize, size);
+         blocks.push_back(Block{std::unique_ptr<char[]>(new char[newSize]), newSize});
+      }
+      used = 0;
+   }
+
+   size_t blockSize;
+   std::vector<Block> blocks;
+   size_t currentBlock = 0;
+   size_t used = 0;
+};
+
+/**
+ * Returns a text value of `row` as a view into the result chunk, or an empty optional for NULL.
+ * The view is only valid until the result moves on to the next chunk.
+ */
+inline hyperapi::optional<hyperapi::string_view> getTextView(const hyperapi::Row& row, size_t column) {
+   return row.get<hyperapi::optional<hyperapi::string_view>>(column);
+}
+
+/**
+ * Calls `processChunk(chunk)` for every chunk of `result`. Returns the number of rows read.
+ */
+template <class Function>
+int64_t readChunks(hyperapi::Result& result, Function&& processChunk) {
+   int64_t rowCount = 0;
+   for (const hyperapi::Chunk& chunk : hyperapi::Chunks(result)) {
+      processChunk(chunk);
+      rowCount += static_cast<int64_t>(chunk.getRowCount());
+   }
+   return rowCount;
+}
+}
+
+#endif
@@ -0,0 +1,102 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file superstore_normalized.hpp
+ *
+ * Table definitions of the normalized superstore schema and a helper that loads the tables from the
+ * CSV files in `data/superstore_normalized`.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_SUPERSTORE_NORMALIZED_HPP
+#define TABLEAU_HYPER_SAMPLES_SUPERSTORE_NORMALIZED_HPP
+
+#include "instrumentation.hpp"
+
+#include <hyperapi/hyperapi.hpp>
+#include <string>
+#include <unordered_map>
+
+namespace samples {
+
+/** Table Definitions of the normalized superstore schema, see "insert_data_into_multiple_tables.cpp" */
+using Column = hyperapi::TableDefinition::Column;
+static const hyperapi::TableDefinition ordersTable{"Orders",
+                                                   {
+                                                      Column{"Address ID", hyperapi::SqlType::smallInt(), hyperapi::Nullability::NotNullable},
+                                                      Column{"Customer ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                      Column{"Order Date", hyperapi::SqlType::date(), hyperapi::Nullability::NotNullable},
+                                                      Column{"Order ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                      Column{"Ship Date", hyperapi::SqlType::date(), hyperapi::Nullability::Nullable},
+                                                      Column{"Ship Mode", hyperapi::SqlType::text(), hyperapi::Nullability::Nullable},
+                                                   }};
+static const hyperapi::TableDefinition customerTable{"Customer",
+                                                     {Column{"Customer ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                      Column{"Customer Name", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                      Column{"Loyalty Reward Points", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+                                                      Column{"Segment", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable}}};
+static const hyperapi::TableDefinition productTable{"Products",
+                                                    {
+                                                       Column{"Category", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Product ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Product Name", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                       Column{"Sub-Category", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                    }};
+static const hyperapi::TableDefinition lineItemsTable{"Line Items",
+                                                      {
+                                                         Column{"Line Item ID", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+                                                         Column{"Order ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                         Column{"Product ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+                                                         Column{"Sales", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable},
+                                                         Column{"Quantity", hyperapi::SqlType::smallInt(), hyperapi::Nullability::NotNullable},
+                                                         Column{"Discount", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::Nullable},
+                                                         Column{"Profit", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable},
+                                                      }};
+
+/**
+ * Connection parameters required by `loadSuperstoreTables()`.
+ * The order dates in the CSV files are written as month/day/year.
+ */
+inline std::unordered_map<std::string, std::string> superstoreConnectionParameters() {
+   return {{"date_style", "MDY"}};
+}
+
+/**
+ * Creates the four superstore tables and loads them with one COPY per table.
+ * The CSV files are expected in the `data` directory next to the working directory, which is where the CMake project
+ * copies them to.
+ */
+inline void loadSuperstoreTables(hyperapi::Connection& connection) {
+   const hyperapi::Catalog& catalog = connection.getCatalog();
+   PhaseTimer ddlTimer(Phase::DDL);
+   catalog.createTable(ordersTable);
+   catalog.createTable(customerTable);
+   catalog.createTable(productTable);
+   catalog.createTable(lineItemsTable);
+   ddlTimer.stop();
+
+   PhaseTimer copyTimer(Phase::Execute);
+   const std::string copyOptions = " with (format csv, delimiter ',', header)";
+   connection.executeCommand("COPY " + ordersTable.getTableName().toString() + " from " + hyperapi::escapeStringLiteral("data/orders.csv") + copyOptions);
+   connection.executeCommand(
+      "COPY " + customerTable.getTableName().toString() + " from " + hyperapi::escapeStringLiteral("data/customers.csv") + copyOptions);
+   connection.executeCommand(
+      "COPY " + productTable.getTableName().toString() + " from " + hyperapi::escapeStringLiteral("data/products.csv") + copyOptions);
+   // The columns of "lineitems.csv" are ordered alphabetically, so they are listed explicitly.
+   connection.executeCommand(
+      "COPY " + lineItemsTable.getTableName().toString() + " (" + hyperapi::escapeName("Discount") + ", " + hyperapi::escapeName("Line Item ID") + ", " +
+      hyperapi::escapeName("Order ID") + ", " + hyperapi::escapeName("Product ID") + ", " + hyperapi::escapeName("Profit") + ", " +
+      hyperapi::escapeName("Quantity") + ", " + hyperapi::escapeName("Sales") + ") from " + hyperapi::escapeStringLiteral("data/lineitems.csv") +
+      copyOptions);
+}
+}
+
+#endif
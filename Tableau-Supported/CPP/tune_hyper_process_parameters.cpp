@@ -0,0 +1,276 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example tune_hyper_process_parameters.cpp
+ *
+ * An example of how to pick process and connection parameters for your hardware by running a fixed workload under
+ * every combination of a grid of parameter values.
+ */
+
+#include "hyperd_memory.hpp"
+#include "instrumentation.hpp"
+
+#include <chrono>
+#include <hyperapi/hyperapi.hpp>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** The line items with the columns in the order of "lineitems.csv", so they can be copied without a column list. */
+static const hyperapi::TableDefinition lineItemsTable{
+   "Line Items",
+   {hyperapi::TableDefinition::Column{"Discount", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::Nullable},
+    hyperapi::TableDefinition::Column{"Line Item ID", hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Order ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Product ID", hyperapi::SqlType::text(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Profit", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Quantity", hyperapi::SqlType::smallInt(), hyperapi::Nullability::NotNullable},
+    hyperapi::TableDefinition::Column{"Sales", hyperapi::SqlType::doublePrecision(), hyperapi::Nullability::NotNullable}}};
+
+/** The values to try for one parameter. An empty value leaves the parameter at its default. */
+struct ParameterAxis {
+   bool isProcessParameter;
+   std::string name;
+   std::vector<std::string> values;
+};
+
+/** One point of the grid. */
+struct Configuration {
+   std::unordered_map<std::string, std::string> processParameters;
+   std::unordered_map<std::string, std::string> connectionParameters;
+   std::string description;
+};
+
+/** The sizes of the workload that is run for every configuration. */
+struct Workload {
+   int copyRepetitions;
+   int64_t insertedRows;
+   int scanRepetitions;
+};
+
+/** The throughput and the peak memory of hyperd of a workload under one configuration. */
+struct Measurement {
+   std::string workload;
+   double rowsPerSecond;
+   uint64_t peakResidentBytes;
+};
+
+static const char* const workloadNames[] = {"csv copy", "bulk insert", "aggregation scan"};
+
+/**
+ * Parses a grid axis written as `process:<name>=<value>,<value>,...` or `connection:<name>=<value>,<value>,...`.
+ * An empty value, e.g., in `process:memory_limit=,4g`, stands for the default.
+ */
+static ParameterAxis parseAxis(const std::string& text) {
+   size_t colon = text.find(':'), equals = text.find('=');
+   if ((colon == std::string::npos) || (equals == std::string::npos) || (equals < colon)) {
+      throw std::invalid_argument("Invalid parameter axis: " + text);
+   }
+   std::string scope = text.substr(0, colon);
+   if ((scope != "process") && (scope != "connection")) {
+      throw std::invalid_argument("The scope of a parameter axis must be 'process' or 'connection': " + text);
+   }
+   ParameterAxis axis{scope == "process", text.substr(colon + 1, equals - colon - 1), {}};
+   for (size_t begin = equals + 1;;) {
+      size_t end = text.find(',', begin);
+      axis.values.push_back(text.substr(begin, end - begin));
+      if (end == std::string::npos) {
+         break;
+      }
+      begin = end + 1;
+   }
+   return axis;
+}
+
+/**
+ * Returns the cartesian product of all axes
+ */
+static std::vector<Configuration> expandGrid(const std::vector<ParameterAxis>& axes) {
+   std::vector<Configuration> configurations(1);
+   for (const ParameterAxis& axis : axes) {
+      std::vector<Configuration> expanded;
+      for (const Configuration& configuration : configurations) {
+         for (const std::string& value : axis.values) {
+            Configuration next = configuration;
+            if (!value.empty()) {
+               (axis.isProcessParameter ? next.processParameters : next.connectionParameters)[axis.name] = value;
+            }
+            next.description += (next.description.empty() ? "" : " ") + axis.name + "=" + (value.empty() ? "default" : value);
+            expanded.push_back(next);
+         }
+      }
+      configurations.swap(expanded);
+   }
+   return configurations;
+}
+
+/**
+ * Helper function returning the seconds elapsed since `start`
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Runs the workload in a new Hyper process started with the parameters of `configuration`.
+ * Every workload reports the peak resident memory hyperd reached while it ran.
+ */
+static std::vector<Measurement> runWorkload(const Configuration& configuration, const Workload& workload) {
+   const std::string pathToDatabase = "data/tuning.hyper";
+   std::vector<Measurement> measurements;
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau, "example", configuration.processParameters);
+      startupTimer.stop();
+      samples::MemoryMonitor memory(samples::findHyperdProcessId(), std::chrono::milliseconds(10));
+
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace, configuration.connectionParameters);
+         connectTimer.stop();
+         samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(lineItemsTable); });
+         memory.takePeak();
+
+         // CSV COPY: Load "lineitems.csv" repeatedly.
+         auto start = std::chrono::steady_clock::now();
+         int64_t copiedRows = 0;
+         {
+            samples::PhaseTimer executeTimer(samples::Phase::Execute);
+            for (int i = 0; i < workload.copyRepetitions; ++i) {
+               copiedRows += connection.executeCommand(
+                  "COPY " + lineItemsTable.getTableName().toString() + " from " + hyperapi::escapeStringLiteral("data/lineitems.csv") +
+                  " with (format csv, delimiter ',', header)");
+            }
+         }
+         measurements.push_back({workloadNames[0], static_cast<double>(copiedRows) / secondsSince(start), memory.takePeak()});
+
+         // Bulk insert: Stream synthetic line items with an inserter.
+         start = std::chrono::steady_clock::now();
+         {
+            samples::PhaseTimer insertTimer(samples::Phase::Insert);
+            hyperapi::Inserter inserter(connection, lineItemsTable);
+            for (int64_t i = 0; i < workload.insertedRows; ++i) {
+               inserter.addRow(
+                  0.1 * static_cast<double>(i % 4), 100000 + i, "ORD-" + std::to_string(i / 4), "PRD-" + std::to_string(i % 1800),
+                  static_cast<double>(i % 97) - 20.0, static_cast<int16_t>(1 + i % 9), static_cast<double>(i % 1000) + 0.5);
+            }
+            insertTimer.stop();
+            samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+         }
+         measurements.push_back({workloadNames[1], static_cast<double>(workload.insertedRows) / secondsSince(start), memory.takePeak()});
+
+         // Aggregation scan: Group all rows by product.
+         const int64_t rowCount = copiedRows + workload.insertedRows;
+         start = std::chrono::steady_clock::now();
+         {
+            samples::PhaseTimer queryTimer(samples::Phase::Query);
+            for (int i = 0; i < workload.scanRepetitions; ++i) {
+               hyperapi::Result result = connection.executeQuery(
+                  "SELECT " + hyperapi::escapeName("Product ID") + ", SUM(" + hyperapi::escapeName("Sales") + "), AVG(" + hyperapi::escapeName("Discount") +
+                  "), COUNT(*) FROM " + lineItemsTable.getTableName().toString() + " GROUP BY 1");
+               for (const hyperapi::Row& row : result) {
+                  (void)row;
+               }
+            }
+         }
+         measurements.push_back(
+            {workloadNames[2], static_cast<double>(rowCount * workload.scanRepetitions) / secondsSince(start), memory.takePeak()});
+      }
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   return measurements;
+}
+
+/**
+ * Formats a number of bytes in MB, or "n/a" where hyperd's memory cannot be observed
+ */
+static std::string formatMegabytes(uint64_t bytes) {
+   return bytes ? std::to_string(bytes / (1024 * 1024)) + " MB" : "n/a";
+}
+
+static void runTuneHyperProcessParameters(std::vector<ParameterAxis> axes, const Workload& workload) {
+   std::cout << "EXAMPLE - Tune the parameters of the Hyper Process for a workload" << std::endl;
+
+   if (axes.empty()) {
+      // Process and connection settings are documented in the Tableau Hyper documentation, chapters "Process Settings"
+      // and "Connection Settings". An empty value keeps the default.
+      axes = {{true, "memory_limit", {"", "25%"}}, {true, "default_database_version", {"", "2"}}};
+   }
+   std::vector<Configuration> configurations = expandGrid(axes);
+
+   // Run every configuration. A configuration hyperd rejects is reported and skipped.
+   std::vector<std::vector<Measurement>> results(configurations.size());
+   for (size_t i = 0; i < configurations.size(); ++i) {
+      std::cout << "Configuration " << (i + 1) << "/" << configurations.size() << ": " << configurations[i].description << std::endl;
+      try {
+         results[i] = runWorkload(configurations[i], workload);
+      } catch (const hyperapi::HyperException& e) {
+         std::cout << "   failed: " << e.getMainMessage() << std::endl;
+         continue;
+      }
+      for (const Measurement& measurement : results[i]) {
+         std::cout << "   " << std::left << std::setw(18) << measurement.workload << std::right << std::setw(14) << static_cast<int64_t>(measurement.rowsPerSecond)
+                   << " rows/s, peak hyperd memory " << formatMegabytes(measurement.peakResidentBytes) << std::endl;
+      }
+   }
+
+   // Pick the configuration with the highest throughput for every workload.
+   std::cout << std::endl << "Best settings per workload:" << std::endl;
+   bool anySucceeded = false;
+   for (size_t workloadIndex = 0; workloadIndex < 3; ++workloadIndex) {
+      size_t best = configurations.size();
+      for (size_t i = 0; i < configurations.size(); ++i) {
+         if (!results[i].empty() && ((best == configurations.size()) || (results[i][workloadIndex].rowsPerSecond > results[best][workloadIndex].rowsPerSecond))) {
+            best = i;
+         }
+      }
+      if (best == configurations.size()) {
+         continue;
+      }
+      anySucceeded = true;
+      const Measurement& measurement = results[best][workloadIndex];
+      std::cout << "   " << std::left << std::setw(18) << measurement.workload << std::right << configurations[best].description << " ("
+                << static_cast<int64_t>(measurement.rowsPerSecond) << " rows/s, peak hyperd memory " << formatMegabytes(measurement.peakResidentBytes) << ")"
+                << std::endl;
+   }
+   if (!anySucceeded) {
+      throw std::runtime_error("No configuration could be run.");
+   }
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the grid can be passed on the command line, one axis per argument, e.g.,
+   // `process:memory_limit=,4g,8g connection:lc_time=en_US`.
+   try {
+      std::vector<ParameterAxis> axes;
+      for (const std::string& argument : arguments) {
+         axes.push_back(parseAxis(argument));
+      }
+      runTuneHyperProcessParameters(axes, Workload{10, 200000, 5});
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}
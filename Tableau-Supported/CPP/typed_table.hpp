@@ -0,0 +1,226 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file typed_table.hpp
+ *
+ * Tables whose columns are declared as a list of C++ types.
+ *
+ * A `TypedTable<Types...>` generates its `TableDefinition` from the column types, so the definition and the rows
+ * inserted into it cannot diverge. A `TypedInserter` only accepts rows of exactly the column types. Rows made with
+ * `TypedTable::makeRow()` also check the type of every value, which moves the type errors the `Inserter` reports at
+ * runtime, e.g., an `int` passed for a SMALLINT column, to compile time. The `Row` constructor does not check them,
+ * since `std::tuple` converts its values implicitly. Nullable columns are declared as `hyperapi::optional<T>`.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_TYPED_TABLE_HPP
+#define TABLEAU_HYPER_SAMPLES_TYPED_TABLE_HPP
+
+#include <cstdint>
+#include <hyperapi/hyperapi.hpp>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** The SQL type of a C++ column type. Specialize it to support further types. */
+template <class T>
+struct ColumnTraits {
+   static_assert(sizeof(T) == 0, "There is no SQL type for this C++ type");
+};
+
+template <>
+struct ColumnTraits<bool> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::boolean(); }
+};
+template <>
+struct ColumnTraits<int16_t> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::smallInt(); }
+};
+template <>
+struct ColumnTraits<int32_t> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::integer(); }
+};
+template <>
+struct ColumnTraits<int64_t> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::bigInt(); }
+};
+template <>
+struct ColumnTraits<double> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::doublePrecision(); }
+};
+template <>
+struct ColumnTraits<std::string> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::text(); }
+};
+template <>
+struct ColumnTraits<hyperapi::Date> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::date(); }
+};
+template <>
+struct ColumnTraits<hyperapi::Timestamp> {
+   static hyperapi::SqlType getType() { return hyperapi::SqlType::timestamp(); }
+};
+
+/** Whether a C++ column type is nullable, i.e., a `hyperapi::optional`. */
+template <class T>
+struct IsNullableColumn : std::false_type {
+   typedef T ValueType;
+};
+template <class T>
+struct IsNullableColumn<hyperapi::optional<T>> : std::true_type {
+   typedef T ValueType;
+};
+
+namespace detail {
+/** `std::index_sequence` is C++14, so the samples bring their own. */
+template <size_t... Indexes>
+struct IndexSequence {};
+template <size_t Count, size_t... Indexes>
+struct MakeIndexSequence : MakeIndexSequence<Count - 1, Count - 1, Indexes...> {};
+template <size_t... Indexes>
+struct MakeIndexSequence<0, Indexes...> {
+   typedef IndexSequence<Indexes...> Type;
+};
+
+/** `std::conjunction` is C++17, so the samples bring their own. */
+template <bool... Values>
+struct AllOf : std::true_type {};
+template <bool First, bool... Rest>
+struct AllOf<First, Rest...> : std::integral_constant<bool, First && AllOf<Rest...>::value> {};
+
+/**
+ * Whether a value of type `Value` can be stored in a column of type `Column` without changing its type. String
+ * literals are accepted for text columns, and plain values or `hyperapi::optional`s for nullable columns.
+ */
+template <class Column, class Value>
+struct IsColumnValue : std::is_same<Column, Value> {};
+template <class Value>
+struct IsColumnValue<std::string, Value>
+   : std::integral_constant<
+        bool, std::is_same<Value, std::string>::value || std::is_same<Value, const char*>::value || std::is_same<Value, char*>::value> {};
+template <class T, class Value>
+struct IsColumnValue<hyperapi::optional<T>, Value>
+   : std::integral_constant<bool, std::is_same<Value, hyperapi::optional<T>>::value || std::is_same<Value, T>::value> {};
+}
+
+/**
+ * A table with the column types `Types`.
+ *
+ * The column names are passed as an array, so a table with more names than types does not compile. Missing names are
+ * reported when the table is constructed.
+ *
+ *     static const samples::TypedTable<std::string, int64_t> customers{"Customer", {"Customer ID", "Loyalty Reward Points"}};
+ */
+template <class... Types>
+class TypedTable {
+   public:
+   /** A row of the table. */
+   typedef std::tuple<Types...> Row;
+   static const size_t columnCount = sizeof...(Types);
+
+   TypedTable(hyperapi::TableName name, const char* const (&columnNames)[sizeof...(Types)], hyperapi::Persistence persistence = hyperapi::Persistence::Permanent)
+      : definition(std::move(name), makeColumns(columnNames, typename detail::MakeIndexSequence<sizeof...(Types)>::Type()), persistence) {}
+
+   /**
+    * Makes a row from one value per column. Unlike the `Row` constructor, which silently converts, e.g., `399` to
+    * `int16_t`, it does not compile if a value does not have the type of its column.
+    */
+   template <class... Values>
+   static Row makeRow(Values&&... values) {
+      static_assert(sizeof...(Values) == sizeof...(Types), "A row needs one value per column");
+      static_assert(
+         detail::AllOf<detail::IsColumnValue<Types, typename std::decay<Values>::type>::value...>::value,
+         "The types of the values do not match the column types of the table");
+      return Row(std::forward<Values>(values)...);
+   }
+
+   const hyperapi::TableDefinition& getDefinition() const { return definition; }
+   const hyperapi::TableName& getTableName() const { return definition.getTableName(); }
+
+   /** Converts a row of a query result with the columns of this table, in order, into a typed row. */
+   Row readRow(const hyperapi::Row& row) const { return readRow(row, typename detail::MakeIndexSequence<sizeof...(Types)>::Type()); }
+
+   private:
+   template <size_t... Indexes>
+   static std::vector<hyperapi::TableDefinition::Column> makeColumns(const char* const (&columnNames)[sizeof...(Types)], detail::IndexSequence<Indexes...>) {
+      for (const char* columnName : columnNames) {
+         if (!columnName) {
+            throw std::invalid_argument("A typed table needs one column name per column type");
+         }
+      }
+      return {hyperapi::TableDefinition::Column{
+         columnNames[Indexes], ColumnTraits<typename IsNullableColumn<Types>::ValueType>::getType(),
+         IsNullableColumn<Types>::value ? hyperapi::Nullability::Nullable : hyperapi::Nullability::NotNullable}...};
+   }
+
+   template <size_t... Indexes>
+   static Row readRow(const hyperapi::Row& row, detail::IndexSequence<Indexes...>) {
+      return Row(row.get<Types>(Indexes)...);
+   }
+
+   hyperapi::TableDefinition definition;
+};
+
+/**
+ * An inserter that only accepts the rows of a `TypedTable`, i.e., tuples of exactly its column types. The values of
+ * a `Table::Row` have already been converted to the column types when the row was constructed, so use
+ * `Table::makeRow()` to check the types of the values themselves.
+ *
+ * Besides `Table::Row`, it accepts any tuple of references to the column types, so row structs can be inserted without
+ * copying their members by giving them a `tie()` member:
+ *
+ *     struct Customer {
+ *        std::string id;
+ *        int64_t points;
+ *        auto tie() const -> decltype(std::tie(id, points)) { return std::tie(id, points); }
+ *     };
+ */
+template <class Table>
+class TypedInserter {
+   public:
+   TypedInserter(hyperapi::Connection& connection, const Table& table) : inserter(connection, table.getDefinition()) {}
+
+   /** Adds a row given as a tuple of the column types or of references to them. */
+   template <class... Values>
+   void addRow(const std::tuple<Values...>& row) {
+      static_assert(
+         std::is_same<std::tuple<typename std::decay<Values>::type...>, typename Table::Row>::value,
+         "The types of the row do not match the column types of the table");
+      addValues(row, typename detail::MakeIndexSequence<sizeof...(Values)>::Type());
+      inserter.endRow();
+   }
+
+   /** Adds a row struct with a `tie()` member. */
+   template <class Struct>
+   auto addRow(const Struct& row) -> decltype(row.tie(), void()) {
+      addRow(row.tie());
+   }
+
+   void execute() { inserter.execute(); }
+
+   private:
+   template <class Tuple, size_t... Indexes>
+   void addValues(const Tuple& row, detail::IndexSequence<Indexes...>) {
+      // Adds the values in column order, the array only exists to expand the parameter pack.
+      int expand[] = {0, (inserter.add(std::get<Indexes>(row)), 0)...};
+      (void)expand;
+   }
+
+   hyperapi::Inserter inserter;
+};
+}
+
+#endif
@@ -9,6 +9,8 @@
 //
 // -----------------------------------------------------------------------------
 
+#include "instrumentation.hpp"
+
 #include <fstream>
 #include <hyperapi/hyperapi.hpp>
 #include <iostream>
@@ -45,12 +47,17 @@ static void runUpdateDataInExistingHyperFile() {
    // Starts the Hyper Process with telemetry enabled to send data to Tableau.
    // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
    {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
       hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
 
       // Connect to existing Hyper file "superstore_sample_update.hyper".
       {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
          hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
 
+         samples::PhaseTimer queryTimer(samples::Phase::Query);
          hyperapi::Result rowsPreUpdate = connection.executeQuery(
             "SELECT " + hyperapi::escapeName("Loyalty Reward Points") + ", " + hyperapi::escapeName("Segment") + " FROM " + hyperapi::escapeName("Customer"));
          std::cout << "Pre-Update: Individual rows showing 'Loyalty Reward Points' and 'Segment' columns: " << std::endl;
@@ -60,16 +67,20 @@ static void runUpdateDataInExistingHyperFile() {
             }
             std::cout << '\n';
          }
+         queryTimer.stop();
          std::cout << std::endl;
 
          std::cout << "Update 'Customers' table by adding 50 Loyalty Reward Points to all Corporate Customers." << std::endl;
-         int64_t rowCount = connection.executeCommand(
-            "UPDATE " + hyperapi::escapeName("Customer") + " SET " + hyperapi::escapeName("Loyalty Reward Points") + " = " +
-            hyperapi::escapeName("Loyalty Reward Points") + " + 50 " + "WHERE " + hyperapi::escapeName("Segment") + " = " +
-            hyperapi::escapeStringLiteral("Corporate"));
+         int64_t rowCount = samples::timePhase(samples::Phase::Execute, [&] {
+            return connection.executeCommand(
+               "UPDATE " + hyperapi::escapeName("Customer") + " SET " + hyperapi::escapeName("Loyalty Reward Points") + " = " +
+               hyperapi::escapeName("Loyalty Reward Points") + " + 50 " + "WHERE " + hyperapi::escapeName("Segment") + " = " +
+               hyperapi::escapeStringLiteral("Corporate"));
+         });
 
          std::cout << "The number of updated rows in table " << hyperapi::escapeName("Customer") << " is " << rowCount << "." << std::endl;
 
+         samples::PhaseTimer postUpdateQueryTimer(samples::Phase::Query);
          hyperapi::Result rowsPostUpdate = connection.executeQuery(
             "SELECT " + hyperapi::escapeName("Loyalty Reward Points") + ", " + hyperapi::escapeName("Segment") + " FROM " + hyperapi::escapeName("Customer"));
          for (const hyperapi::Row& row : rowsPostUpdate) {
@@ -78,18 +89,23 @@ static void runUpdateDataInExistingHyperFile() {
             }
             std::cout << '\n';
          }
+         postUpdateQueryTimer.stop();
       }
       std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
    }
    std::cout << "The Hyper Process has been shut down." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   samples::parseMetricsOption(argc, argv, metricsFormat);
    try {
       runUpdateDataInExistingHyperFile();
    } catch (const hyperapi::HyperException& e) {
       std::cout << e.toString() << std::endl;
       return 1;
    }
+   samples::reportMetrics(metricsFormat);
    return 0;
 }
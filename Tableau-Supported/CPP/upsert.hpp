@@ -0,0 +1,191 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \file upsert.hpp
+ *
+ * A MERGE-style helper that replaces the rows of a table whose keys appear in a stream of incoming rows and inserts
+ * all other incoming rows.
+ */
+
+#ifndef TABLEAU_HYPER_SAMPLES_UPSERT_HPP
+#define TABLEAU_HYPER_SAMPLES_UPSERT_HPP
+
+#include "instrumentation.hpp"
+
+#include <chrono>
+#include <functional>
+#include <hyperapi/hyperapi.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples {
+
+/** Row counts and timings of the phases of an `upsert()` call. */
+struct UpsertResult {
+   /// The number of incoming rows.
+   int64_t stagedRows = 0;
+   /// The number of rows that were replaced by an incoming row.
+   int64_t deletedRows = 0;
+   /// The number of rows that were inserted, i.e., the replaced rows plus the new rows.
+   int64_t insertedRows = 0;
+   /// Seconds spent streaming the incoming rows into the staging table.
+   double stageSeconds = 0;
+   /// Seconds spent deleting the rows that are replaced.
+   double deleteSeconds = 0;
+   /// Seconds spent inserting the staged rows into the target table.
+   double insertSeconds = 0;
+   /// Seconds spent committing the transaction.
+   double commitSeconds = 0;
+};
+
+/**
+ * Adds the incoming rows of an `upsert()` call to its staging table. Every row is numbered in the order it is added,
+ * so the last of several incoming rows with the same key wins.
+ */
+class UpsertInserter {
+   public:
+   explicit UpsertInserter(hyperapi::Inserter& inserter) : inserter(inserter) {}
+
+   /** Adds a row with a value for every column of the target table. */
+   template <typename... ValueTypes>
+   UpsertInserter& addRow(const ValueTypes&... values) {
+      inserter.addRow(values..., ++rowNumber);
+      return *this;
+   }
+
+   /** Adds the value of the next column of the current row. */
+   template <typename ValueType>
+   UpsertInserter& add(ValueType value) {
+      inserter.add(std::move(value));
+      return *this;
+   }
+
+   /** Ends the current row. */
+   UpsertInserter& endRow() {
+      inserter.add(++rowNumber);
+      inserter.endRow();
+      return *this;
+   }
+
+   private:
+   hyperapi::Inserter& inserter;
+   int64_t rowNumber = 0;
+};
+
+namespace detail {
+/** Drops the staging table of an `upsert()` call when it goes out of scope, also if staging failed. */
+class StagingTableDropper {
+   public:
+   StagingTableDropper(hyperapi::Connection& connection, std::string staging) : connection(connection), staging(std::move(staging)) {}
+   StagingTableDropper(const StagingTableDropper&) = delete;
+   StagingTableDropper& operator=(const StagingTableDropper&) = delete;
+
+   ~StagingTableDropper() {
+      try {
+         connection.executeCommand("DROP TABLE IF EXISTS " + staging);
+      } catch (const hyperapi::HyperException&) {
+         // The temporary table is dropped with the connection at the latest.
+      }
+   }
+
+   private:
+   hyperapi::Connection& connection;
+   std::string staging;
+};
+}
+
+/**
+ * Upserts a stream of rows into `targetTable`.
+ *
+ * `produceRows` is called once with an `UpsertInserter` on a temporary staging table with the same columns as the
+ * target table and adds the incoming rows to it. The rows are streamed to Hyper as they are added, so the client never
+ * holds more than the inserter's buffer, regardless of the size of the delta.
+ *
+ * All rows of the target table whose `keyColumns` match a staged row are then deleted and the staged rows are
+ * inserted, both within one transaction, so readers either see the old or the new version of the table. If the
+ * incoming rows contain the same key more than once, only the last of them is inserted. The key columns must not be
+ * nullable.
+ */
+inline UpsertResult upsert(
+   hyperapi::Connection& connection, const hyperapi::TableDefinition& targetTable, const std::vector<std::string>& keyColumns,
+   const std::function<void(UpsertInserter&)>& produceRows) {
+   typedef std::chrono::steady_clock Clock;
+   auto secondsSince = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+   UpsertResult result;
+   // The staging table has an additional column with the number of each incoming row.
+   const std::string rowNumberColumn = "Upsert Row Number";
+   hyperapi::TableDefinition stagingTable(
+      hyperapi::TableName(targetTable.getTableName().getName().getUnescaped() + " Upsert Staging"), targetTable.getColumns(),
+      hyperapi::Persistence::Temporary);
+   stagingTable.addColumn(hyperapi::TableDefinition::Column(rowNumberColumn, hyperapi::SqlType::bigInt(), hyperapi::Nullability::NotNullable));
+   const std::string target = targetTable.getTableName().toString();
+   const std::string staging = stagingTable.getTableName().toString();
+
+   // Phase 1: Stream the incoming rows into the staging table.
+   auto start = Clock::now();
+   timePhase(Phase::DDL, [&] { connection.getCatalog().createTable(stagingTable); });
+   detail::StagingTableDropper dropStaging(connection, staging);
+   {
+      PhaseTimer insertTimer(Phase::Insert);
+      hyperapi::Inserter inserter(connection, stagingTable);
+      UpsertInserter upsertInserter(inserter);
+      produceRows(upsertInserter);
+      insertTimer.stop();
+      timePhase(Phase::Execute, [&] { inserter.execute(); });
+   }
+   result.stagedRows = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + staging);
+   result.stageSeconds = secondsSince(start);
+
+   std::string keysMatch, keys, columns;
+   for (const std::string& keyColumn : keyColumns) {
+      keysMatch += (keysMatch.empty() ? "" : " AND ") + ("s." + hyperapi::escapeName(keyColumn)) + " = " + target + "." + hyperapi::escapeName(keyColumn);
+      keys += (keys.empty() ? "" : ", ") + hyperapi::escapeName(keyColumn);
+   }
+   for (const hyperapi::TableDefinition::Column& column : targetTable.getColumns()) {
+      columns += (columns.empty() ? "" : ", ") + column.getName().toString();
+   }
+
+   // Phase 2 and 3: Replace the matching rows within one transaction. The semi-join is evaluated inside Hyper, so the keys
+   // are never materialized on the client.
+   PhaseTimer executeTimer(Phase::Execute);
+   connection.executeCommand("BEGIN TRANSACTION");
+   try {
+      start = Clock::now();
+      result.deletedRows = connection.executeCommand("DELETE FROM " + target + " WHERE EXISTS (SELECT 1 FROM " + staging + " s WHERE " + keysMatch + ")");
+      result.deleteSeconds = secondsSince(start);
+
+      start = Clock::now();
+      // Of the staged rows with the same key, only the one with the highest row number is inserted.
+      result.insertedRows = connection.executeCommand(
+         "INSERT INTO " + target + " SELECT " + columns + " FROM (SELECT *, ROW_NUMBER() OVER (PARTITION BY " + keys + " ORDER BY " +
+         hyperapi::escapeName(rowNumberColumn) + " DESC) AS " + hyperapi::escapeName("Upsert Rank") + " FROM " + staging + ") AS ranked WHERE " +
+         hyperapi::escapeName("Upsert Rank") + " = 1");
+      result.insertSeconds = secondsSince(start);
+
+      start = Clock::now();
+      connection.executeCommand("COMMIT");
+      result.commitSeconds = secondsSince(start);
+   } catch (...) {
+      // A failing ROLLBACK must not hide the exception that aborted the transaction.
+      try {
+         connection.executeCommand("ROLLBACK");
+      } catch (const hyperapi::HyperException&) {
+      }
+      throw;
+   }
+   return result;
+}
+}
+
+#endif
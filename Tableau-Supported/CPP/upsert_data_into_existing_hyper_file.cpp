@@ -0,0 +1,119 @@
+// -----------------------------------------------------------------------------
+//
+// This file is the copyrighted property of Tableau Software and is protected
+// by registered patents and other applicable U.S. and international laws and
+// regulations.
+//
+// You may adapt this file and modify it to fit into your context and use it
+// as a template to start your own projects.
+//
+// -----------------------------------------------------------------------------
+
+/**
+ * \example upsert_data_into_existing_hyper_file.cpp
+ *
+ * An example of how to refresh a table incrementally by upserting a stream of changed and new rows.
+ */
+
+#include "instrumentation.hpp"
+#include "superstore_normalized.hpp"
+#include "upsert.hpp"
+
+#include <cstdlib>
+#include <hyperapi/hyperapi.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Helper function returning the synthetic customer ID for a number
+ */
+static std::string customerId(int64_t number) {
+   return "CU-" + std::to_string(number);
+}
+
+/**
+ * Upserts `deltaRowCount` rows into a "Customer" table that holds `baseRowCount` customers.
+ * The first half of the delta updates existing customers, the second half adds new ones.
+ */
+static void runUpsertDataIntoExistingHyperFile(int64_t baseRowCount, int64_t deltaRowCount) {
+   std::cout << "EXAMPLE - Upsert changed and new rows into an existing Hyper file" << std::endl;
+   const std::string pathToDatabase = "data/superstore_upsert.hyper";
+
+   // Starts the Hyper Process with telemetry enabled to send data to Tableau.
+   // To opt out, simply set telemetry=hyperapi::Telemetry::DoNotSendUsageDataToTableau.
+   {
+      samples::PhaseTimer startupTimer(samples::Phase::Startup);
+      hyperapi::HyperProcess hyper(hyperapi::Telemetry::SendUsageDataToTableau);
+      startupTimer.stop();
+
+      // Creates new Hyper file "superstore_upsert.hyper" with the initial version of the "Customer" table.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase, hyperapi::CreateMode::CreateAndReplace);
+         connectTimer.stop();
+         samples::timePhase(samples::Phase::DDL, [&] { connection.getCatalog().createTable(samples::customerTable); });
+         samples::PhaseTimer insertTimer(samples::Phase::Insert);
+         hyperapi::Inserter inserter(connection, samples::customerTable);
+         for (int64_t i = 0; i < baseRowCount; ++i) {
+            inserter.addRow(customerId(i), "Customer " + std::to_string(i), i % 1000, "Consumer");
+         }
+         insertTimer.stop();
+         samples::timePhase(samples::Phase::Execute, [&] { inserter.execute(); });
+      }
+
+      // Connect to the existing Hyper file "superstore_upsert.hyper" and apply the incremental refresh.
+      {
+         samples::PhaseTimer connectTimer(samples::Phase::Connect);
+         hyperapi::Connection connection(hyper.getEndpoint(), pathToDatabase);
+         connectTimer.stop();
+
+         // The incoming rows are produced on the fly. In production, they would be read from the source system.
+         const int64_t firstDeltaCustomer = baseRowCount - deltaRowCount / 2;
+         samples::UpsertResult result = samples::upsert(connection, samples::customerTable, {"Customer ID"}, [&](samples::UpsertInserter& inserter) {
+            for (int64_t i = firstDeltaCustomer; i < firstDeltaCustomer + deltaRowCount; ++i) {
+               inserter.addRow(customerId(i), "Customer " + std::to_string(i), int64_t{5000}, "Corporate");
+            }
+            // A correction of the first incoming row arrives in the same delta. The last version of a key wins.
+            inserter.addRow(customerId(firstDeltaCustomer), "Customer " + std::to_string(firstDeltaCustomer), int64_t{5000}, "Home Office");
+         });
+
+         std::cout << "Staged " << result.stagedRows << " rows in " << result.stageSeconds << " s." << std::endl;
+         std::cout << "Deleted " << result.deletedRows << " replaced rows in " << result.deleteSeconds << " s." << std::endl;
+         std::cout << "Inserted " << result.insertedRows << " rows in " << result.insertSeconds << " s." << std::endl;
+         std::cout << "Committed the transaction in " << result.commitSeconds << " s." << std::endl;
+
+         int64_t rowCount = connection.executeScalarQuery<int64_t>("SELECT COUNT(*) FROM " + samples::customerTable.getTableName().toString());
+         int64_t refreshedCount = connection.executeScalarQuery<int64_t>(
+            "SELECT COUNT(*) FROM " + samples::customerTable.getTableName().toString() + " WHERE " + hyperapi::escapeName("Segment") + " = " +
+            hyperapi::escapeStringLiteral("Corporate"));
+         std::cout << "The number of rows in table " << samples::customerTable.getTableName() << " is " << rowCount << "." << std::endl;
+         if ((rowCount != firstDeltaCustomer + deltaRowCount) || (refreshedCount != deltaRowCount - 1)) {
+            throw std::runtime_error("The upserted table does not contain the expected rows.");
+         }
+      }
+      std::cout << "The connection to the Hyper file has been closed." << std::endl;
+      samples::timePhase(samples::Phase::Shutdown, [&] { hyper.close(); });
+   }
+   std::cout << "The Hyper Process has been shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   samples::MetricsFormat metricsFormat;
+   std::vector<std::string> arguments = samples::parseMetricsOption(argc, argv, metricsFormat);
+   // Optionally, the number of existing rows and the number of upserted rows can be passed on the command line.
+   int64_t baseRowCount = (arguments.size() > 0) ? std::atoll(arguments[0].c_str()) : 100000;
+   int64_t deltaRowCount = (arguments.size() > 1) ? std::atoll(arguments[1].c_str()) : 20000;
+   try {
+      runUpsertDataIntoExistingHyperFile(baseRowCount, deltaRowCount);
+   } catch (const hyperapi::HyperException& e) {
+      std::cout << e.toString() << std::endl;
+      return 1;
+   } catch (const std::exception& e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+   }
+   samples::reportMetrics(metricsFormat);
+   return 0;
+}